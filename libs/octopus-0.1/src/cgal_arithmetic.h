@@ -0,0 +1,75 @@
+// Copyright (C) 2010 Edgar Gonzàlez i Pellicer <edgar.gip@gmail.com>
+//
+// This file is part of octopus-0.1.
+//
+// octopus is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// octopus is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with octopus; see the file COPYING.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef OCTOPUS_CGAL_ARITHMETIC_H
+#define OCTOPUS_CGAL_ARITHMETIC_H
+
+#include <string>
+
+#include <CGAL/basic.h>
+#include <CGAL/MP_Float.h>
+#ifdef CGAL_USE_GMP
+#include <CGAL/Gmpzf.h>
+#endif
+#include <CGAL/QP_options.h>
+
+#include <octave/oct.h>
+#include <octave/oct-map.h>
+
+// Arithmetic used by the CGAL solvers
+/* - double:   plain double, fast but inexact
+   - filtered: the exact type, with the default pricing of the solver,
+               which already runs in double and is only checked exactly
+               when the filter cannot decide (the previous behaviour)
+*/
+enum cgal_arithmetic {
+  CGAL_ARITHMETIC_DOUBLE,
+  CGAL_ARITHMETIC_FILTERED
+};
+
+// Exact type
+/* Gmpzf is much faster than MP_Float, when GMP is there */
+#ifdef CGAL_USE_GMP
+typedef CGAL::Gmpzf cgal_exact_type;
+#else
+typedef CGAL::MP_Float cgal_exact_type;
+#endif
+
+// Read the arithmetic option (filtered by default)
+static inline cgal_arithmetic get_cgal_arithmetic(const Octave_map& _opts)
+  throw (const char*) {
+  // Not given?
+  if (_opts.seek("arithmetic") == _opts.end())
+    return CGAL_ARITHMETIC_FILTERED;
+
+  // Check it
+  octave_value value = _opts.contents("arithmetic")(0);
+  if (not value.is_string())
+    throw "options.arithmetic should be \"double\" or \"filtered\"";
+
+  // Which one?
+  std::string name = value.string_value();
+  if (name == "double")
+    return CGAL_ARITHMETIC_DOUBLE;
+  else if (name == "filtered")
+    return CGAL_ARITHMETIC_FILTERED;
+  else
+    throw "options.arithmetic should be \"double\" or \"filtered\"";
+}
+
+#endif
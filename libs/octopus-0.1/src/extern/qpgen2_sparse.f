@@ -16,12 +16,20 @@ c  along with this program; if not, write to the Free Software
 c  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
 c  USA.
 c
+c  Modified by Edgar Gonzalez i Pellicer (2010): qpgen2s is qpgen2
+c  with the constraint matrix A given in compressed sparse column
+c  form, so that sparse constraints only cost their non-zero entries.
+c  Bounds on the variables are not columns of A: each variable is
+c  either free or fixed at one of its bounds, and the normal +/- e_j
+c  of an active bound is applied on the fly.
+c
 c  this routine uses the Goldfarb/Idnani algorithm to solve the
 c  following minimization problem:
 c
 c        minimize  -d^T x + 1/2 *  x^T D x
 c        where   A1^T x  = b1
 c                A2^T x >= b2
+c                xl <= x <= xu
 c
 c  the matrix D is assumed to be positive definite.  Especially,
 c  w.l.o.g. D is assumed to be symmetric.
@@ -42,17 +50,21 @@ c         contains on exit the solution to the initial, i.e.,
 c         unconstrained problem
 c  fddmat scalar, the leading dimension of the matrix dmat
 c  n      the dimension of dmat and dvec (int)
-c  amat   nxq matrix, the matrix A from above (dp) [ A=(A1 A2)^T ]
+c  aval   vector, the non-zero entries of the nxq matrix A from above,
+c         column by column (dp) [ A=(A1 A2)^T ]
 c         *** ENTRIES CORRESPONDING TO EQUALITY CONSTRAINTS MAY HAVE
 c             CHANGED SIGNES ON EXIT ***
+c  arow   vector, the row of each entry in aval (int)
+c  acol   (q+1)x1 vector, the entries of column i of A are
+c         aval(acol(i):acol(i+1)-1) (int)
 c  bvec   qx1 vector, the vector of constants b in the constraints (dp)
 c         [ b = (b1^T b2^T)^T ]
 c         *** ENTRIES CORRESPONDING TO EQUALITY CONSTRAINTS MAY HAVE
 c             CHANGED SIGNES ON EXIT ***
-c  fdamat the first dimension of amat as declared in the calling program.
-c         fdamat >= n !!
 c  q      integer, the number of constraints.
 c  meq    integer, the number of equality constraints, 0 <= meq <= q.
+c  xl     nx1 vector, the lower bounds (-Inf if none) (dp)
+c  xu     nx1 vector, the upper bounds (+Inf if none) (dp)
 c  ierr   integer, code for the status of the matrix D:
 c            ierr =  0, we have to decompose D
 c            ierr != 0, D is already decomposed into D=R^TR and we were
@@ -60,10 +72,13 @@ c                       given R^{-1}.
 c
 c  Output parameter:
 c  sol   nx1 the final solution (x in the notation above)
-c  lagr  qx1 the final Lagrange multipliers
+c  lagr  (q+2n)x1 the final Lagrange multipliers, of the columns of A
+c        and then of the lower and upper bounds
 c  crval scalar, the value of the criterion at the minimum
-c  iact  qx1 vector, the constraints which are active in the final
-c        fit (int)
+c  ibnd  nx1 vector, the bound each variable is fixed at in the final
+c        fit: 0 if free, 1 if the lower and 2 if the upper one (int)
+c  iact  rx1 vector, the constraints which are active in the final
+c        fit, numbered as lagr (int)
 c  nact  scalar, the number of constraints active in the final fit (int)
 c  iter  2x1 vector, first component gives the number of "main"
 c        iterations, the second one says how many constraints were
@@ -76,20 +91,31 @@ c                     contains garbage!!
 c
 c  Working space:
 c  work  vector with length at least 2*n+r*(r+5)/2 + 2*q +1
-c        where r=min(n,q)
+c        where r=min(n,q+nb), and nb is the number of finite bounds
 c
-      subroutine qpgen2(dmat, dvec, fddmat, n, sol, lagr, crval, amat,
-     *     bvec, fdamat, q, meq, iact, nact, iter, work, ierr)
+      subroutine qpgen2s(dmat, dvec, fddmat, n, sol, lagr, crval, aval,
+     *     arow, acol, bvec, q, meq, xl, xu, ibnd, iact, nact, iter,
+     *     work, ierr)
       implicit none
       integer n, i, j, l, l1,
      *     info, q, iact(*), iter(*), it1,
      *     ierr, nact, iwzv, iwrv, iwrm, iwsv, iwuv, nvl,
-     *     r, fdamat, iwnbv, meq, fddmat
+     *     r, iwnbv, meq, fddmat, arow(*), acol(*), ibnd(*), nb
       double precision dmat(fddmat,*), dvec(*), lagr(*), sol(*), bvec(*)
-     $     ,work(*), temp, sum, t1, tt, gc, gs, crval,nu, amat(fdamat,*)
-     $     , vsmall, tmpa, tmpb
+     $     ,work(*), temp, sum, t1, tt, gc, gs, crval,nu, aval(*)
+     $     , vsmall, tmpa, tmpb, xl(*), xu(*), slv
       logical t1inf, t2min
-      r = min(n,q)
+c
+c count the finite bounds (x-x is only 0 for finite x), and start with
+c every variable free
+c
+      nb = 0
+      do 5 j=1,n
+         ibnd(j) = 0
+         if (xl(j)-xl(j) .EQ. 0.d0) nb = nb+1
+         if (xu(j)-xu(j) .EQ. 0.d0) nb = nb+1
+ 5    continue
+      r = min(n,q+nb)
       l = 2*n + (r*(r+5))/2 + 2*q + 1
 c
 c     code gleaned from Powell's ZQPCVX routine to determine a small
@@ -112,10 +138,12 @@ c
       do 11 i=n+1,l
          work(i) = 0.d0
  11   continue
-      do 12 i=1,q
+      do 12 i=1,r
          iact(i) = 0
-         lagr(i) = 0.d0
  12   continue
+      do 13 i=1,q+2*n
+         lagr(i) = 0.d0
+ 13   continue
 c
 c get the initial solution
 c
@@ -176,8 +204,8 @@ c calculate the norm of each column of the A matrix
 c
       do 51 i=1,q
          sum = 0.d0
-         do 52 j=1,n
-            sum = sum + amat(j,i)*amat(j,i)
+         do 52 j=acol(i),acol(i+1)-1
+            sum = sum + aval(j)*aval(j)
  52      continue
          work(iwnbv+i) = sqrt(sum)
  51   continue
@@ -198,8 +226,8 @@ c
       do 60 i=1,q
          l = l+1
          sum = -bvec(i)
-         do 61 j = 1,n
-            sum = sum + amat(j,i)*sol(j)
+         do 61 j = acol(i),acol(i+1)-1
+            sum = sum + aval(j)*sol(arow(j))
  61      continue
          if ( abs(sum) .LT. vsmall ) then
             sum = 0.0d0
@@ -209,8 +237,8 @@ c
          else
             work(l) = -abs(sum)
             if (sum .GT. 0.d0) then
-               do 62 j=1,n
-                  amat(j,i) = -amat(j,i)
+               do 62 j=acol(i),acol(i+1)-1
+                  aval(j) = -aval(j)
  62            continue
                bvec(i) = -bvec(i)
             endif
@@ -221,7 +249,7 @@ c as safeguard against rounding errors set already active constraints
 c explicitly to zero
 c
       do 70 i=1,nact
-         work(iwsv+iact(i)) = 0.d0
+         if (iact(i) .LE. q) work(iwsv+iact(i)) = 0.d0
  70   continue
 c
 c we weight each violation by the number of non-zero elements in the
@@ -242,6 +270,27 @@ c            nvl = i
 c            goto 72
 c         endif
  71   continue
+      if (nvl .NE. 0) slv = work(iwsv+nvl)
+c
+c the bounds of the free variables, whose normals have norm one
+c
+      do 74 j=1,n
+         if (ibnd(j) .NE. 0) goto 74
+         sum = sol(j) - xl(j)
+         if (abs(sum) .LT. vsmall) sum = 0.d0
+         if (sum .LT. temp) then
+            nvl  = q+j
+            temp = sum
+            slv  = sum
+         endif
+         sum = xu(j) - sol(j)
+         if (abs(sum) .LT. vsmall) sum = 0.d0
+         if (sum .LT. temp) then
+            nvl  = q+n+j
+            temp = sum
+            slv  = sum
+         endif
+ 74   continue
  72   if (nvl .EQ. 0) then
          do 73 i=1,nact
             lagr(iact(i))=work(iwuv+i)
@@ -254,13 +303,23 @@ c constraint. J is stored in dmat in this implementation!!
 c if we drop a constraint, we have to jump back here.
 c
  55   continue
-      do 80 i=1,n
-         sum = 0.d0
-         do 81 j=1,n
-            sum = sum + dmat(j,i)*amat(j,nvl)
- 81      continue
-         work(i) = sum
- 80   continue
+      if (nvl .GT. q+n) then
+         do 82 i=1,n
+            work(i) = -dmat(nvl-q-n,i)
+ 82      continue
+      else if (nvl .GT. q) then
+         do 83 i=1,n
+            work(i) = dmat(nvl-q,i)
+ 83      continue
+      else
+         do 80 i=1,n
+            sum = 0.d0
+            do 81 j=acol(nvl),acol(nvl+1)-1
+               sum = sum + dmat(arow(j),i)*aval(j)
+ 81         continue
+            work(i) = sum
+ 80      continue
+      endif
 c
 c Now calculate z = J_2 d_2
 c
@@ -346,11 +405,17 @@ c compute full step length t2, minimum step in primal space such that
 c the constraint becomes feasible.
 c keep sum (which is z^Tn^+) to update crval below!
 c
-         sum = 0.d0
-         do 120 i = 1,n
-            sum = sum + work(iwzv+i)*amat(i,nvl)
- 120     continue
-         tt = -work(iwsv+nvl)/sum
+         if (nvl .GT. q+n) then
+            sum = -work(iwzv+nvl-q-n)
+         else if (nvl .GT. q) then
+            sum = work(iwzv+nvl-q)
+         else
+            sum = 0.d0
+            do 120 i = acol(nvl),acol(nvl+1)-1
+               sum = sum + work(iwzv+arow(i))*aval(i)
+ 120        continue
+         endif
+         tt = -slv/sum
          t2min = .TRUE.
          if (.NOT. t1inf) then
             if (t1 .LT. tt) then
@@ -380,6 +445,11 @@ c constraints and update J and R
 c
             nact = nact + 1
             iact(nact) = nvl
+            if (nvl .GT. q+n) then
+               ibnd(nvl-q-n) = 2
+            else if (nvl .GT. q) then
+               ibnd(nvl-q) = 1
+            endif
 c
 c to update R we have to put the first nact-1 components of the d vector
 c into column (nact) of R
@@ -454,19 +524,25 @@ c then we continue at step 2(a) (marked by label 55)
 c but since the fit changed, we have to recalculate now "how much"
 c the fit violates the chosen constraint now.
 c
-            sum = -bvec(nvl)
-            do 190 j = 1,n
-               sum = sum + sol(j)*amat(j,nvl)
- 190        continue
-            if( nvl .GT. meq ) then
-               work(iwsv+nvl) = sum
+            if (nvl .GT. q+n) then
+               slv = xu(nvl-q-n) - sol(nvl-q-n)
+            else if (nvl .GT. q) then
+               slv = sol(nvl-q) - xl(nvl-q)
             else
-               work(iwsv+nvl) = -abs(sum)
-               if( sum .GT. 0.d0) then
-                  do 191 j=1,n
-                     amat(j,nvl) = -amat(j,nvl)
- 191              continue
-                  bvec(nvl) = -bvec(nvl)
+               sum = -bvec(nvl)
+               do 190 j = acol(nvl),acol(nvl+1)-1
+                  sum = sum + sol(arow(j))*aval(j)
+ 190           continue
+               if( nvl .GT. meq ) then
+                  slv = sum
+               else
+                  slv = -abs(sum)
+                  if( sum .GT. 0.d0) then
+                     do 191 j=acol(nvl),acol(nvl+1)-1
+                        aval(j) = -aval(j)
+ 191                 continue
+                     bvec(nvl) = -bvec(nvl)
+                  endif
                endif
             endif
             goto 700
@@ -474,9 +550,14 @@ c
       endif
       goto 50
 c
-c Drop constraint it1
+c Drop constraint it1, freeing its variable if it is a bound
 c
  700  continue
+      if (iact(it1) .GT. q+n) then
+         ibnd(iact(it1)-q-n) = 0
+      else if (iact(it1) .GT. q) then
+         ibnd(iact(it1)-q) = 0
+      endif
 c
 c if it1 = nact it is only necessary to update the vector u and nact
 c
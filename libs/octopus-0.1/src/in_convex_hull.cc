@@ -16,18 +16,28 @@
 // along with octopus; see the file COPYING.  If not, see
 // <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <cmath>
 #include <exception>
 #include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <boost/config.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 
-#include <CGAL/MP_Float.h>
 #include <CGAL/QP_models.h>
 #include <CGAL/QP_functions.h>
 
 #include <octave/oct.h>
 
+#include "cgal_arithmetic.h"
+
 // Homogeneous vector iterator
 struct homogeneous_vector_iterator {
 private:
@@ -260,10 +270,37 @@ namespace std {
 }
 
 
+// Bounding box of the columns of a matrix
+static void bounding_box(const Matrix& _m,
+                         std::vector<double>& _min,
+                         std::vector<double>& _max) {
+  // Sizes
+  octave_idx_type n_dims = _m.rows();
+  octave_idx_type n_cols = _m.columns();
+
+  // Start empty
+  _min.assign(n_dims, +INFINITY);
+  _max.assign(n_dims, -INFINITY);
+
+  // Widen it
+  const double* data = _m.data();
+  for (octave_idx_type c = 0; c < n_cols; ++c, data += n_dims)
+    for (octave_idx_type d = 0; d < n_dims; ++d) {
+      _min[d] = std::min(_min[d], data[d]);
+      _max[d] = std::max(_max[d], data[d]);
+    }
+}
+
 // In convex hull
+/* Targets outside the bounding box of the set are discarded without
+   solving their program. The rest are solved in parallel; CGAL objects
+   are private to each iteration, and Octave ones are only read
+*/
+template <typename ET>
 static void in_convex_hull(const Matrix& _set,
                            const Matrix& _targets,
-                           boolMatrix& _outcome) {
+                           const CGAL::Quadratic_program_options& _options,
+                           int _n_workers, std::vector<char>& _outcome) {
   // Relation type ("=")
   typedef CGAL::Const_oneset_iterator<CGAL::Comparison_result> R_it;
 
@@ -280,27 +317,58 @@ static void in_convex_hull(const Matrix& _set,
   octave_idx_type n_dims    = _set.rows(); // = _targets.rows();
   octave_idx_type n_targets = _targets.columns();
 
+  // Bounding box
+  std::vector<double> box_min, box_max;
+  bounding_box(_set, box_min, box_max);
+
   // Set iterator
   homogeneous_matrix_iterator set_it(_set);
 
+  // First error found
+  std::string error_message;
+
   // For each target
+#pragma omp parallel for num_threads(_n_workers) schedule(dynamic)
   for (octave_idx_type i = 0; i < n_targets; ++i) {
-    // Target iterator
-    homogeneous_vector_iterator target_it(_targets, i);
-
-    // Create a program
-    Program lp(n_set,      // Number of variables
-               n_dims + 1, // Number of constraints
-               set_it, target_it, R_it(CGAL::EQUAL), C_it(0.0));
-
-    // Solve it
-    CGAL::MP_Float dummy;
-    CGAL::Quadratic_program_solution<CGAL::MP_Float> solution =
-      CGAL::solve_nonnegative_linear_program(lp, dummy);
-
-    // Is it feasible?
-    _outcome(i) = not solution.is_infeasible();
+    // Within the bounding box?
+    const double* target = _targets.data() + i * n_dims;
+    bool in_box = true;
+    for (octave_idx_type d = 0; in_box and d < n_dims; ++d)
+      in_box = box_min[d] <= target[d] and target[d] <= box_max[d];
+
+    // Outside
+    if (not in_box) {
+      _outcome[i] = false;
+      continue;
+    }
+
+    try {
+      // Target iterator
+      homogeneous_vector_iterator target_it(_targets, i);
+
+      // Create a program
+      Program lp(n_set,      // Number of variables
+                 n_dims + 1, // Number of constraints
+                 set_it, target_it, R_it(CGAL::EQUAL), C_it(0.0));
+
+      // Solve it
+      CGAL::Quadratic_program_solution<ET> solution =
+        CGAL::solve_nonnegative_linear_program(lp, ET(), _options);
+
+      // Is it feasible?
+      _outcome[i] = not solution.is_infeasible();
+    }
+    // Exceptions cannot leave the parallel region
+    catch (std::exception& _excep) {
+#pragma omp critical
+      if (error_message.empty())
+        error_message = _excep.what();
+    }
   }
+
+  // Was there an error?
+  if (not error_message.empty())
+    throw std::runtime_error(error_message);
 }
 
 
@@ -308,16 +376,23 @@ static void in_convex_hull(const Matrix& _set,
 DEFUN_DLD(in_convex_hull, _args, _nargout,
           "-*- texinfo -*-\n\
 @deftypefn {Loadable Function} {[ @var{inside} ] =}\
- in_convex_hull(@var{set}, @var{target})\n      \
+ in_convex_hull(@var{set}, @var{target}, @var{options})\n      \
 \n\
 Determine if target points are inside the convex hull of set\n\
+\n\
+Each column of @var{target} is a query point, and they are all tested\n\
+against the same @var{set} in parallel. The optional @var{options} struct\n\
+may set the number of @var{workers} threads and the @var{arithmetic}:\n\
+@code{\"double\"} (fast, but inexact) or @code{\"filtered\"} (exact,\n\
+checked exactly only when the double filter cannot decide; the\n\
+default), as in @code{quadprog_cgal}\n\
 @end deftypefn") {
   // Output
   octave_value_list output;
 
   try {
     // Check the number of parameters
-    if (_args.length() != 2 or _nargout > 1)
+    if (_args.length() < 2 or _args.length() > 3 or _nargout > 1)
       throw (const char*)0;
 
     // Check set is a real matrix
@@ -338,11 +413,46 @@ Determine if target points are inside the convex hull of set\n\
     if (set.rows() != target.rows())
       throw "set and target must have the same number of columns";
 
-    // Output
-    boolMatrix outcome(1, target.columns());
+    // Options
+    Octave_map opts;
+    if (_args.length() > 2) {
+      if (not _args(2).is_map())
+        throw "options must be a struct";
+      opts = _args(2).map_value();
+    }
+
+    // Arithmetic
+    cgal_arithmetic arithmetic = get_cgal_arithmetic(opts);
+
+    // Number of workers
+    int n_workers = 1;
+#ifdef _OPENMP
+    n_workers = omp_get_max_threads();
+#endif
+    if (opts.seek("workers") != opts.end()) {
+      n_workers = opts.contents("workers")(0).int_value();
+      if (n_workers < 1)
+        throw "options.workers should be a positive integer";
+    }
 
     // Call
-    in_convex_hull(set, target, outcome);
+    std::vector<char> inside(target.columns());
+    CGAL::Quadratic_program_options options; // Default pricing
+    switch (arithmetic) {
+    case CGAL_ARITHMETIC_DOUBLE:
+      in_convex_hull<double>(set, target, options, n_workers, inside);
+      break;
+
+    default:
+      in_convex_hull<cgal_exact_type>(set, target, options, n_workers,
+                                      inside);
+      break;
+    }
+
+    // Output
+    boolMatrix outcome(1, target.columns());
+    for (octave_idx_type i = 0; i < target.columns(); ++i)
+      outcome(i) = inside[i];
 
     // Return
     output.resize(1);
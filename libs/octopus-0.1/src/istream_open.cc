@@ -107,12 +107,10 @@ Read a line from a istream\n\
       throw (const char*)0;
 
     // Get istream
-    if (args(0).type_id() != istream_value::static_type_id())
-      throw "istream should be a istream";
-
-    // Cast
-    istream_value* is = static_cast<istream_value*>(args(0).internal_rep());
+    istream_value* is = istream_value::cast(args(0));
     if (not is)
+      throw "istream should be a istream";
+    if (not is->is_defined())
       throw "istream cannot be null";
 
     // Read a line
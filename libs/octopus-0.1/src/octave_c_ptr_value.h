@@ -60,6 +60,15 @@ public:
     return *data_;
   }
 
+  /// Cast a value
+  /** Null if the value does not hold one of these. Checked on the
+      representation itself, as the type is not registered, and so its
+      type id is the same as that of any other unregistered type
+  */
+  static octave_c_pointer_value* cast(const octave_value& _value) {
+    return dynamic_cast<octave_c_pointer_value*>(_value.internal_rep());
+  }
+
   /// Clone
   virtual octave_c_pointer_value* clone() const {
     return new octave_c_pointer_value(*this);
@@ -16,12 +16,17 @@
 // along with octopus; see the file COPYING.  If not, see
 // <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <exception>
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
 
 #include <octave/oct.h>
 
@@ -33,15 +38,15 @@
 using namespace std;
 
 
-/*********************/
-/* Trimmed substring */
-/*********************/
-
-static string trimmed_substr(const string& _string,
-                             string::size_type _start, string::size_type _end) {
-  // Result
-  string result;
+/*****************/
+/* Trimmed field */
+/*****************/
 
+// Get the trimmed field between _start and _end into _field
+/* _field is reused from line to line, so it only allocates when it grows */
+static void trimmed_field(const string& _string,
+                          string::size_type _start, string::size_type _end,
+                          string& _field) {
   // Bound
   if (_string.size() < _end)
     _end = _string.size();
@@ -51,13 +56,239 @@ static string trimmed_substr(const string& _string,
     ++_start;
 
   // No space
-  while (_start < _end and not isspace(_string[_start]))
-    result += _string[_start++];
+  string::size_type stop = _start;
+  while (stop < _end and not isspace(_string[stop]))
+    ++stop;
+
+  // Set
+  _field.assign(_string, _start, stop - _start);
+}
+
+// Does the line start with a section name?
+static bool is_section(const string& _line, const char* _section) {
+  return _line.compare(0, char_traits<char>::length(_section),
+                       _section) == 0;
+}
+
+
+/************/
+/* Triplets */
+/************/
+
+// Triplet
+struct qps_triplet {
+  // Row
+  octave_idx_type row;
+
+  // Column
+  octave_idx_type col;
+
+  // Value
+  double value;
+
+  // Constructor
+  qps_triplet(octave_idx_type _row, octave_idx_type _col, double _value) :
+    row(_row), col(_col), value(_value) {
+  }
+};
 
-  // Return
+// Column-major order
+static bool triplet_less(const qps_triplet& _a, const qps_triplet& _b) {
+  return _a.col < _b.col or (_a.col == _b.col and _a.row < _b.row);
+}
+
+// Build a sparse matrix from triplets
+/* When an entry is repeated, the last one read is kept, as it happened
+   when the entries were assigned to a dense matrix
+*/
+static SparseMatrix build_sparse(octave_idx_type _n_rows,
+                                 octave_idx_type _n_cols,
+                                 vector<qps_triplet>& _triplets) {
+  // Sort them, keeping the reading order of repeated entries
+  stable_sort(_triplets.begin(), _triplets.end(), triplet_less);
+
+  // Count the distinct entries
+  octave_idx_type n_nz = 0;
+  for (size_t t = 0; t < _triplets.size(); ++t)
+    if (t + 1 == _triplets.size() or
+        triplet_less(_triplets[t], _triplets[t + 1]))
+      ++n_nz;
+
+  // Matrix
+  SparseMatrix result(_n_rows, _n_cols, n_nz);
+  octave_idx_type* cidx = result.cidx();
+  octave_idx_type* ridx = result.ridx();
+  double*          data = result.data();
+
+  // Fill it
+  octave_idx_type nz = 0;
+  cidx[0] = 0;
+  octave_idx_type col = 0;
+  for (size_t t = 0; t < _triplets.size(); ++t) {
+    // Repeated, and not the last one?
+    if (t + 1 < _triplets.size() and
+        not triplet_less(_triplets[t], _triplets[t + 1]))
+      continue;
+
+    // Close the previous columns
+    while (col < _triplets[t].col)
+      cidx[++col] = nz;
+
+    // Add it
+    ridx[nz] = _triplets[t].row;
+    data[nz] = _triplets[t].value;
+    ++nz;
+  }
+
+  // Close the remaining columns
+  while (col < _n_cols)
+    cidx[++col] = nz;
+
+  // Return it
   return result;
 }
 
+// Copy a vector into a column vector
+static ColumnVector to_column(const vector<double>& _values) {
+  ColumnVector result(_values.size());
+  copy(_values.begin(), _values.end(), result.fortran_vec());
+  return result;
+}
+
+
+/*************/
+/* QPS model */
+/*************/
+
+// Row kind and index
+typedef pair<char, int> qps_row;
+
+// Row map
+typedef boost::unordered_map<string, qps_row> qps_row_map;
+
+// Column map
+typedef boost::unordered_map<string, int> qps_col_map;
+
+// Model being read
+struct qps_model {
+  // Rows
+  qps_row_map rows;
+
+  // Columns
+  qps_col_map cols;
+
+  // Number of equalities
+  int n_eq;
+
+  // Number of inequalities
+  int n_ineq;
+
+  // Number of variables
+  int n_vars;
+
+  // Constraint entries
+  vector<qps_triplet> Aeq, Aineq;
+
+  // Hessian entries
+  vector<qps_triplet> H;
+
+  // Linear term
+  vector<double> f;
+
+  // Constant term
+  double g;
+
+  // Right hand sides
+  vector<double> beq, bineq;
+
+  // Bounds
+  vector<double> lb, ub;
+
+  // Constructor
+  qps_model() :
+    n_eq(0), n_ineq(0), n_vars(0), g(0.0) {
+  }
+
+  // Find a row
+  const qps_row& row(const string& _name, const char* _error) const {
+    qps_row_map::const_iterator it = rows.find(_name);
+    if (it == rows.end())
+      throw _error;
+    return it->second;
+  }
+
+  // Find a column
+  int col(const string& _name, const char* _error) const {
+    qps_col_map::const_iterator it = cols.find(_name);
+    if (it == cols.end())
+      throw _error;
+    return it->second;
+  }
+
+  // Find or add a column
+  int add_col(const string& _name) {
+    pair<qps_col_map::iterator, bool> ins =
+      cols.insert(make_pair(_name, n_vars));
+    if (ins.second) {
+      ++n_vars;
+      f .push_back(0.0);
+      lb.push_back(0.0);
+      ub.push_back(+INFINITY);
+    }
+    return ins.first->second;
+  }
+
+  // Set a COLUMNS entry
+  void set_entry(const qps_row& _row, int _col, double _value) {
+    switch (_row.first) {
+    case 'N':
+      if (_row.second == 1)
+        f[_col] = _value;
+      break;
+
+    case 'E':
+      Aeq.push_back(qps_triplet(_row.second, _col, _value));
+      break;
+
+    case 'L':
+      Aineq.push_back(qps_triplet(_row.second, _col, _value));
+      break;
+
+    case 'G':
+      Aineq.push_back(qps_triplet(_row.second, _col, -_value));
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  // Set an RHS entry
+  void set_rhs(const qps_row& _row, double _value) {
+    switch (_row.first) {
+    case 'N':
+      if (_row.second == 1)
+        g = -_value;
+      break;
+
+    case 'E':
+      beq[_row.second] = _value;
+      break;
+
+    case 'L':
+      bineq[_row.second] = _value;
+      break;
+
+    case 'G':
+      bineq[_row.second] = -_value;
+      break;
+
+    default:
+      break;
+    }
+  }
+};
+
 
 /****************************************************************/
 /* Parse a QPS file                                             */
@@ -73,6 +304,8 @@ DEFUN_DLD(parse_qps, args, nargout,
  @var{Aeq}, @var{beq}, @var{lb}, @var{ub} ] =} parse_qps(@var{file}\n\
 \n\
 Parse a QPS file\n\
+\n\
+@var{H}, @var{Aineq} and @var{Aeq} are returned as sparse matrices\n\
 @end deftypefn") {
   // Output
   octave_value_list output;
@@ -92,6 +325,12 @@ Parse a QPS file\n\
     if (not ifs.is_open())
       throw "Cannot open file";
 
+    // Model
+    qps_model model;
+
+    // Fields
+    string field1, field2, field3, field4, field5;
+
     /* NAME *********************************************************/
 
     // Get NAME line
@@ -100,9 +339,8 @@ Parse a QPS file\n\
       throw "Cannot read NAME section";
 
     // Indeed NAME?
-    if (line.substr(0, 4) != "NAME")
+    if (not is_section(line, "NAME"))
       throw "Did not find NAME section";
-    // string name = trimmed_substr(line, 14, 22);
 
     /* ROWS *********************************************************/
 
@@ -111,22 +349,21 @@ Parse a QPS file\n\
       throw "Cannot read ROWS section";
 
     // Indeed ROWS?
-    if (line.substr(0, 4) != "ROWS")
+    if (not is_section(line, "ROWS"))
       throw "Did not find ROWS section";
 
-    // Row name mapping
+    // Objective row found?
     bool first_N = true;
-    int n_eq     = 0;
-    int n_ineq   = 0;
-    map< string, pair<char, int> > row_map;
 
     // Loop until COLUMNS section
     if (not getline(ifs, line))
       throw "Cannot read ROWS contents";
-    while (line.substr(0, 7) != "COLUMNS") {
+    while (not is_section(line, "COLUMNS")) {
       // Restriction char and name
-      string row_restriction = trimmed_substr(line, 1,  3);
-      string row_name        = trimmed_substr(line, 4, 12);
+      string& row_restriction = field1;
+      string& row_name        = field2;
+      trimmed_field(line, 1,  3, row_restriction);
+      trimmed_field(line, 4, 12, row_name);
 
       // OK?
       if (row_restriction != "N" && row_restriction != "G" &&
@@ -135,27 +372,23 @@ Parse a QPS file\n\
       if (row_name.empty())
         throw "Wrong ROWS entry name";
 
-      // Already there?
-      if (row_map.find(row_name) != row_map.end())
-        throw "Repeated ROWS entry name";
-
-      // Insert
-      if (row_restriction[0] == 'N') {
-        if (first_N) {
-          row_map.insert(make_pair(row_name, make_pair('N', 1)));
-          first_N = false;
-        }
-        else {
-          row_map.insert(make_pair(row_name, make_pair('N', 0)));
-        }
+      // Kind and index
+      qps_row row(row_restriction[0], 0);
+      if (row.first == 'N') {
+        row.second = first_N ? 1 : 0;
+        first_N    = false;
       }
-      else if (row_restriction[0] == 'E') {
-        row_map.insert(make_pair(row_name, make_pair('E', n_eq++)));
+      else if (row.first == 'E') {
+        row.second = model.n_eq++;
       }
-      else { // row_restriction[0] == 'L' || row_restriction[0] == 'G'
-        row_map.insert(make_pair(row_name, make_pair(row_restriction[0], n_ineq++)));
+      else { // row.first == 'L' || row.first == 'G'
+        row.second = model.n_ineq++;
       }
 
+      // Insert it
+      if (not model.rows.insert(make_pair(row_name, row)).second)
+        throw "Repeated ROWS entry name";
+
       // Next line
       if (not getline(ifs, line))
         throw "Cannot read ROWS contents";
@@ -163,70 +396,32 @@ Parse a QPS file\n\
 
     /* COLUMNS ******************************************************/
 
-    // Create Aeq and Aineq matrices
-    Matrix       Aeq  (n_eq,   0);
-    Matrix       Aineq(n_ineq, 0);
-    ColumnVector f    (0);
-
-    // Column names
-    int n_vars = 0;
-    map<string, int> col_map;
-
     // Loop until RHS section
     if (not getline(ifs, line))
       throw "Cannot read COLUMNS contents";
-    while (line.substr(0, 3) != "RHS") {
+    while (not is_section(line, "RHS")) {
       // Split
-      string col_name   = trimmed_substr(line,  4, 12);
-      string row1_name  = trimmed_substr(line, 14, 22);
-      string row1_value = trimmed_substr(line, 24, 36);
-      string row2_name  = trimmed_substr(line, 39, 47);
-      string row2_value = trimmed_substr(line, 49, 61);
+      string& col_name   = field1;
+      string& row1_name  = field2;
+      string& row1_value = field3;
+      string& row2_name  = field4;
+      string& row2_value = field5;
+      trimmed_field(line,  4, 12, col_name);
+      trimmed_field(line, 14, 22, row1_name);
+      trimmed_field(line, 24, 36, row1_value);
+      trimmed_field(line, 39, 47, row2_name);
+      trimmed_field(line, 49, 61, row2_value);
 
       // Check
       if (col_name.empty() or row1_name.empty() or row1_value.empty())
         throw "Wrong COLUMNS entry";
 
       // Index the name
-      map<string, int>::iterator it = col_map.find(col_name);
-      if (it == col_map.end()) {
-        it = col_map.insert(make_pair(col_name, n_vars++)).first;
-        Aeq  .RESIZE_AND_FILL(n_eq,   n_vars, 0.0);
-        Aineq.RESIZE_AND_FILL(n_ineq, n_vars, 0.0);
-        f    .RESIZE_AND_FILL(        n_vars, 0.0);
-      }
-      int col_idx = it->second;
+      int col_idx = model.add_col(col_name);
 
       // First row
-      map< string, pair<char, int> >::iterator rit = row_map.find(row1_name);
-      if (rit == row_map.end())
-        throw "Wrong row name in COLUMNS entry";
-
-      // Convert the value
-      double row_double = atof(row1_value.c_str());
-
-      // Type
-      switch (rit->second.first) {
-      case 'N':
-        if (rit->second.second == 1)
-          f(col_idx) = row_double;
-        break;
-
-      case 'E':
-        Aeq(rit->second.second, col_idx) = row_double;
-        break;
-
-      case 'L':
-        Aineq(rit->second.second, col_idx) = row_double;
-        break;
-
-      case 'G':
-        Aineq(rit->second.second, col_idx) = -row_double;
-        break;
-
-      default:
-        break;
-      }
+      model.set_entry(model.row(row1_name, "Wrong row name in COLUMNS entry"),
+                      col_idx, atof(row1_value.c_str()));
 
       // More values?
       if (not row2_name.empty()) {
@@ -235,34 +430,9 @@ Parse a QPS file\n\
           throw "Wrong COLUMNS entry";
 
         // Second row
-        if ((rit = row_map.find(row2_name)) == row_map.end())
-          throw "Wrong row name in COLUMNS entry";
-
-        // Convert the value
-        row_double = atof(row2_value.c_str());
-
-        // Type
-        switch (rit->second.first) {
-        case 'N':
-          if (rit->second.second == 1)
-            f(col_idx) = row_double;
-          break;
-
-        case 'E':
-          Aeq(rit->second.second, col_idx) = row_double;
-          break;
-
-        case 'L':
-          Aineq(rit->second.second, col_idx) = row_double;
-          break;
-
-        case 'G':
-          Aineq(rit->second.second, col_idx) = -row_double;
-          break;
-
-        default:
-          break;
-        }
+        model.set_entry(model.row(row2_name,
+                                  "Wrong row name in COLUMNS entry"),
+                        col_idx, atof(row2_value.c_str()));
       }
 
       // Next line
@@ -272,57 +442,32 @@ Parse a QPS file\n\
 
     /* RHS **********************************************************/
 
-    // Create beq and bineq vectors
-    ColumnVector beq  (n_eq,   0.0);
-    ColumnVector bineq(n_ineq, 0.0);
-    double g = 0.0;
+    // Right hand sides
+    model.beq  .assign(model.n_eq,   0.0);
+    model.bineq.assign(model.n_ineq, 0.0);
 
     // Loop until RANGES, BOUNDS, QUADOBJ or ENDATA section
     if (not getline(ifs, line))
       throw "Cannot read RHS contents";
-    while (line.substr(0, 6) != "RANGES" and
-           line.substr(0, 6) != "BOUNDS" and
-           line.substr(0, 7) != "QUADOBJ" and
-           line.substr(0, 6) != "ENDATA") {
+    while (not is_section(line, "RANGES") and
+           not is_section(line, "BOUNDS") and
+           not is_section(line, "QUADOBJ") and
+           not is_section(line, "ENDATA")) {
       // Split
-      // string rhs_name   = trimmed_substr(line,  4, 12);
-      string row1_name  = trimmed_substr(line, 14, 22);
-      string row1_value = trimmed_substr(line, 24, 36);
-      string row2_name  = trimmed_substr(line, 39, 47);
-      string row2_value = trimmed_substr(line, 49, 61);
+      string& row1_name  = field2;
+      string& row1_value = field3;
+      string& row2_name  = field4;
+      string& row2_value = field5;
+      trimmed_field(line, 14, 22, row1_name);
+      trimmed_field(line, 24, 36, row1_value);
+      trimmed_field(line, 39, 47, row2_name);
+      trimmed_field(line, 49, 61, row2_value);
 
       // Ignore the name...
 
       // First row
-      map< string, pair<char, int> >::iterator rit = row_map.find(row1_name);
-      if (rit == row_map.end())
-        throw "Wrong row name in RHS entry";
-
-      // Convert the value
-      double row_double = atof(row1_value.c_str());
-
-      // Type
-      switch (rit->second.first) {
-      case 'N':
-        if (rit->second.second == 1)
-          g = -row_double;
-        break;
-
-      case 'E':
-        beq(rit->second.second) = row_double;
-        break;
-
-      case 'L':
-        bineq(rit->second.second) = row_double;
-        break;
-
-      case 'G':
-        bineq(rit->second.second) = -row_double;
-        break;
-
-      default:
-        break;
-      }
+      model.set_rhs(model.row(row1_name, "Wrong row name in RHS entry"),
+                    atof(row1_value.c_str()));
 
       // More values?
       if (not row2_name.empty()) {
@@ -331,34 +476,8 @@ Parse a QPS file\n\
           throw "Wrong RHS entry";
 
         // Second row
-        if ((rit = row_map.find(row2_name)) == row_map.end())
-          throw "Wrong row name in RHS entry";
-
-        // Convert the value
-        row_double = atof(row2_value.c_str());
-
-        // Type
-        switch (rit->second.first) {
-        case 'N':
-          if (rit->second.second == 1)
-            g = -row_double;
-          break;
-
-        case 'E':
-          beq(rit->second.second) = row_double;
-          break;
-
-        case 'L':
-          bineq(rit->second.second) = row_double;
-          break;
-
-        case 'G':
-          bineq(rit->second.second) = -row_double;
-          break;
-
-        default:
-          break;
-        }
+        model.set_rhs(model.row(row2_name, "Wrong row name in RHS entry"),
+                      atof(row2_value.c_str()));
       }
 
       // Next line
@@ -368,72 +487,82 @@ Parse a QPS file\n\
 
     /* RANGES *******************************************************/
 
+    // Inequalities added by RANGES entries, for each original one
+    vector< vector<int> > ranged(model.n_ineq);
+
     // Any RANGES?
-    if (line.substr(0, 6) == "RANGES") {
+    if (is_section(line, "RANGES")) {
       // Loop until BOUNDS, QUADOBJ or ENDATA section
       if (not getline(ifs, line))
         throw "Cannot read RANGES contents";
-      while (line.substr(0, 6) != "BOUNDS" and
-             line.substr(0, 7) != "QUADOBJ" and
-             line.substr(0, 6) != "ENDATA") {
+      while (not is_section(line, "BOUNDS") and
+             not is_section(line, "QUADOBJ") and
+             not is_section(line, "ENDATA")) {
         // Split
-        // string range_name = trimmed_substr(line,  4, 12);
-        string row_name    = trimmed_substr(line, 14, 22);
-        string range_value = trimmed_substr(line, 24, 36);
+        string& row_name    = field2;
+        string& range_value = field3;
+        trimmed_field(line, 14, 22, row_name);
+        trimmed_field(line, 24, 36, range_value);
 
         // Ignore the name
 
         // Find row
-        map< string, pair<char, int> >::iterator rit = row_map.find(row_name);
-        if (rit == row_map.end())
-          throw "Wrong row name in RANGES entry";
+        const qps_row& row = model.row(row_name,
+                                       "Wrong row name in RANGES entry");
 
-        // Check it is not an E constraint
-        if (rit->second.first == 'E')
+        // Check it is an inequality
+        if (row.first == 'E')
           throw "RANGES entries for E constraints is not supported";
+        if (row.first == 'N')
+          throw "Wrong row name in RANGES entry";
 
         // Convert the value
-        double range_double = abs(atof(range_value.c_str()));
+        double range_double = fabs(atof(range_value.c_str()));
 
         // Make a new inequality constraint
-        ++n_ineq;
-        Aineq.RESIZE_AND_FILL(n_ineq, n_vars, 0.0);
-        bineq.RESIZE_AND_FILL(n_ineq,         0.0);
-
-        // Copy the inverted constraints
-        for (int i = 0; i < n_vars; ++i)
-          Aineq(n_ineq - 1, i) = -Aineq(rit->second.second, i);
+        /* Its entries are the inverted ones of the original, and are
+           added once the whole of Aineq is known */
+        int new_idx = model.n_ineq++;
+        ranged[row.second].push_back(new_idx);
 
         // Update the range
-        if (rit->second.first == 'L')
-          bineq(n_ineq - 1) = -(bineq(rit->second.second) - range_double);
+        double b = model.bineq[row.second];
+        if (row.first == 'L')
+          model.bineq.push_back(-(b - range_double));
         else
-          bineq(n_ineq - 1) = -bineq(rit->second.second) + range_double;
+          model.bineq.push_back(-b + range_double);
 
         // Next line
         if (not getline(ifs, line))
           throw "Cannot read RANGES contents";
       }
+
+      // Copy the inverted constraints
+      size_t n_entries = model.Aineq.size();
+      for (size_t t = 0; t < n_entries; ++t) {
+        const vector<int>& copies = ranged[model.Aineq[t].row];
+        for (size_t c = 0; c < copies.size(); ++c)
+          model.Aineq.push_back(qps_triplet(copies[c], model.Aineq[t].col,
+                                            -model.Aineq[t].value));
+      }
     }
 
     /* BOUNDS *******************************************************/
 
-    // Create lb and ub vectors
-    ColumnVector lb(n_vars, 0.0);
-    ColumnVector ub(n_vars, +INFINITY);
-
     // Any BOUNDS
-    if (line.substr(0, 6) == "BOUNDS") {
+    if (is_section(line, "BOUNDS")) {
       // Loop until QUADOBJ or ENDATA section
       if (not getline(ifs, line))
         throw "Cannot read BOUNDS contents";
-      while (line.substr(0, 7) != "QUADOBJ" and
-             line.substr(0, 6) != "ENDATA") {
+      while (not is_section(line, "QUADOBJ") and
+             not is_section(line, "ENDATA")) {
         // Split
-        string bound_type  = trimmed_substr(line,  1, 3);
-        // string bound_name  = trimmed_substr(line,  4, 12);
-        string col_name    = trimmed_substr(line, 14, 22);
-        string bound_value = trimmed_substr(line, 24, 36);
+        string& bound_type  = field1;
+        string& col_name    = field2;
+        string& bound_value = field3;
+        trimmed_field(line,  1,  3, bound_type);
+        trimmed_field(line, 14, 22, col_name);
+        trimmed_field(line, 24, 36, bound_value);
 
         // Ignore the name...
 
@@ -442,16 +571,7 @@ Parse a QPS file\n\
           throw "Wrong BOUNDS entry";
 
         // Index the column
-        map<string, int>::iterator it = col_map.find(col_name);
-        if (it == col_map.end()) {
-          it = col_map.insert(make_pair(col_name, n_vars++)).first;
-          Aeq  .RESIZE_AND_FILL(n_eq,   n_vars, 0.0);
-          Aineq.RESIZE_AND_FILL(n_ineq, n_vars, 0.0);
-          f    .RESIZE_AND_FILL(        n_vars, 0.0);
-          lb   .RESIZE_AND_FILL(        n_vars, 0.0);
-          ub   .RESIZE_AND_FILL(        n_vars, +INFINITY);
-        }
-        int col_idx = it->second;
+        int col_idx = model.add_col(col_name);
 
         // Kind of bound
         if (bound_type == "LO" or bound_type == "UP" or bound_type == "FX") {
@@ -460,27 +580,27 @@ Parse a QPS file\n\
 
           // Set
           if (bound_type == "LO") {
-            lb(col_idx) = bound_double;
+            model.lb[col_idx] = bound_double;
           }
           else if (bound_type == "UP") {
-            ub(col_idx) = bound_double;
+            model.ub[col_idx] = bound_double;
           }
           else { // bound_type == "FX"
-            lb(col_idx) = ub(col_idx) = bound_double;
+            model.lb[col_idx] = model.ub[col_idx] = bound_double;
           }
         }
         else if (bound_type == "FR") {
           // Set
-          lb(col_idx) = -INFINITY;
-          ub(col_idx) = +INFINITY;
+          model.lb[col_idx] = -INFINITY;
+          model.ub[col_idx] = +INFINITY;
         }
         else if (bound_type == "MI") {
           // Set
-          lb(col_idx) = -INFINITY;
+          model.lb[col_idx] = -INFINITY;
         }
         else if (bound_type == "PL") {
           // Set
-          ub(col_idx) = +INFINITY;
+          model.ub[col_idx] = +INFINITY;
         }
         else {
           // Error
@@ -495,54 +615,51 @@ Parse a QPS file\n\
 
     /* QUADOBJ ******************************************************/
 
-    // Quadratic objective matrix
-    Matrix H(n_vars, n_vars, 0.0);
-
     // Any QUADOBJ
-    if (line.substr(0, 7) == "QUADOBJ") {
+    if (is_section(line, "QUADOBJ")) {
       // Loop until ENDATA section
       if (not getline(ifs, line))
         throw "Cannot read QUADOBJ contents";
-      while (line.substr(0, 6) != "ENDATA") {
+      while (not is_section(line, "ENDATA")) {
         // Split
-        string col1_name   = trimmed_substr(line,  4, 12);
-        string col2_name   = trimmed_substr(line, 14, 22);
-        string col12_value = trimmed_substr(line, 24, 36);
-        string col3_name   = trimmed_substr(line, 39, 47);
-        string col13_value = trimmed_substr(line, 49, 61);
+        string& col1_name   = field1;
+        string& col2_name   = field2;
+        string& col12_value = field3;
+        string& col3_name   = field4;
+        string& col13_value = field5;
+        trimmed_field(line,  4, 12, col1_name);
+        trimmed_field(line, 14, 22, col2_name);
+        trimmed_field(line, 24, 36, col12_value);
+        trimmed_field(line, 39, 47, col3_name);
+        trimmed_field(line, 49, 61, col13_value);
 
         // Check
         if (col1_name.empty() or col2_name.empty() or col12_value.empty())
-          throw "Wrong BOUNDS entry";
-
-        // Index column 1
-        map<string, int>::iterator it1 = col_map.find(col1_name);
-        if (it1 == col_map.end())
-          throw "Wrong column name in QUADOBJ section";
+          throw "Wrong QUADOBJ entry";
 
-        // Index column 2
-        map<string, int>::iterator it2 = col_map.find(col2_name);
-        if (it2 == col_map.end())
-          throw "Wrong column name in QUADOBJ section";
+        // Index columns 1 and 2
+        int col1 = model.col(col1_name, "Wrong column name in QUADOBJ section");
+        int col2 = model.col(col2_name, "Wrong column name in QUADOBJ section");
 
-        // Set
+        // Set (both halves)
         double col_double = atof(col12_value.c_str());
-        H(it1->second, it2->second) = H(it2->second, it1->second) = col_double;
+        model.H.push_back(qps_triplet(col1, col2, col_double));
+        model.H.push_back(qps_triplet(col2, col1, col_double));
 
         // More?
         if (not col3_name.empty()) {
           // Check
           if (col13_value.empty())
-            throw "Wrong BOUNDS entry";
+            throw "Wrong QUADOBJ entry";
 
           // Index column 3
-          it2 = col_map.find(col3_name);
-          if (it2 == col_map.end())
-            throw "Wrong column name in QUADOBJ section";
+          int col3 = model.col(col3_name,
+                               "Wrong column name in QUADOBJ section");
 
-          // Set
+          // Set (both halves)
           col_double = atof(col13_value.c_str());
-          H(it1->second, it2->second) = H(it2->second, it1->second) = col_double;
+          model.H.push_back(qps_triplet(col1, col3, col_double));
+          model.H.push_back(qps_triplet(col3, col1, col_double));
         }
 
         // Next line
@@ -555,15 +672,15 @@ Parse a QPS file\n\
 
     // Return
     output.resize(9);
-    output(0) = H;
-    output(1) = f;
-    output(2) = g;
-    output(3) = Aineq;
-    output(4) = bineq;
-    output(5) = Aeq;
-    output(6) = beq;
-    output(7) = lb;
-    output(8) = ub;
+    output(0) = build_sparse(model.n_vars, model.n_vars, model.H);
+    output(1) = to_column(model.f);
+    output(2) = model.g;
+    output(3) = build_sparse(model.n_ineq, model.n_vars, model.Aineq);
+    output(4) = to_column(model.bineq);
+    output(5) = build_sparse(model.n_eq, model.n_vars, model.Aeq);
+    output(6) = to_column(model.beq);
+    output(7) = to_column(model.lb);
+    output(8) = to_column(model.ub);
   }
   // Was there an error?
   catch (const char* _error) {
@@ -29,6 +29,7 @@
 #include <CGAL/QP_models.h>
 #include <CGAL/QP_functions.h>
 
+#include "cgal_arithmetic.h"
 #include "quadprog_common.h"
 
 using namespace CGAL;
@@ -64,6 +65,103 @@ static const double** indexMatrix(const Matrix& _m) {
   return index;
 }
 
+// Problem to solve
+struct cgal_problem {
+  // Number of variables and constraints
+  int n_vars, n_cons;
+
+  // Constraints (A indexed column-wise)
+  const double**           A_index;
+  const double*            b;
+  const Comparison_result* R;
+
+  // Bounds
+  std::vector<bool>*   lb_finiteness;
+  std::vector<double>* lb_value;
+  std::vector<bool>*   ub_finiteness;
+  std::vector<double>* ub_value;
+
+  // Objective (H indexed row-wise)
+  const double** H_index;
+  const double*  f;
+
+  // Kind
+  bool is_linear, is_nonnegative;
+};
+
+// Solve it with a given number type
+template <typename ET>
+static void solve_cgal(const cgal_problem& _p, const ET& _et,
+                       const Quadratic_program_options& _options,
+                       ColumnVector& _x, double& _fval, Octave_map& _info) {
+  // Solution
+  Quadratic_program_solution<ET> solution;
+
+  // Linearity/Quadraticity?
+  if (_p.is_linear) {
+
+    // Nonnegativity/Generality?
+    if (_p.is_nonnegative) {
+      // Linear nonnegative
+      solution = solve_nonnegative_linear_program
+        (make_nonnegative_linear_program_from_iterators
+         (_p.n_vars, _p.n_cons, _p.A_index, _p.b, _p.R, _p.f),
+         _et, _options);
+    }
+    else {
+      // Linear general
+      solution = solve_linear_program
+        (make_linear_program_from_iterators
+         (_p.n_vars, _p.n_cons, _p.A_index, _p.b, _p.R,
+          _p.lb_finiteness->begin(), _p.lb_value->begin(),
+          _p.ub_finiteness->begin(), _p.ub_value->begin(),
+          _p.f),
+         _et, _options);
+    }
+  }
+  else {
+
+    // Nonnegativity/Generality?
+    if (_p.is_nonnegative) {
+      // Quadratic nonnegative
+      solution = solve_nonnegative_quadratic_program
+        (make_nonnegative_quadratic_program_from_iterators
+         (_p.n_vars, _p.n_cons, _p.A_index, _p.b, _p.R,
+          _p.H_index, _p.f),
+         _et, _options);
+    }
+    else {
+      // Quadratic general
+      solution = solve_quadratic_program
+        (make_quadratic_program_from_iterators
+         (_p.n_vars, _p.n_cons, _p.A_index, _p.b, _p.R,
+          _p.lb_finiteness->begin(), _p.lb_value->begin(),
+          _p.ub_finiteness->begin(), _p.ub_value->begin(),
+          _p.H_index, _p.f),
+         _et, _options);
+    }
+  }
+
+  // Set X
+  int v = 0;
+  for (typename Quadratic_program_solution<ET>::Variable_value_iterator
+         it = solution.variable_values_begin();
+       it != solution.variable_values_end(); ++it, ++v)
+    _x(v) = to_double(*it);
+
+  // Objective function
+  _fval = to_double(solution.objective_value());
+
+  // Extract the fields
+  _info.assign("iterations", solution.number_of_iterations());
+  switch (solution.status()) {
+  case QP_OPTIMAL:    _info.assign("status", "optimal");    break;
+  case QP_INFEASIBLE: _info.assign("status", "infeasible"); break;
+  case QP_UNBOUNDED:  _info.assign("status", "unbounded");  break;
+  case QP_UPDATE:     _info.assign("status", "update");     break;
+  }
+}
+
 // Solve quadratic programming problems
 DEFUN_DLD(quadprog_cgal, args, /* nargout */,
           "-*- texinfo -*-\n\
@@ -72,6 +170,11 @@ DEFUN_DLD(quadprog_cgal, args, /* nargout */,
  @var{lb}, @var{ub}, @var{x0}, @var{options})\n         \
 \n\
 Solve quadratic programming problems using CGAL\n\
+\n\
+@var{options}.arithmetic selects the number type: @code{\"double\"}\n\
+(fast, but inexact) or @code{\"filtered\"} (exact, with the pricing\n\
+of the solver done in double and checked exactly only when needed; the\n\
+default, as before this option existed)\n\
 @end deftypefn") {
   // Output
   octave_value_list output;
@@ -117,14 +220,14 @@ Solve quadratic programming problems using CGAL\n\
       is_linear = true;
       for (int i = 0; is_linear and i < _n_vars; ++i)
         for (int j = 0; is_linear and j < _n_vars; ++j)
-          is_linear = A(i, j) == 0.0;
+          is_linear = _H(i, j) == 0.0;
     }
 
     // Is it nonnegative?
     bool is_nonnegative;
     if (_opts.seek("nonnegative") != _opts.end()) {
       // Read the option
-      is_linear = _opts.contents("nonnegative")(0).bool_value();
+      is_nonnegative = _opts.contents("nonnegative")(0).bool_value();
     }
     else {
       // Check
@@ -134,106 +237,49 @@ Solve quadratic programming problems using CGAL\n\
                           not ub_finiteness[i]);
     }
 
-    // Solve the problem
-    Quadratic_program_solution<MP_Float> solution;
+    // Arithmetic
+    cgal_arithmetic arithmetic = get_cgal_arithmetic(_opts);
 
     // Index A column-wise
     const double** A_index = indexMatrix(A);
 
-    // Index H row-wise (if needed)
+    // Index H row-wise (or the transposed of H), if needed
     Matrix TH;
     const double** H_index = 0;
-
-    // Linearity/Quadraticity?
-    if (is_linear) {
-
-      // Nonnegativity/Generality?
-      if (is_nonnegative) {
-        // Linear nonnegative
-        solution = solve_nonnegative_linear_program
-          (make_nonnegative_linear_program_from_iterators
-           (_n_vars,
-            _n_ineq + _n_eq,
-            A_index,
-            b.data(),
-            &R.front(),
-            _f.data()),
-           MP_Float());
-      }
-      else {
-        // Linear general
-        solution = solve_linear_program
-          (make_linear_program_from_iterators
-           (_n_vars,
-            _n_ineq + _n_eq,
-            A_index,
-            b.data(),
-            &R.front(),
-            lb_finiteness.begin(),
-            lb_value.begin(),
-            ub_finiteness.begin(),
-            ub_value.begin(),
-            _f.data()),
-           MP_Float());
-      }
-    }
-    else {
-      // Index H row-wise (or the transposed of H)
+    if (not is_linear) {
       TH      = _H.transpose();
       H_index = indexMatrix(TH);
-
-      // Nonnegativity/Generality?
-      if (is_nonnegative) {
-        // Quadratic nonnegative
-        solution = solve_nonnegative_quadratic_program
-          (make_nonnegative_quadratic_program_from_iterators
-           (_n_vars,
-            _n_ineq + _n_eq,
-            A_index,
-            b.data(),
-            &R.front(),
-            H_index,
-            _f.data()),
-           MP_Float());
-      }
-      else {
-        // Quadratic general
-        solution = solve_quadratic_program
-          (make_quadratic_program_from_iterators
-           (_n_vars,
-            _n_ineq + _n_eq,
-            A_index,
-            b.data(),
-            &R.front(),
-            lb_finiteness.begin(),
-            lb_value.begin(),
-            ub_finiteness.begin(),
-            ub_value.begin(),
-            H_index,
-            _f.data()),
-           MP_Float());
-      }
     }
 
-    // Set X
+    // Problem
+    cgal_problem problem;
+    problem.n_vars         = _n_vars;
+    problem.n_cons         = _n_ineq + _n_eq;
+    problem.A_index        = A_index;
+    problem.b              = b.data();
+    problem.R              = &R.front();
+    problem.lb_finiteness  = &lb_finiteness;
+    problem.lb_value       = &lb_value;
+    problem.ub_finiteness  = &ub_finiteness;
+    problem.ub_value       = &ub_value;
+    problem.H_index        = H_index;
+    problem.f              = _f.data();
+    problem.is_linear      = is_linear;
+    problem.is_nonnegative = is_nonnegative;
+
+    // Solve it
     ColumnVector x(_n_vars);
-    int v = 0;
-    for (Quadratic_program_solution<MP_Float>::Variable_value_iterator
-           it = solution.variable_values_begin();
-         it != solution.variable_values_end(); ++it, ++v)
-      x(v) = to_double(*it);
-
-    // Objective function
-    double fval = to_double(solution.objective_value());
-
-    // Extract the fields
-    Octave_map info;
-    info.assign("iterations", solution.number_of_iterations());
-    switch (solution.status()) {
-    case QP_OPTIMAL:    info.assign("status", "optimal");    break;
-    case QP_INFEASIBLE: info.assign("status", "infeasible"); break;
-    case QP_UNBOUNDED:  info.assign("status", "unbounded");  break;
-    case QP_UPDATE:     info.assign("status", "update");     break;
+    double       fval;
+    Octave_map   info;
+    Quadratic_program_options options; // Default pricing
+    switch (arithmetic) {
+    case CGAL_ARITHMETIC_DOUBLE:
+      solve_cgal(problem, double(), options, x, fval, info);
+      break;
+
+    default:
+      solve_cgal(problem, cgal_exact_type(), options, x, fval, info);
+      break;
     }
 
     // Delete the indices
@@ -23,14 +23,25 @@
 #include "config.h"
 #endif
 
+// Get a constraint matrix (dense)
+static void get_constraint_matrix(const octave_value& arg, Matrix& A) {
+  A = arg.matrix_value();
+}
+
+// Get a constraint matrix (sparse)
+static void get_constraint_matrix(const octave_value& arg, SparseMatrix& A) {
+  A = arg.sparse_matrix_value();
+}
+
 // Parse quadprog arguments
-void parse_quadprog_args(const octave_value_list& args,
-                         int& n_vars, int& n_ineq, int& n_eq,
-                         Matrix& H, ColumnVector& f,
-                         Matrix& Aineq, ColumnVector& bineq,
-                         Matrix& Aeq, ColumnVector& beq,
-                         ColumnVector& lb, ColumnVector& ub,
-                         ColumnVector& x, Octave_map& opts) throw (const char*) {
+template <typename AMatrix>
+static void parse_args(const octave_value_list& args,
+                       int& n_vars, int& n_ineq, int& n_eq,
+                       Matrix& H, ColumnVector& f,
+                       AMatrix& Aineq, ColumnVector& bineq,
+                       AMatrix& Aeq, ColumnVector& beq,
+                       ColumnVector& lb, ColumnVector& ub,
+                       ColumnVector& x, Octave_map& opts) throw (const char*) {
   // Check the number of parameters
   if (args.length() < 4 or args.length() > 10)
     throw (const char*)0;
@@ -40,7 +51,7 @@ void parse_quadprog_args(const octave_value_list& args,
     H.RESIZE_AND_FILL(1, 1, args(0).scalar_value());
     n_vars = 1;
   }
-  else if (args(0).is_real_matrix()) {
+  else if (args(0).is_real_matrix() or args(0).is_sparse_type()) {
     if (args(0).rows() != args(0).columns())
       throw "H should be a square matrix";
     H = args(0).matrix_value();
@@ -76,13 +87,13 @@ void parse_quadprog_args(const octave_value_list& args,
   else if (args(2).is_real_scalar()) {
     if (n_vars != 1)
       throw "Aineq should be a matrix with the same columns as H";
-    Aineq.RESIZE_AND_FILL(1, 1, args(2).scalar_value());
+    get_constraint_matrix(args(2), Aineq);
     n_ineq = 1;
   }
-  else if (args(2).is_real_matrix()) {
+  else if (args(2).is_real_matrix() or args(2).is_sparse_type()) {
     if (args(2).columns() != n_vars)
       throw "Aineq should be a matrix with the same columns as H";
-    Aineq = args(2).matrix_value();
+    get_constraint_matrix(args(2), Aineq);
     n_ineq = Aineq.rows();
   }
   else {
@@ -121,13 +132,13 @@ void parse_quadprog_args(const octave_value_list& args,
   else if (args(4).is_real_scalar()) {
     if (n_vars != 1)
       throw "Aeq should be a matrix with the same columns as H";
-    Aeq.RESIZE_AND_FILL(1, 1, args(4).scalar_value());
+    get_constraint_matrix(args(4), Aeq);
     n_eq = 1;
   }
-  else if (args(4).is_real_matrix()) {
+  else if (args(4).is_real_matrix() or args(4).is_sparse_type()) {
     if (args(4).columns() != n_vars)
       throw "Aeq should be a matrix with the same columns as H";
-    Aeq = args(4).matrix_value();
+    get_constraint_matrix(args(4), Aeq);
     n_eq = Aeq.rows();
   }
   else {
@@ -247,3 +258,27 @@ void parse_quadprog_args(const octave_value_list& args,
       throw "opts should be a struct";
   }
 }
+
+// Parse quadprog arguments (dense constraints)
+void parse_quadprog_args(const octave_value_list& args,
+                         int& n_vars, int& n_ineq, int& n_eq,
+                         Matrix& H, ColumnVector& f,
+                         Matrix& Aineq, ColumnVector& bineq,
+                         Matrix& Aeq, ColumnVector& beq,
+                         ColumnVector& lb, ColumnVector& ub,
+                         ColumnVector& x, Octave_map& opts) throw (const char*) {
+  parse_args(args, n_vars, n_ineq, n_eq, H, f, Aineq, bineq, Aeq, beq,
+             lb, ub, x, opts);
+}
+
+// Parse quadprog arguments (sparse constraints)
+void parse_quadprog_args(const octave_value_list& args,
+                         int& n_vars, int& n_ineq, int& n_eq,
+                         Matrix& H, ColumnVector& f,
+                         SparseMatrix& Aineq, ColumnVector& bineq,
+                         SparseMatrix& Aeq, ColumnVector& beq,
+                         ColumnVector& lb, ColumnVector& ub,
+                         ColumnVector& x, Octave_map& opts) throw (const char*) {
+  parse_args(args, n_vars, n_ineq, n_eq, H, f, Aineq, bineq, Aeq, beq,
+             lb, ub, x, opts);
+}
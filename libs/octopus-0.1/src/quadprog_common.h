@@ -22,7 +22,7 @@
 #include <octave/oct.h>
 #include <octave/oct-map.h>
 
-// Parse quadprog arguments
+// Parse quadprog arguments (dense constraints)
 void parse_quadprog_args(const octave_value_list& args,
                          int& n_vars, int& n_ineq, int& n_eq,
                          Matrix& H, ColumnVector& f,
@@ -31,4 +31,15 @@ void parse_quadprog_args(const octave_value_list& args,
                          ColumnVector& lb, ColumnVector& ub,
                          ColumnVector& x, Octave_map& opts) throw (const char*);
 
+// Parse quadprog arguments (sparse constraints)
+/* Aineq and Aeq are kept in compressed form, whether given as full or
+   sparse matrices */
+void parse_quadprog_args(const octave_value_list& args,
+                         int& n_vars, int& n_ineq, int& n_eq,
+                         Matrix& H, ColumnVector& f,
+                         SparseMatrix& Aineq, ColumnVector& bineq,
+                         SparseMatrix& Aeq, ColumnVector& beq,
+                         ColumnVector& lb, ColumnVector& ub,
+                         ColumnVector& x, Octave_map& opts) throw (const char*);
+
 #endif
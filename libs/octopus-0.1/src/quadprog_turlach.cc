@@ -20,130 +20,643 @@
 #include <cmath>
 #include <exception>
 // #include <iostream>
+#include <memory>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <octave/oct.h>
 #include <octave/oct-map.h>
 
+#include "octave_c_ptr_value.h"
 #include "quadprog_common.h"
 
 
-// Fortran qpgen2_ function
+// Fortran qpgen2s_ function
+/* qpgen2 taking the constraint matrix in compressed sparse columns, and
+   the bounds apart */
+extern "C"
+void qpgen2s_(double* dmat, double* dvec, const int& fddmat, const int& n,
+              double* sol,  double* lagr, double& crval,
+              double* aval, const int* arow, const int* acol, double* bvec,
+              const int& q, const int& meq, const double* xl,
+              const double* xu, int* ibnd, int* iact, int& nact, int* iter,
+              double* work, int& ierr);
+
+// Fortran dpofa_ function (LINPACK Cholesky factorisation)
 extern "C"
-void qpgen2_(double* dmat, double* dvec, const int& fddmat, const int& n,
-             double* sol,  double* lagr, double& crval,
-             double* amat, double* bvec, const int& fdamat,
-             const int& q, const int& meq, int* iact, int& nact, int* iter,
-             double* work, int& ierr);
+void dpofa_(double* a, const int& lda, const int& n, int& info);
+
+// Fortran dpori_ function (inverse of the Cholesky factor)
+extern "C"
+void dpori_(double* a, const int& lda, const int& n);
+
+
+/***************/
+/* Constraints */
+/***************/
+
+// Constraints
+/* The columns of A = [ Aeq', -Aineq' ], in compressed sparse column form
+   with 1-based indices, as qpgen2s takes them, and the bounds. Bounds are
+   not columns: a variable at a bound is fixed, and qpgen2s applies the
+   normal +/- e_j of the bound on the fly. Bounds are numbered after the
+   columns, first the lower and then the upper ones
+*/
+struct quadprog_turlach_constraints {
+  // Number of equalities and inequalities
+  int n_eq;
+  int n_ineq;
+
+  // Non-zero entries, their rows, and the first entry of each column
+  std::vector<double> aval;
+  std::vector<int>    arow;
+  std::vector<int>    acol;
+
+  // Right hand side
+  std::vector<double> bvec;
+
+  // Lower and upper bounds
+  std::vector<double> lb;
+  std::vector<double> ub;
+
+  // Number of columns
+  int size() const {
+    return bvec.size();
+  }
+
+  // Number of variables
+  int n_vars() const {
+    return lb.size();
+  }
+
+  // Number of constraints, bounds included
+  int n_total() const {
+    return size() + 2 * n_vars();
+  }
+};
+
+// Add the rows of a constraint matrix as columns
+static void add_rows(quadprog_turlach_constraints& _cons,
+                     const SparseMatrix& _A, const ColumnVector& _b,
+                     double _sign) {
+  // Transpose, so that rows become compressed columns
+  SparseMatrix A_t = _A.transpose();
+
+  // Raw arrays
+  const octave_idx_type* cidx = A_t.cidx();
+  const octave_idx_type* ridx = A_t.ridx();
+  const double*          nnz  = A_t.data();
+
+  // For each row of A
+  for (octave_idx_type c = 0; c < A_t.columns(); ++c) {
+    for (octave_idx_type p = cidx[c]; p < cidx[c + 1]; ++p) {
+      if (nnz[p] != 0.0) {
+        _cons.aval.push_back(_sign * nnz[p]);
+        _cons.arow.push_back(ridx[p] + 1);
+      }
+    }
+    _cons.acol.push_back(_cons.aval.size() + 1);
+    _cons.bvec.push_back(_sign * _b(c));
+  }
+}
+
+// Build the constraints
+static void build_constraints(quadprog_turlach_constraints& _cons,
+                              int _n_vars,
+                              const SparseMatrix& _Aineq,
+                              const ColumnVector& _bineq,
+                              const SparseMatrix& _Aeq,
+                              const ColumnVector& _beq,
+                              const ColumnVector& _lb,
+                              const ColumnVector& _ub) {
+  // Sizes
+  _cons.n_eq   = _beq  .length();
+  _cons.n_ineq = _bineq.length();
+
+  // Start
+  _cons.acol.assign(1, 1);
+
+  // Equalities and inequalities
+  if (_cons.n_eq)
+    add_rows(_cons, _Aeq,    _beq,    1.0);
+  if (_cons.n_ineq)
+    add_rows(_cons, _Aineq, _bineq, -1.0);
+
+  // Lower and upper bounds
+  _cons.lb.assign(_lb.data(), _lb.data() + _n_vars);
+  _cons.ub.assign(_ub.data(), _ub.data() + _n_vars);
+}
+
+// Right hand side of a constraint
+static double constraint_rhs(const quadprog_turlach_constraints& _cons,
+                             int _c) {
+  // Column
+  if (_c < _cons.size())
+    return _cons.bvec[_c];
+
+  // Bound
+  int j = _c - _cons.size();
+  return j < _cons.n_vars() ? _cons.lb[j] : -_cons.ub[j - _cons.n_vars()];
+}
+
+// Slack of a constraint
+static double constraint_slack(const quadprog_turlach_constraints& _cons,
+                               int _c, const double* _x) {
+  // Bound?
+  if (_c >= _cons.size()) {
+    int j = _c - _cons.size();
+    if (j < _cons.n_vars())
+      return _x[j] - _cons.lb[j];
+    j -= _cons.n_vars();
+    return _cons.ub[j] - _x[j];
+  }
+
+  // Column
+  double slack = -_cons.bvec[_c];
+  for (int p = _cons.acol[_c] - 1; p < _cons.acol[_c + 1] - 1; ++p)
+    slack += _cons.aval[p] * _x[_cons.arow[p] - 1];
+  return slack;
+}
+
+
+/****************/
+/* Solver state */
+/****************/
+
+// Solver state
+/* Kept alive between calls through a handle, so that problems sharing
+   the same H skip the factorisation, and start from the previous active
+   set
+*/
+struct quadprog_turlach_state {
+  // Quadratic term
+  Matrix H;
+
+  // Inverse of the upper Cholesky factor of H (H = R' R, rinv = R^-1)
+  Matrix rinv;
+
+  // Was the factorisation successful?
+  bool factored;
+
+  // Last active inequalities, lower and upper bounds (0-based)
+  std::vector<int> act_ineq;
+  std::vector<int> act_lb;
+  std::vector<int> act_ub;
+};
+
+typedef octave_c_pointer_value<quadprog_turlach_state> quadprog_turlach_value;
+octave_c_pointer_static(quadprog_turlach_state, "quadprog_turlach_state");
+
+// Factor H in place into R^-1
+/* Touches no Octave object. Returns false if H is not positive definite
+ */
+static bool factor_hessian(double* _rinv, int _n_vars) {
+  // Factor
+  int info;
+  dpofa_(_rinv, _n_vars, _n_vars, info);
+
+  // Failed?
+  if (info != 0)
+    return false;
+
+  // Invert it
+  dpori_(_rinv, _n_vars, _n_vars);
+
+  // Clear the lower triangle
+  for (int c = 0; c < _n_vars; ++c)
+    for (int r = c + 1; r < _n_vars; ++r)
+      _rinv[r + c * _n_vars] = 0.0;
+
+  // Done
+  return true;
+}
+
+// Factor the H of a state
+static void factor_hessian(quadprog_turlach_state& _state) {
+  _state.rinv     = _state.H;
+  _state.factored = factor_hessian(_state.rinv.fortran_vec(),
+                                   _state.H.rows());
+}
+
+// Guess the active set from the state
+/* Equalities come first, and indices no longer valid are dropped */
+static void guess_active_set(const quadprog_turlach_state& _state,
+                             const quadprog_turlach_constraints& _cons,
+                             std::vector<int>& _active) {
+  // Equalities
+  _active.clear();
+  for (int e = 0; e < _cons.n_eq; ++e)
+    _active.push_back(e);
+
+  // Inequalities
+  for (std::vector<int>::const_iterator it = _state.act_ineq.begin();
+       it != _state.act_ineq.end(); ++it)
+    if (*it < _cons.n_ineq)
+      _active.push_back(_cons.n_eq + *it);
+
+  // Finite bounds
+  int n_vars = _cons.n_vars();
+  for (std::vector<int>::const_iterator it = _state.act_lb.begin();
+       it != _state.act_lb.end(); ++it)
+    if (*it < n_vars and std::isfinite(_cons.lb[*it]))
+      _active.push_back(_cons.size() + *it);
+  for (std::vector<int>::const_iterator it = _state.act_ub.begin();
+       it != _state.act_ub.end(); ++it)
+    if (*it < n_vars and std::isfinite(_cons.ub[*it]))
+      _active.push_back(_cons.size() + n_vars + *it);
+}
+
+// Store the active set into the state
+static void store_active_set(quadprog_turlach_state& _state,
+                             const quadprog_turlach_constraints& _cons,
+                             const std::vector<int>& _active) {
+  // Clear
+  _state.act_ineq.clear();
+  _state.act_lb  .clear();
+  _state.act_ub  .clear();
+
+  // For each active constraint
+  int first_ub = _cons.size() + _cons.n_vars();
+  for (std::vector<int>::const_iterator it = _active.begin();
+       it != _active.end(); ++it) {
+    if (*it < _cons.n_eq)
+      continue;
+
+    if (*it < _cons.size())
+      _state.act_ineq.push_back(*it - _cons.n_eq);
+    else if (*it < first_ub)
+      _state.act_lb.push_back(*it - _cons.size());
+    else
+      _state.act_ub.push_back(*it - first_ub);
+  }
+}
+
+
+/**************/
+/* Warm start */
+/**************/
+
+// Tolerance on the KKT conditions of a guessed active set
+static const double KKT_TOLERANCE = 1e-9;
+
+// Constraints that are tight at x0
+static void tight_active_set(const quadprog_turlach_constraints& _cons,
+                             const double* _x0, std::vector<int>& _active) {
+  // Equalities
+  _active.clear();
+  for (int e = 0; e < _cons.n_eq; ++e)
+    _active.push_back(e);
+
+  // Tight inequalities and finite bounds
+  for (int c = _cons.n_eq; c < _cons.n_total(); ++c) {
+    double rhs = constraint_rhs(_cons, c);
+    if (std::isfinite(rhs) and std::fabs(constraint_slack(_cons, c, _x0)) <=
+        KKT_TOLERANCE * (1.0 + std::fabs(rhs)))
+      _active.push_back(c);
+  }
+}
+
+// Solve the problem with a guessed active set
+/* Minimizes -d' x + 1/2 x' H x subject to A_a' x = b_a for the columns a
+   in _active (which start with the equalities), using H^-1 = J J' with
+   J = R^-1. The multipliers follow from
+     (N' N) lambda = b_a - N' J' d,    N = J' A_a
+   and then x = J (J' d + N lambda). Returns true if the result satisfies
+   every constraint and all the inequality multipliers are non-negative,
+   i.e., if the guess was the optimal active set
+*/
+static bool solve_active_set(const double* _rinv, int _n_vars,
+                             const double* _dvec,
+                             const quadprog_turlach_constraints& _cons,
+                             const std::vector<int>& _active,
+                             double* _sol, double& _crval) {
+  // Size
+  int n_active = _active.size();
+
+  // More active constraints than variables?
+  if (n_active > _n_vars)
+    return false;
+
+  // u = J' d
+  std::vector<double> u(_n_vars, 0.0);
+  for (int i = 0; i < _n_vars; ++i)
+    for (int j = 0; j <= i; ++j)
+      u[i] += _rinv[j + i * _n_vars] * _dvec[j];
+
+  // N = J' A_a
+  /* Only the non-zeros of each column of A are visited, and the J' e_j
+     of a bound is a row of J */
+  std::vector<double> nmat(_n_vars * n_active, 0.0);
+  for (int a = 0; a < n_active; ++a) {
+    double* n_col = &nmat[a * _n_vars];
+
+    // Bound?
+    if (_active[a] >= _cons.size()) {
+      int    j    = _active[a] - _cons.size();
+      double sign = 1.0;
+      if (j >= _n_vars) {
+        j   -= _n_vars;
+        sign = -1.0;
+      }
+      for (int i = j; i < _n_vars; ++i)
+        n_col[i] = sign * _rinv[j + i * _n_vars];
+      continue;
+    }
+
+    for (int p = _cons.acol[_active[a]] - 1;
+         p < _cons.acol[_active[a] + 1] - 1; ++p) {
+      int    j = _cons.arow[p] - 1;
+      double v = _cons.aval[p];
+      for (int i = j; i < _n_vars; ++i)
+        n_col[i] += _rinv[j + i * _n_vars] * v;
+    }
+  }
+
+  // G = N' N and r = b_a - N' u
+  std::vector<double> gmat(n_active * n_active);
+  std::vector<double> lambda(n_active);
+  for (int a = 0; a < n_active; ++a) {
+    const double* n_a = &nmat[a * _n_vars];
+    for (int b = 0; b <= a; ++b) {
+      const double* n_b = &nmat[b * _n_vars];
+      double dot = 0.0;
+      for (int i = 0; i < _n_vars; ++i)
+        dot += n_a[i] * n_b[i];
+      gmat[a + b * n_active] = gmat[b + a * n_active] = dot;
+    }
+
+    double dot = 0.0;
+    for (int i = 0; i < _n_vars; ++i)
+      dot += n_a[i] * u[i];
+    lambda[a] = constraint_rhs(_cons, _active[a]) - dot;
+  }
+
+  // Cholesky factorisation of G (lower, in place)
+  for (int j = 0; j < n_active; ++j) {
+    double diag = gmat[j + j * n_active];
+    for (int l = 0; l < j; ++l)
+      diag -= gmat[j + l * n_active] * gmat[j + l * n_active];
+
+    // Dependent constraints?
+    if (diag <= KKT_TOLERANCE)
+      return false;
+
+    diag = std::sqrt(diag);
+    gmat[j + j * n_active] = diag;
+    for (int i = j + 1; i < n_active; ++i) {
+      double acc = gmat[i + j * n_active];
+      for (int l = 0; l < j; ++l)
+        acc -= gmat[i + l * n_active] * gmat[j + l * n_active];
+      gmat[i + j * n_active] = acc / diag;
+    }
+  }
+
+  // Solve G lambda = r
+  for (int i = 0; i < n_active; ++i) {
+    for (int l = 0; l < i; ++l)
+      lambda[i] -= gmat[i + l * n_active] * lambda[l];
+    lambda[i] /= gmat[i + i * n_active];
+  }
+  for (int i = n_active - 1; i >= 0; --i) {
+    for (int l = i + 1; l < n_active; ++l)
+      lambda[i] -= gmat[l + i * n_active] * lambda[l];
+    lambda[i] /= gmat[i + i * n_active];
+  }
+
+  // Dual feasibility of the inequalities
+  for (int a = _cons.n_eq; a < n_active; ++a)
+    if (lambda[a] < -KKT_TOLERANCE)
+      return false;
+
+  // z = u + N lambda
+  for (int a = 0; a < n_active; ++a) {
+    const double* n_a = &nmat[a * _n_vars];
+    for (int i = 0; i < _n_vars; ++i)
+      u[i] += n_a[i] * lambda[a];
+  }
+
+  // x = J z
+  for (int j = 0; j < _n_vars; ++j) {
+    double acc = 0.0;
+    for (int i = j; i < _n_vars; ++i)
+      acc += _rinv[j + i * _n_vars] * u[i];
+    _sol[j] = acc;
+  }
+
+  // Primal feasibility
+  /* Infinite bounds have an infinite slack */
+  for (int c = 0; c < _cons.n_total(); ++c) {
+    double slack = constraint_slack(_cons, c, _sol);
+    double tol   = KKT_TOLERANCE *
+      (1.0 + std::fabs(constraint_rhs(_cons, c)));
+    if (c < _cons.n_eq ? std::fabs(slack) > tol : slack < -tol)
+      return false;
+  }
+
+  // Objective value
+  /* x' H x = x' (d + A_a lambda) = x' d + lambda' b_a */
+  _crval = 0.0;
+  for (int j = 0; j < _n_vars; ++j)
+    _crval -= 0.5 * _sol[j] * _dvec[j];
+  for (int a = 0; a < n_active; ++a)
+    _crval += 0.5 * lambda[a] * constraint_rhs(_cons, _active[a]);
+
+  // Found
+  return true;
+}
+
+
+/**********/
+/* Solver */
+/**********/
+
+// Workspace
+/* Scratch arrays of qpgen2s, which destroys its inputs */
+struct quadprog_turlach_workspace {
+  std::vector<double> dmat;
+  std::vector<double> dvec;
+  std::vector<double> aval;
+  std::vector<double> bvec;
+  std::vector<double> lagr;
+  std::vector<double> work;
+  std::vector<int>    iact;
+  std::vector<int>    ibnd;
+};
+
+// Solve a problem
+/* _active holds the guessed active set on input, and the final one on
+   output. Returns the qpgen2 error code. Touches no Octave object
+*/
+static int solve_problem(const double* _rinv, int _n_vars, const double* _f,
+                         const quadprog_turlach_constraints& _cons,
+                         std::vector<int>& _active,
+                         quadprog_turlach_workspace& _ws,
+                         double* _sol, double& _crval, int* _iter,
+                         bool& _warm) {
+  // Number of constraints
+  int n_constraints = _cons.size();
+
+  // d = -f
+  _ws.dvec.resize(_n_vars);
+  for (int i = 0; i < _n_vars; ++i)
+    _ws.dvec[i] = -_f[i];
+
+  // Try the guessed active set
+  _iter[0] = _iter[1] = 0;
+  if ((_warm = solve_active_set(_rinv, _n_vars, &_ws.dvec.front(), _cons,
+                                _active, _sol, _crval)))
+    return 0;
+
+  // Start from R^-1
+  _ws.dmat.assign(_rinv, _rinv + _n_vars * _n_vars);
+  int ierr = 1; // != 0 on input -> dmat holds R^-1
+
+  // Copies of the constraints qpgen2s may negate
+  _ws.aval = _cons.aval;
+  _ws.bvec = _cons.bvec;
+
+  // Outputs
+  /* One extra element, so that front() is valid without constraints */
+  _ws.lagr.resize(_cons.n_total() + 1);
+  _ws.iact.resize(_n_vars + 1);
+  _ws.ibnd.resize(_n_vars + 1);
+  int nact;
+
+  // Finite bounds
+  int n_bounds = 0;
+  for (int j = 0; j < _n_vars; ++j)
+    n_bounds += std::isfinite(_cons.lb[j]) + std::isfinite(_cons.ub[j]);
+
+  // Working space
+  /* Bounds only count towards the active set, which is never larger
+     than _n_vars */
+  int r     = std::min(_n_vars, n_constraints + n_bounds);
+  int wsize = 2 * _n_vars + r * (r + 5) / 2 + 2 * n_constraints + 1;
+  _ws.work.resize(wsize);
+
+  // Call!!
+  qpgen2s_(&_ws.dmat.front(), &_ws.dvec.front(), _n_vars, _n_vars,
+           _sol, &_ws.lagr.front(), _crval,
+           _ws.aval.empty() ? 0 : &_ws.aval.front(),
+           _cons.arow.empty() ? 0 : &_cons.arow.front(), &_cons.acol.front(),
+           _ws.bvec.empty() ? 0 : &_ws.bvec.front(),
+           n_constraints, _cons.n_eq, &_cons.lb.front(), &_cons.ub.front(),
+           &_ws.ibnd.front(), &_ws.iact.front(), nact, _iter,
+           &_ws.work.front(), ierr);
+
+  // Keep the active set
+  _active.resize(nact);
+  for (int a = 0; a < nact; ++a)
+    _active[a] = _ws.iact[a] - 1;
+
+  // Return the error code
+  return ierr;
+}
 
 // Solve quadratic programming problems
-DEFUN_DLD(quadprog_turlach, args, /* nargout */,
+DEFUN_DLD(quadprog_turlach, args, nargout,
           "-*- texinfo -*-\n\
-@deftypefn {Loadable Function} {[ @var{x}, @var{fval}, @var{info} ] =}\
+@deftypefn {Loadable Function} {[ @var{x}, @var{fval}, @var{info}, @var{qp} ] =}\
  quadprog_turlach(@var{H}, @var{f}, @var{Aineq}, @var{bineq}, @var{Aeq}, @var{beq},\
  @var{lb}, @var{ub}, @var{x0}, @var{options})\n         \
 \n\
 Solve quadratic programming problems using Berwin A. Turlach's implementation\n\
 of the Goldfarb/Idnani algorithm.\n\
+\n\
+@var{Aineq} and @var{Aeq} may be sparse, and are stored in compressed form.\n\
+The bounds in @var{lb} and @var{ub} are not constraint columns: variables\n\
+at a bound are fixed inside the active set step.\n\
+\n\
+If requested, @var{qp} is a handle holding the factorisation of @var{H} and\n\
+the final active set. Passing it instead of @var{H} in later calls skips the\n\
+factorisation, and first tries the previous active set (or, for a fresh\n\
+@var{H}, the constraints that are tight at @var{x0}) before running the full\n\
+algorithm.\n\
 @end deftypefn") {
   // Output
   octave_value_list output;
 
   try {
+    // Check the number of parameters
+    if (args.length() < 1 or nargout > 4)
+      throw (const char*)0;
+
+    // Solver state
+    std::auto_ptr<quadprog_turlach_state> new_state;
+    quadprog_turlach_state*               state;
+
+    // Arguments
+    octave_value_list q_args = args;
+
+    // Given a handle?
+    quadprog_turlach_value* value = quadprog_turlach_value::cast(args(0));
+    if (value) {
+      // Defined?
+      if (not value->is_defined())
+        throw "qp cannot be null";
+
+      // Take H from it
+      state     = &value->data();
+      q_args(0) = state->H;
+    }
+    else {
+      // New state
+      new_state.reset(new quadprog_turlach_state);
+      state = new_state.get();
+    }
+
     // Parse
     int _n_vars, _n_ineq, _n_eq;
-    Matrix _H, _Aineq, _Aeq;
+    Matrix _H;
+    SparseMatrix _Aineq, _Aeq;
     ColumnVector _f, _bineq, _beq, _lb, _ub, _x;
     Octave_map _opts;
-    parse_quadprog_args(args, _n_vars, _n_ineq,  _n_eq, _H, _f,
+    parse_quadprog_args(q_args, _n_vars, _n_ineq,  _n_eq, _H, _f,
                         _Aineq, _bineq, _Aeq, _beq, _lb, _ub,
                         _x, _opts);
 
-    // Make copies of required data
-    Matrix       dmat =  _H;
-    ColumnVector dvec = -_f;
-
-    // Count effective lower and upper bounds
-    int n_eff = 0;
-    for (int i = 0; i < _n_vars; ++i) {
-      if (std::isfinite(_lb(i))) ++n_eff;
-      if (std::isfinite(_ub(i))) ++n_eff;
-    }
-
-    // Total number of constraints
-    int n_constraints = _n_eq + _n_ineq + n_eff;
-
-    // Joint constraint matrix
-    Matrix amat(_n_vars, n_constraints, 0.0);
-    amat.insert( _Aeq  .transpose(), 0,     0);
-    amat.insert(-_Aineq.transpose(), 0, _n_eq);
-
-    // Joint constraint vector
-    ColumnVector bvec(n_constraints, 0.0);
-    bvec.insert( _beq,   0);
-    bvec.insert(-_bineq, _n_eq);
-
-    // Add lower and upper bounds
-    int c = _n_eq + _n_ineq;
-    for (int i = 0; i < _n_vars; ++i) {
-      if (std::isfinite(_lb(i))) {
-        amat(i, c) = 1.0;
-        bvec(c)    = _lb(i);
-        ++c;
-      }
-      if (std::isfinite(_ub(i))) {
-        amat(i, c) = -1.0;
-        bvec(c)    = -_ub(i);
-        ++c;
-      }
+    // Factor H, if it is a new one
+    if (new_state.get()) {
+      state->H = _H;
+      factor_hessian(*state);
     }
 
-    // Error flag
-    int ierr = 0; // 0 on input -> Must factor dmat
+    // Constraints
+    quadprog_turlach_constraints cons;
+    build_constraints(cons, _n_vars, _Aineq, _bineq, _Aeq, _beq, _lb, _ub);
+
+    // Guessed active set
+    std::vector<int> active;
+    /* A fresh state only holds the equalities */
+    if (new_state.get() and args.length() > 8 and
+        not args(8).is_zero_by_zero())
+      tight_active_set(cons, _x.data(), active);
+    else
+      guess_active_set(*state, cons, active);
 
     // Outputs
     ColumnVector sol(_n_vars);
-    ColumnVector lagr(n_constraints);
     double crval;
-    std::vector<int> iact(n_constraints);
-    int nact;
-    int iter[2];
-
-    // Working space
-    int r     = std::min(_n_vars, n_constraints);
-    int wsize = 2 * _n_vars + r * (r + 5) / 2 + 2 * n_constraints + 1;
-    std::vector<double> work(wsize);
-
-    /*
-    // Display dmat
-    std::cerr << "dmat = " << std::endl;
-    for (uint r = 0; r < _n_vars; ++r) {
-      for (uint c = 0; c < _n_vars; ++c)
-        std::cerr  << ' ' << dmat(r, c);
-      std::cerr << std::endl;
-    }
-
-    // Display dvec
-    std::cerr << "dvec = " << std::endl;
-    for (uint r = 0; r < _n_vars; ++r)
-      std::cerr  << ' ' << dvec(r);
-    std::cerr << std::endl;
-
-    // Display amat and bvec
-    std::cerr << "amat, bvec = " << std::endl;
-    for (uint c = 0; c < n_constraints; ++c) {
-      for (uint r = 0; r < _n_vars; ++r)
-        std::cerr  << ' ' << amat(r, c);
-      std::cerr << (c < _n_eq ? " = " : " >= ") << bvec(c) << std::endl;
-    }
-    */
-
-    // Call!!
-    qpgen2_(dmat.fortran_vec(), dvec.fortran_vec(), _n_vars, _n_vars,
-            sol.fortran_vec(), lagr.fortran_vec(), crval,
-            amat.fortran_vec(), bvec.fortran_vec(), _n_vars,
-            n_constraints, _n_eq, &iact.front(), nact, iter,
-            &work.front(), ierr);
+    int iter[2] = { 0, 0 };
+    bool warm = false;
+
+    // Solve
+    int ierr;
+    if (state->factored) {
+      quadprog_turlach_workspace ws;
+      ierr = solve_problem(state->rinv.data(), _n_vars, _f.data(), cons,
+                           active, ws, sol.fortran_vec(), crval, iter, warm);
+    }
+    else {
+      ierr = 2;
+    }
+
+    // Store the active set
+    if (ierr == 0)
+      store_active_set(*state, cons, active);
 
     // Extract the fields
     Octave_map info;
@@ -161,12 +674,251 @@ of the Goldfarb/Idnani algorithm.\n\
       crval = NAN;
       break;
     }
+    info.assign("warm_start", warm);
 
     // Return
-    output.resize(3);
+    output.resize(nargout > 3 ? 4 : 3);
     output(0) = sol;
     output(1) = crval;
     output(2) = info;
+
+    // Handle
+    if (nargout > 3) {
+      if (new_state.get())
+        output(3) = new quadprog_turlach_value(new_state.release());
+      else
+        output(3) = args(0);
+    }
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return output;
+}
+
+
+/********************************/
+/* Solve a batch of QP problems */
+/********************************/
+
+// Batch problem
+struct quadprog_turlach_problem {
+  // Number of variables
+  int n_vars;
+
+  // Factor of H (index into the shared list)
+  int factor;
+
+  // Linear term
+  std::vector<double> f;
+
+  // Constraints
+  quadprog_turlach_constraints cons;
+
+  // Guessed, and then final, active set
+  std::vector<int> active;
+
+  // Results
+  std::vector<double> sol;
+  double crval;
+  int    iter[2];
+  bool   warm;
+  int    ierr;
+};
+
+// PKG_ADD: autoload('quadprog_turlach_batch', which('quadprog_turlach'));
+
+DEFUN_DLD(quadprog_turlach_batch, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {[ @var{x}, @var{fval}, @var{info} ] =}\
+ quadprog_turlach_batch(@var{H}, @var{f}, @var{Aineq}, @var{bineq}, @var{Aeq},\
+ @var{beq}, @var{lb}, @var{ub}, @var{x0}, @var{options})\n\
+\n\
+Solve many independent quadratic programming problems in parallel.\n\
+\n\
+Each argument is either a cell array, with one element per problem, or a\n\
+value shared by all of them. A shared @var{H} is only factored once.\n\
+@var{x}, @var{fval} and @var{info} are cell arrays with the results of\n\
+@code{quadprog_turlach} for each problem. A shared @var{options} struct may\n\
+set the number of @var{workers} threads.\n\
+@end deftypefn") {
+  // Output
+  octave_value_list output;
+
+  try {
+    // Check the number of parameters
+    if (args.length() < 4 or args.length() > 10 or nargout > 3)
+      throw (const char*)0;
+
+    // Number of problems
+    /* Cell arguments hold one element per problem */
+    octave_idx_type n_problems = -1;
+    dim_vector      problem_dims;
+    std::vector<Cell> cells(args.length());
+    for (int a = 0; a < args.length(); ++a) {
+      if (args(a).is_cell()) {
+        cells[a] = args(a).cell_value();
+        if (n_problems == -1) {
+          n_problems   = cells[a].numel();
+          problem_dims = cells[a].dims();
+        }
+        else if (cells[a].numel() != n_problems) {
+          throw "cell arguments should have the same number of elements";
+        }
+      }
+    }
+    if (n_problems == -1)
+      throw "at least one argument should be a cell array";
+
+    // Number of workers
+    int n_workers = 1;
+#ifdef _OPENMP
+    n_workers = omp_get_max_threads();
+#endif
+    if (args.length() > 9 and args(9).is_map()) {
+      Octave_map opts = args(9).map_value();
+      if (opts.seek("workers") != opts.end()) {
+        n_workers = opts.contents("workers")(0).int_value();
+        if (n_workers < 1)
+          throw "opts.workers should be a positive integer";
+      }
+    }
+
+    // Shared H?
+    bool shared_h = not args(0).is_cell();
+
+    // Problems, and the factors of their H's
+    std::vector<quadprog_turlach_problem> problems(n_problems);
+    std::vector<std::vector<double> >     factors;
+    std::vector<int>                      factor_size;
+
+    // Parse them
+    /* Octave objects are only touched here, outside the parallel region */
+    for (octave_idx_type p = 0; p < n_problems; ++p) {
+      // Arguments of this problem
+      octave_value_list p_args;
+      p_args.resize(args.length());
+      for (int a = 0; a < args.length(); ++a)
+        p_args(a) = args(a).is_cell() ? cells[a](p) : args(a);
+
+      // Parse
+      int _n_vars, _n_ineq, _n_eq;
+      Matrix _H;
+      SparseMatrix _Aineq, _Aeq;
+      ColumnVector _f, _bineq, _beq, _lb, _ub, _x;
+      Octave_map _opts;
+      parse_quadprog_args(p_args, _n_vars, _n_ineq,  _n_eq, _H, _f,
+                          _Aineq, _bineq, _Aeq, _beq, _lb, _ub,
+                          _x, _opts);
+
+      // Problem
+      quadprog_turlach_problem& problem = problems[p];
+      problem.n_vars = _n_vars;
+      problem.f.assign(_f.data(), _f.data() + _n_vars);
+      problem.sol.resize(_n_vars);
+
+      // Keep H, to be factored
+      if (p == 0 or not shared_h) {
+        const double* h = _H.data();
+        factors    .push_back(std::vector<double>(h, h + _n_vars * _n_vars));
+        factor_size.push_back(_n_vars);
+      }
+      problem.factor = factors.size() - 1;
+
+      // Constraints
+      build_constraints(problem.cons, _n_vars, _Aineq, _bineq, _Aeq, _beq,
+                        _lb, _ub);
+
+      // Guessed active set
+      if (p_args.length() > 8 and not p_args(8).is_zero_by_zero()) {
+        tight_active_set(problem.cons, _x.data(), problem.active);
+      }
+      else {
+        for (int e = 0; e < _n_eq; ++e)
+          problem.active.push_back(e);
+      }
+    }
+
+    // Factored?
+    std::vector<char> factored(factors.size());
+
+    // Factor every H
+#pragma omp parallel for num_threads(n_workers) schedule(dynamic)
+    for (int h = 0; h < int(factors.size()); ++h)
+      factored[h] = factor_hessian(&factors[h].front(), factor_size[h]);
+
+    // Solve every problem
+#pragma omp parallel num_threads(n_workers)
+    {
+      // Thread-private workspace
+      quadprog_turlach_workspace ws;
+
+#pragma omp for schedule(dynamic)
+      for (octave_idx_type p = 0; p < n_problems; ++p) {
+        quadprog_turlach_problem& problem = problems[p];
+        problem.warm = false;
+        if (factored[problem.factor])
+          problem.ierr = solve_problem(&factors[problem.factor].front(),
+                                       problem.n_vars, &problem.f.front(),
+                                       problem.cons, problem.active, ws,
+                                       &problem.sol.front(), problem.crval,
+                                       problem.iter, problem.warm);
+        else
+          problem.ierr = 2;
+      }
+    }
+
+    // Results
+    Cell x(problem_dims), fval(problem_dims), info(problem_dims);
+    for (octave_idx_type p = 0; p < n_problems; ++p) {
+      const quadprog_turlach_problem& problem = problems[p];
+
+      // Solution
+      ColumnVector sol(problem.n_vars);
+      std::copy(problem.sol.begin(), problem.sol.end(), sol.fortran_vec());
+
+      // Extract the fields
+      double      crval = problem.crval;
+      Octave_map  p_info;
+      switch (problem.ierr) {
+      case 0:
+        p_info.assign("iterations", problem.iter[0]);
+        p_info.assign("status", "optimal");
+        break;
+      case 1:
+        p_info.assign("status", "unbounded");
+        crval = -INFINITY;
+        break;
+      case 2:
+        p_info.assign("status", "non-decomposable");
+        crval = NAN;
+        break;
+      }
+      p_info.assign("warm_start", problem.warm);
+
+      // Set them
+      x   (p) = sol;
+      fval(p) = crval;
+      info(p) = p_info;
+    }
+
+    // Return
+    output.resize(3);
+    output(0) = x;
+    output(1) = fval;
+    output(2) = info;
   }
   // Was there an error?
   catch (const char* _error) {
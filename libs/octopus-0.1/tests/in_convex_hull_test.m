@@ -0,0 +1,79 @@
+%% Copyright (C) 2010 Edgar Gonzàlez i Pellicer <edgar.gip@gmail.com>
+%%
+%% This file is part of octopus-0.1.
+%%
+%% octopus is free software; you can redistribute it and/or modify it
+%% under the terms of the GNU General Public License as published by the
+%% Free Software Foundation; either version 3 of the License, or (at your
+%% option) any later version.
+%%
+%% octopus is distributed in the hope that it will be useful, but WITHOUT
+%% ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+%% FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+%% for more details.
+%%
+%% You should have received a copy of the GNU General Public License
+%% along with octopus; see the file COPYING.  If not, see
+%% <http://www.gnu.org/licenses/>.
+
+%% Test for in_convex_hull and the CGAL arithmetic option
+
+%% Load the package
+pkg load octopus;
+
+%% The unit square, against a grid of points, some of them outside its
+%% bounding box
+square     = [ 0 1 0 1 ; 0 0 1 1 ];
+[ gx, gy ] = meshgrid([ -0.5, 0.25, 0.5, 0.75, 1.5 ]);
+grid       = [ gx(:)' ; gy(:)' ];
+expected   = all(grid >= 0 & grid <= 1);
+for arithmetic = { "double", "filtered" }
+  opts = struct("arithmetic", arithmetic{1});
+  assert(in_convex_hull(square, grid, opts), expected);
+endfor
+
+%% A random set in three dimensions, with targets around it
+rand("seed", 31);
+set     = rand(3, 25);
+targets = [ 1.4 * rand(3, 60) - 0.2, set(:, 1 : 5), 0.5 * ones(3, 1) ];
+
+%% One call per point
+by_point = false(1, columns(targets));
+for i = 1 : columns(targets)
+  by_point(i) = in_convex_hull(set, targets(:, i));
+endfor
+assert(any(by_point));
+assert(!all(by_point));
+
+%% A batch, with one and with several workers, in both arithmetics
+for arithmetic = { "double", "filtered" }
+  for workers = [ 1, 4 ]
+    opts = struct("arithmetic", arithmetic{1}, "workers", workers);
+    assert(in_convex_hull(set, targets, opts), by_point);
+  endfor
+endfor
+
+%% Both arithmetics solve a small quadratic programme alike
+H  = [ 1 -1; -1 2 ];
+f  = [ -2; -6 ];
+A  = [ 1 1; -1 2; 2 1 ];
+b  = [ 2; 2; 3 ];
+lb = zeros(2, 1);
+[ x_d, fval_d ] = quadprog_cgal(H, f, A, b, [], [], lb, [], [], ...
+                                struct("arithmetic", "double"));
+[ x_f, fval_f ] = quadprog_cgal(H, f, A, b, [], [], lb, [], [], ...
+                                struct("arithmetic", "filtered"));
+assert(x_d,    [ 2 ; 4 ] / 3, 1e-8);
+assert(x_f,    [ 2 ; 4 ] / 3, 1e-8);
+assert(fval_f, fval_d, 1e-8);
+
+%% Unknown arithmetics are rejected
+fail("in_convex_hull(set, targets, struct(\"arithmetic\", \"exact\"))");
+fail("in_convex_hull(set, targets, struct(\"workers\", 0))");
+
+%% Display
+printf("in_convex_hull: OK\n");
+
+%% Local Variables:
+%% mode:octave
+%% End:
@@ -0,0 +1,99 @@
+%% Copyright (C) 2010 Edgar Gonzàlez i Pellicer <edgar.gip@gmail.com>
+%%
+%% This file is part of octopus-0.1.
+%%
+%% octopus is free software; you can redistribute it and/or modify it
+%% under the terms of the GNU General Public License as published by the
+%% Free Software Foundation; either version 3 of the License, or (at your
+%% option) any later version.
+%%
+%% octopus is distributed in the hope that it will be useful, but WITHOUT
+%% ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+%% FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+%% for more details.
+%%
+%% You should have received a copy of the GNU General Public License
+%% along with octopus; see the file COPYING.  If not, see
+%% <http://www.gnu.org/licenses/>.
+
+%% Test for quadprog_turlach_batch against one quadprog_turlach call per
+%% problem
+
+%% Load the package
+pkg load octopus;
+
+%% Random problems, sharing H and the constraints
+rand("seed", 23);
+n      = 12;
+n_prob = 9;
+M      = rand(n, n);
+H      = M' * M + eye(n);
+Aineq  = rand(4, n) - 0.5;
+bineq  = rand(4, 1);
+Aeq    = ones(1, n);
+beq    = 1;
+lb     = zeros(n, 1);
+ub     = 0.5 * ones(n, 1);
+fs     = cell(1, n_prob);
+for p = 1 : n_prob
+  fs{p} = rand(n, 1) - 0.5;
+endfor
+
+%% Compare a batch with a loop
+function check_batch(x, fval, info, Hs, fs, Aineqs, bineqs, Aeq, beq, lb, ub)
+  for p = 1 : numel(fs)
+    [ x_p, fval_p, info_p ] = ...
+        quadprog_turlach(Hs{p}, fs{p}, Aineqs{p}, bineqs{p}, ...
+                         Aeq, beq, lb, ub);
+    assert(info{p}.status, info_p.status);
+    if strcmp(info_p.status, "optimal")
+      assert(x{p},    x_p,    1e-10);
+      assert(fval{p}, fval_p, 1e-10);
+    else
+      assert(fval{p}, fval_p);
+    endif
+  endfor
+endfunction
+
+%% A shared H, with one and with several workers
+Hs      = repmat({ H },     1, n_prob);
+Aineqs  = repmat({ Aineq }, 1, n_prob);
+bineqs  = repmat({ bineq }, 1, n_prob);
+for workers = [ 1, 4 ]
+  [ x, fval, info ] = ...
+      quadprog_turlach_batch(H, fs, Aineq, bineq, Aeq, beq, lb, ub, [], ...
+                             struct("workers", workers));
+  assert(size(x), [ 1, n_prob ]);
+  check_batch(x, fval, info, Hs, fs, Aineqs, bineqs, Aeq, beq, lb, ub);
+endfor
+
+%% An H per problem, one of them not positive definite, and one problem
+%% without a feasible point (x(1) <= -1 and x(1) >= 1)
+for p = 1 : n_prob
+  M     = rand(n, n);
+  Hs{p} = M' * M + eye(n);
+endfor
+Hs{3}     = -eye(n);
+Aineqs{6} = [ Aineq ; eye(1, n) ; -eye(1, n) ];
+bineqs{6} = [ bineq ; -1 ; -1 ];
+[ x, fval, info ] = ...
+    quadprog_turlach_batch(Hs, fs, Aineqs, bineqs, Aeq, beq, lb, ub);
+check_batch(x, fval, info, Hs, fs, Aineqs, bineqs, Aeq, beq, lb, ub);
+assert(info{3}.status, "non-decomposable");
+assert(info{6}.status, "unbounded");
+assert(fval{6}, -Inf);
+for p = [ 1, 2, 4, 5, 7, 8, 9 ]
+  assert(info{p}.status, "optimal");
+endfor
+
+%% Bad batches
+fail("quadprog_turlach_batch(H, fs, Aineqs(1 : 2), bineq)");
+fail("quadprog_turlach_batch(H, fs{1}, Aineq, bineq)");
+fail("quadprog_turlach_batch(H, fs, Aineq, bineq, Aeq, beq, lb, ub, [], struct(\"workers\", 0))");
+
+%% Display
+printf("quadprog_turlach_batch: OK\n");
+
+%% Local Variables:
+%% mode:octave
+%% End:
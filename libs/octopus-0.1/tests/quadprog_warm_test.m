@@ -0,0 +1,94 @@
+%% Copyright (C) 2010 Edgar Gonzàlez i Pellicer <edgar.gip@gmail.com>
+%%
+%% This file is part of octopus-0.1.
+%%
+%% octopus is free software; you can redistribute it and/or modify it
+%% under the terms of the GNU General Public License as published by the
+%% Free Software Foundation; either version 3 of the License, or (at your
+%% option) any later version.
+%%
+%% octopus is distributed in the hope that it will be useful, but WITHOUT
+%% ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+%% FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+%% for more details.
+%%
+%% You should have received a copy of the GNU General Public License
+%% along with octopus; see the file COPYING.  If not, see
+%% <http://www.gnu.org/licenses/>.
+
+%% Test for the warm start of quadprog_turlach
+
+%% Load the package
+pkg load octopus;
+
+%% Tolerance
+tol = 1e-8;
+
+%% A random problem
+rand("seed", 17);
+n     = 40;
+M     = rand(n, n);
+H     = M' * M + eye(n);
+f     = rand(n, 1) - 0.5;
+Aineq = rand(10, n) - 0.5;
+bineq = rand(10, 1);
+Aeq   = ones(1, n);
+beq   = 1;
+lb    = zeros(n, 1);
+ub    = 0.2 * ones(n, 1);
+
+%% Cold start, keeping the handle
+[ x_cold, fval_cold, info_cold, qp ] = ...
+    quadprog_turlach(H, f, Aineq, bineq, Aeq, beq, lb, ub);
+assert(info_cold.status, "optimal");
+
+%% The same problem again, from the handle
+[ x_warm, fval_warm, info_warm ] = ...
+    quadprog_turlach(qp, f, Aineq, bineq, Aeq, beq, lb, ub);
+assert(info_warm.status, "optimal");
+assert(info_warm.warm_start);
+assert(x_warm, x_cold, tol);
+assert(fval_warm, fval_cold, tol);
+
+%% A perturbed linear term and an extra cut, warm and cold
+f2     = f + 0.01 * (rand(n, 1) - 0.5);
+Aineq2 = [ Aineq ; rand(1, n) - 0.5 ];
+bineq2 = [ bineq ; 0.05 ];
+[ x_warm2, fval_warm2, info_warm2 ] = ...
+    quadprog_turlach(qp, f2, Aineq2, bineq2, Aeq, beq, lb, ub);
+[ x_cold2, fval_cold2, info_cold2 ] = ...
+    quadprog_turlach(H,  f2, Aineq2, bineq2, Aeq, beq, lb, ub);
+assert(info_warm2.status, "optimal");
+assert(info_cold2.status, "optimal");
+assert(x_warm2, x_cold2, tol);
+assert(fval_warm2, fval_cold2, tol);
+
+%% A warm start from x0 on a fresh H
+[ x_x0, fval_x0, info_x0 ] = ...
+    quadprog_turlach(H, f, Aineq, bineq, Aeq, beq, lb, ub, x_cold);
+assert(info_x0.status, "optimal");
+assert(x_x0, x_cold, tol);
+
+%% Bounds only, one of them fixing a variable
+H3  = eye(3);
+f3  = [ -2 ; 1 ; -0.5 ];
+lb3 = [ 0 ; 0 ; 0.3 ];
+ub3 = [ 1 ; 1 ; 0.3 ];
+[ x3, fval3, info3 ] = quadprog_turlach(H3, f3, [], [], [], [], lb3, ub3);
+assert(info3.status, "optimal");
+assert(x3, [ 1 ; 0 ; 0.3 ], tol);
+assert(fval3, -1.605, tol);
+
+%% Other handles are not taken as a solver state, and the other way round
+if exist("istream_open")
+  is = istream_open("quadprog_warm_test.m");
+  fail("quadprog_turlach(is, f)");
+  fail("istream_readline(qp)");
+endif
+
+%% Display
+printf("quadprog_turlach warm start: OK\n");
+
+%% Local Variables:
+%% mode:octave
+%% End:
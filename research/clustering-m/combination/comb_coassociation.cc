@@ -0,0 +1,331 @@
+#include <octave/oct.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+
+/**************/
+/* Pair Lists */
+/**************/
+
+// Pairs of points sharing a cluster, with the number of clusterings
+// where they do so
+// Sorted by key (column * nData + row), so that they can be merged and
+// turned into a sparse matrix column by column
+struct pairList {
+  // Keys
+  vector<uint64_t> keys;
+
+  // Counts
+  vector<int> counts;
+
+  // Number of merges that made it (to merge lists of similar sizes)
+  int rank;
+};
+
+
+// Pairs of one clustering
+// Points are grouped by label first, so that only pairs sharing a
+// cluster are emitted, already in key order
+void clusteringPairs(pairList& pairs,
+                     const int* labels,
+                     int nData,
+                     int nLabels) {
+  // First member of each cluster
+  vector<int> start(nLabels + 1, 0);
+  for (int i = 0; i < nData; ++i)
+    ++start[labels[i] + 1];
+  for (int l = 0; l < nLabels; ++l)
+    start[l + 1] += start[l];
+
+  // Members of each cluster, in increasing order
+  vector<int> members(nData);
+  vector<int> next(start.begin(), start.end() - 1);
+  for (int i = 0; i < nData; ++i)
+    members[next[labels[i]]++] = i;
+
+  // Number of pairs
+  uint64_t nPairs = 0;
+  for (int l = 0; l < nLabels; ++l)
+    nPairs += uint64_t(start[l + 1] - start[l]) * (start[l + 1] - start[l]);
+
+  // Emit them, column by column
+  pairs.keys  .resize(nPairs);
+  pairs.counts.assign(nPairs, 1);
+  pairs.rank = 0;
+
+  uint64_t k = 0;
+  for (int j = 0; j < nData; ++j) {
+    int l = labels[j];
+    for (int p = start[l]; p < start[l + 1]; ++p)
+      pairs.keys[k++] = uint64_t(j) * nData + members[p];
+  }
+}
+
+
+// Renumber the labels of a clustering as 0..nLabels-1, keeping their
+// order (for clusterings with negative labels, such as the -1 of
+// unassigned points, or with labels far larger than their number)
+void compactLabels(int* labels,
+                   int nData,
+                   int& nLabels) {
+  // Distinct labels
+  vector<int> distinct(labels, labels + nData);
+  sort(distinct.begin(), distinct.end());
+  distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+
+  // Renumber
+  for (int i = 0; i < nData; ++i)
+    labels[i] = lower_bound(distinct.begin(), distinct.end(), labels[i]) -
+                distinct.begin();
+  nLabels = distinct.size();
+}
+
+
+// Merge two lists, adding the counts of the pairs in both
+void mergePairs(pairList& out,
+                const pairList& a,
+                const pairList& b) {
+  // Room for every pair
+  out.keys  .resize(a.keys.size() + b.keys.size());
+  out.counts.resize(a.keys.size() + b.keys.size());
+  out.rank = max(a.rank, b.rank) + 1;
+
+  // Merge
+  size_t ia = 0, ib = 0, k = 0;
+  while (ia < a.keys.size() && ib < b.keys.size()) {
+    if (a.keys[ia] < b.keys[ib]) {
+      out.keys  [k]   = a.keys  [ia];
+      out.counts[k++] = a.counts[ia++];
+    }
+    else if (b.keys[ib] < a.keys[ia]) {
+      out.keys  [k]   = b.keys  [ib];
+      out.counts[k++] = b.counts[ib++];
+    }
+    else {
+      out.keys  [k]   = a.keys  [ia];
+      out.counts[k++] = a.counts[ia++] + b.counts[ib++];
+    }
+  }
+
+  // Remains
+  for (; ia < a.keys.size(); ++ia, ++k) {
+    out.keys  [k] = a.keys  [ia];
+    out.counts[k] = a.counts[ia];
+  }
+  for (; ib < b.keys.size(); ++ib, ++k) {
+    out.keys  [k] = b.keys  [ib];
+    out.counts[k] = b.counts[ib];
+  }
+
+  // Trim
+  out.keys  .resize(k);
+  out.counts.resize(k);
+}
+
+
+// Merge the last two lists of a stack
+void mergeTop(vector<pairList>& stack) {
+  // Merge
+  pairList merged;
+  mergePairs(merged, stack[stack.size() - 2], stack[stack.size() - 1]);
+
+  // Replace them
+  stack.pop_back();
+  stack.back().keys  .swap(merged.keys);
+  stack.back().counts.swap(merged.counts);
+  stack.back().rank = merged.rank;
+}
+
+
+// Co-association of every clustering
+// Each thread merges the lists of its clusterings as they come (keeping
+// a stack of lists of increasing size), and the lists of the threads
+// are merged pairwise at the end
+void coassociation(pairList& result,
+                   const vector<int>& labels,
+                   const vector<int>& nLabels,
+                   int nData) {
+  // Number of clusterings
+  int nClusterings = nLabels.size();
+
+  // Number of threads
+  int nThreads = 1;
+#ifdef _OPENMP
+  nThreads = omp_get_max_threads();
+#endif
+
+  // List of each thread
+  vector<pairList> threadLists(nThreads);
+  for (int t = 0; t < nThreads; ++t)
+    threadLists[t].rank = 0;
+
+#pragma omp parallel num_threads(nThreads)
+  {
+    // Stack of lists
+    vector<pairList> stack;
+
+    // For every clustering
+#pragma omp for schedule(dynamic)
+    for (int f = 0; f < nClusterings; ++f) {
+      // Its pairs
+      stack.push_back(pairList());
+      clusteringPairs(stack.back(), &labels[f * nData], nData, nLabels[f]);
+
+      // Merge lists of the same rank
+      while (stack.size() > 1 &&
+             stack[stack.size() - 2].rank == stack.back().rank)
+        mergeTop(stack);
+    }
+
+    // Merge what is left
+    while (stack.size() > 1)
+      mergeTop(stack);
+
+    // Keep it
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    if (!stack.empty()) {
+      threadLists[thread].keys  .swap(stack.back().keys);
+      threadLists[thread].counts.swap(stack.back().counts);
+    }
+  }
+
+  // Merge the threads pairwise
+  for (int step = 1; step < nThreads; step *= 2) {
+#pragma omp parallel for schedule(dynamic)
+    for (int t = 0; t < nThreads - step; t += 2 * step) {
+      pairList merged;
+      mergePairs(merged, threadLists[t], threadLists[t + step]);
+      threadLists[t].keys  .swap(merged.keys);
+      threadLists[t].counts.swap(merged.counts);
+      vector<uint64_t>().swap(threadLists[t + step].keys);
+      vector<int>     ().swap(threadLists[t + step].counts);
+    }
+  }
+
+  // Result
+  result.keys  .swap(threadLists[0].keys);
+  result.counts.swap(threadLists[0].counts);
+  result.rank = 0;
+}
+
+
+
+/*******************/
+/* Octave-C++ Glue */
+/*******************/
+
+// Find the co-association matrix
+DEFUN_DLD(comb_coassociation, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {Matrix =} comb_coassociation(@var{clusterings} [, @var{minCount}])\n\
+\n\
+Find the co-association matrix of several clusterings.\n\
+\n\
+@var{clusterings} has a row per point and a column per clustering,\n\
+holding integer labels. Points with the same label share a cluster,\n\
+the -1 of unassigned points included, as in @code{comb_sharing_matrix}.\n\
+The result is a sparse matrix whose (i, j) entry is the number of\n\
+clusterings where i and j share a cluster, keeping only the entries\n\
+reaching @var{minCount} (1).\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() < 1 || args.length() > 2 || nargout > 1) {
+    print_usage("comb_coassociation");
+    return octave_value_list();
+  }
+
+  // Check types of arguments
+  if (!args(0).is_real_matrix()) {
+    error("CLUSTERINGS should be a matrix");
+    return octave_value_list();
+  }
+
+  if (args.length() > 1 && !args(1).is_real_scalar()) {
+    error("MINCOUNT should be a scalar");
+    return octave_value_list();
+  }
+
+  // Clusterings
+  Matrix clusterings = args(0).matrix_value();
+  int nData        = clusterings.rows();
+  int nClusterings = clusterings.cols();
+
+  // Minimum count
+  double minCount = args.length() > 1 ? args(1).double_value() : 1.0;
+
+  // Integer labels, and number of labels of each clustering
+  vector<int> labels(max(nData * nClusterings, 1));
+  vector<int> nLabels(nClusterings, 0);
+  for (int f = 0; f < nClusterings; ++f) {
+    int minLabel = 0;
+    for (int i = 0; i < nData; ++i) {
+      double value = clusterings(i, f);
+      if (value != floor(value) || fabs(value) > 2e9) {
+        error("CLUSTERINGS should hold integer labels");
+        return octave_value_list();
+      }
+      labels[f * nData + i] = int(value);
+      nLabels[f] = max(nLabels[f], int(value) + 1);
+      minLabel   = min(minLabel,   int(value));
+    }
+
+    // Negative or too many labels?
+    if (minLabel < 0 || nLabels[f] > nData)
+      compactLabels(&labels[f * nData], nData, nLabels[f]);
+  }
+
+  // Accumulate
+  pairList pairs;
+  coassociation(pairs, labels, nLabels, nData);
+
+  // Kept entries
+  octave_idx_type nnz = 0;
+  for (size_t k = 0; k < pairs.keys.size(); ++k)
+    if (pairs.counts[k] >= minCount)
+      ++nnz;
+
+  // Build the matrix, column by column
+  SparseMatrix result(nData, nData, nnz);
+  octave_idx_type* cidx = result.cidx();
+  octave_idx_type* ridx = result.ridx();
+  double*          data = result.data();
+
+  octave_idx_type nz  = 0;
+  octave_idx_type col = 0;
+  cidx[0] = 0;
+  for (size_t k = 0; k < pairs.keys.size(); ++k) {
+    // Below the threshold?
+    if (pairs.counts[k] < minCount)
+      continue;
+
+    // Close the previous columns
+    octave_idx_type j = pairs.keys[k] / nData;
+    while (col < j)
+      cidx[++col] = nz;
+
+    // Add it
+    ridx[nz] = pairs.keys[k] % nData;
+    data[nz] = pairs.counts[k];
+    ++nz;
+  }
+  while (col < nData)
+    cidx[++col] = nz;
+
+  // Return
+  octave_value_list output;
+  output.resize(1);
+  output(0) = octave_value(result);
+  return output;
+}
@@ -27,10 +27,13 @@ function Eigen = comb_combine_binary (varargin)
     end
   end
 
-  %% Create the binary matrix
-  CM = comb_binary_matrix (target{:});
+  %% The co-association matrix over the number of clusterings, which is
+  %% CM * CM' for the (normalized) binary matrix CM of comb_binary_matrix
+  Clusterings = [ target{1 : 2 : end} ];
+  [ nelems nclust ] = size(Clusterings);
+  CC = comb_coassociation(Clusterings) / nclust;
 
   %% Find the eigenvalues
-  Eigen = eig(CM * CM');
+  Eigen = eig(full(CC));
 
 % end function
@@ -27,10 +27,10 @@ function Combination = comb_combine_itmedian (nclusters, varargin)
     end
   end
 
-  %% Create the multinomial matrix
-  CM = comb_itmedian_matrix (target{:});
+  %% Create the label matrix
+  CM = comb_multinomial_matrix (target{:});
 
-  %% Find k means clustering
-  Combination = weak_kmeans(nclusters, CM);
+  %% Find the median partition
+  Combination = comb_itmedian(CM, nclusters);
 
 % end function
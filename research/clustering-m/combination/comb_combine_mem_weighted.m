@@ -16,12 +16,10 @@ function [ Lls Sizes Models ] = comb_combine_mem_weighted (Nclusters, varargin)
     %% Type of current
     curType = typeinfo(varargin{i});
     if strcmp(curType, 'string')
-      %% A file, load it
-      [ C k ] = read_clustering(varargin{i});
-      target{t}   = C;
-      target{t+1} = k;
+      %% A file, loaded by comb_mem_labels
+      target{t} = varargin{i};
       i = i + 1;
-      t = t + 2;
+      t = t + 1;
 
     else
       %% A matrix
@@ -36,12 +34,11 @@ function [ Lls Sizes Models ] = comb_combine_mem_weighted (Nclusters, varargin)
   [ nfeats dummy ] = size(Weights);
   Weights = Weights * nfeats / sum(Weights);
 
-  %% Create the multinomial matrix
-  [ CM KM ] = comb_multinomial_matrix (target{:});
+  %% Create the label matrix
+  [ CM KM elems ] = comb_mem_labels(target{:});
 
   %% Delta threshold
-  [ elems dummy ] = size(CM);
-  deltaTh         = 1e-8 * elems;
+  deltaTh = 1e-8 * elems;
 
   %% Automatically find sizes?
   if Nclusters == 0
@@ -57,52 +54,25 @@ function [ Lls Sizes Models ] = comb_combine_mem_weighted (Nclusters, varargin)
   Lls    = zeros(tests, 1);
   Models = {};
 
+  %% EM options (five random starts, run natively, each one until it
+  %% converges: comb_mem_fit would stop it after 1000 iterations)
+  opts.restarts       = 5;
+  opts.delta          = deltaTh;
+  opts.max_iterations = Inf;
+  opts.weights        = Weights;
+
   %% Try
   for i = 1:tests
-    %% Local best
-    localBestLl = -1e100;
-    avgLl       = 0.0;
-
-    for j = 1:5
-      %% Random starting model
-      model = comb_mem_initialize(Nclusters(i), KM);
-      model = comb_mem_addweight(model, Weights);
-
-      %% Initial expectation
-      Exp = comb_mem_expectation(model, CM);
-
-      %% Maximization
-      do
-        OExp  = Exp;
-        model = comb_mem_maximization(CM, KM, Exp);
-        model = comb_mem_addweight(model, Weights);
-        Exp   = comb_mem_expectation(model, CM);
-        delta = sum(sum((Exp - OExp) .^ 2));
-      until (delta < deltaTh)
-
-      %% Result
-      [ Max Idx ] = max(Exp');
-      Combi = Idx' - 1;
-
-      %% Log-likelihood
-      ll = comb_mem_loglike(model, CM);
-
-      %% Average
-      avgLl = avgLl + ll;
-
-      %% Is it the local best?
-      if ll > localBestLl
-        localBest   = Combi;
-        localBestLl = ll;
-      end
-    end
+    %% Fit, keeping the best start
+    [ model Exp llikes ] = comb_mem_fit(CM, KM, Nclusters(i), opts);
 
-    %% Average
-    avgLl = avgLl / 5;
+    %% Result
+    [ Max Idx ] = max(Exp');
+    Combi = Idx' - 1;
 
-    %% Add it
-    Lls(i)    = avgLl;
-    Models{i} = localBest;
+    %% Add it (with the average log-likelihood)
+    Lls(i)    = mean(llikes);
+    Models{i} = Combi;
   end
 
   %% Sizes
@@ -0,0 +1,390 @@
+#include <octave/oct.h>
+#include <octave/oct-map.h>
+#include <octave/parse.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+
+/********************/
+/* Median Functions */
+/********************/
+
+// Every point is kept as the row of its labels in each clustering
+// (point-major, i * nFeats + f), as bytes when every clustering has at
+// most 256 clusters, so that comparing a point with a prototype is a
+// run of byte comparisons
+
+
+// Number of clusterings where a point and a prototype disagree
+template <typename T>
+inline int disagreement(const T* point,
+                        const T* proto,
+                        int nFeats) {
+  int count = 0;
+#pragma omp simd reduction(+:count)
+  for (int f = 0; f < nFeats; ++f)
+    count += point[f] != proto[f];
+  return count;
+}
+
+
+// Assign every point to its closest prototype
+// A point only moves when another prototype is strictly closer
+// Returns the number of points that moved
+template <typename T>
+int assignPoints(int* clustering,
+                 double& cost,
+                 const T* labels,
+                 const T* protos,
+                 int nData,
+                 int nFeats,
+                 int nClust) {
+  // Changes and cost
+  int    changes = 0;
+  double total   = 0.0;
+
+#pragma omp parallel for schedule(static) reduction(+:changes,total)
+  for (int i = 0; i < nData; ++i) {
+    const T* point = labels + i * nFeats;
+
+    // Current one
+    int best     = clustering[i];
+    int bestDist = best >= 0 ?
+      disagreement(point, protos + best * nFeats, nFeats) : INT_MAX;
+
+    // Closer ones
+    for (int c = 0; c < nClust; ++c) {
+      int dist = disagreement(point, protos + c * nFeats, nFeats);
+      if (dist < bestDist) {
+        best     = c;
+        bestDist = dist;
+      }
+    }
+
+    // Moved?
+    if (best != clustering[i]) {
+      clustering[i] = best;
+      ++changes;
+    }
+    total += bestDist;
+  }
+
+  // Return
+  cost = total;
+  return changes;
+}
+
+
+// Move every prototype to the median of its points
+// (the most frequent label in each clustering)
+// A label only changes when another one is strictly more frequent, and
+// prototypes of empty clusters are kept
+// Each thread counts the labels of a slice of points into its own
+// tables, and the tables are summed at the end
+template <typename T>
+void updatePrototypes(T* protos,
+                      const T* labels,
+                      const int* clustering,
+                      const vector<int>& offset,
+                      int nData,
+                      int nFeats,
+                      int nClust) {
+  // Counts of each cluster (label v of clustering f at offset[f] + v)
+  int nValues = offset[nFeats];
+  int nCounts = nClust * nValues;
+
+  // Number of threads
+  int nThreads = 1;
+#ifdef _OPENMP
+  nThreads = omp_get_max_threads();
+#endif
+
+  // Thread counts
+  vector< vector<int> > threadCounts(nThreads);
+
+  // Reduced counts
+  vector<int> counts(nCounts);
+
+#pragma omp parallel num_threads(nThreads)
+  {
+    // Slice of points
+    int thread = 0, nActive = 1;
+#ifdef _OPENMP
+    thread  = omp_get_thread_num();
+    nActive = omp_get_num_threads();
+#endif
+    int first = int((long(nData) * thread)       / nActive);
+    int last  = int((long(nData) * (thread + 1)) / nActive);
+
+    // Private counts
+    vector<int>& myCounts = threadCounts[thread];
+    myCounts.assign(nCounts, 0);
+
+    // Count
+    for (int i = first; i < last; ++i) {
+      const T* point = labels + i * nFeats;
+      int*     table = &myCounts[clustering[i] * nValues];
+      for (int f = 0; f < nFeats; ++f)
+        ++table[offset[f] + point[f]];
+    }
+
+    // Wait for every thread
+#pragma omp barrier
+
+    // Sum the counts of the threads that took part
+#pragma omp for schedule(static)
+    for (int k = 0; k < nCounts; ++k) {
+      int sum = 0;
+      for (int t = 0; t < nActive; ++t)
+        sum += threadCounts[t][k];
+      counts[k] = sum;
+    }
+
+    // Most frequent labels
+#pragma omp for schedule(static)
+    for (int c = 0; c < nClust; ++c)
+      for (int f = 0; f < nFeats; ++f) {
+        const int* table = &counts[c * nValues + offset[f]];
+        int best      = protos[c * nFeats + f];
+        int bestCount = table[best];
+        for (int v = 0; v < offset[f + 1] - offset[f]; ++v)
+          if (table[v] > bestCount) {
+            best      = v;
+            bestCount = table[v];
+          }
+        protos[c * nFeats + f] = best;
+      }
+  }
+}
+
+
+// Iterate until the partition is stable
+// Returns the number of iterations
+template <typename T>
+int itMedian(int* clustering,
+             double& cost,
+             T* protos,
+             const T* labels,
+             const vector<int>& offset,
+             int nData,
+             int nFeats,
+             int nClust,
+             int maxIters) {
+  // Initial assignment
+  for (int i = 0; i < nData; ++i)
+    clustering[i] = -1;
+  assignPoints(clustering, cost, labels, protos, nData, nFeats, nClust);
+
+  // Loop
+  int iter = 0;
+  while (iter < maxIters) {
+    ++iter;
+    updatePrototypes(protos, labels, clustering, offset,
+                     nData, nFeats, nClust);
+    if (!assignPoints(clustering, cost, labels, protos,
+                      nData, nFeats, nClust))
+      break;
+  }
+
+  // Return
+  return iter;
+}
+
+
+// Load the labels, run, and write the prototypes back
+// The -1 labels of clustering f are kept as label unassigned[f]
+template <typename T>
+int itMedian(Matrix& clustering,
+             Matrix& prototypes,
+             double& cost,
+             const Matrix& data,
+             const vector<int>& offset,
+             const vector<int>& unassigned,
+             const vector<int>& start,
+             int maxIters) {
+  // Sizes
+  int nData  = data.rows();
+  int nFeats = data.cols();
+  int nClust = start.size();
+
+  // Labels and prototypes
+  vector<T> labels(max(nData * nFeats, 1));
+  for (int f = 0; f < nFeats; ++f)
+    for (int i = 0; i < nData; ++i)
+      labels[i * nFeats + f] = data(i, f) == -1 ?
+        T(unassigned[f]) : T(data(i, f));
+
+  vector<T> protos(max(nClust * nFeats, 1));
+  for (int c = 0; c < nClust; ++c)
+    for (int f = 0; f < nFeats; ++f)
+      protos[c * nFeats + f] = labels[start[c] * nFeats + f];
+
+  // Run
+  vector<int> assigned(max(nData, 1));
+  int iters = itMedian(&assigned[0], cost, &protos[0], &labels[0], offset,
+                       nData, nFeats, nClust, maxIters);
+
+  // Write back
+  for (int i = 0; i < nData; ++i)
+    clustering(i) = assigned[i];
+  for (int c = 0; c < nClust; ++c)
+    for (int f = 0; f < nFeats; ++f)
+      prototypes(c, f) = protos[c * nFeats + f] == unassigned[f] ?
+        -1 : protos[c * nFeats + f];
+
+  // Return
+  return iters;
+}
+
+
+
+/*******************/
+/* Octave-C++ Glue */
+/*******************/
+
+// Find the median partition
+DEFUN_DLD(comb_itmedian, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {[@var{Clustering}, @var{Prototypes}, @var{Cost}, @var{Iterations}] =} comb_itmedian(@var{clusterings}, @var{nclusters} [, @var{opts}])\n\
+\n\
+Find a consensus partition of several clusterings by iterative medians.\n\
+\n\
+@var{clusterings} has a row per point and a column per clustering,\n\
+holding 0-based labels, or -1 for unassigned points, which are taken\n\
+as one more label of their clustering. Starting from @var{nclusters}\n\
+random points, each point is assigned to the prototype it disagrees\n\
+with in the fewest clusterings, and each prototype is moved to the\n\
+most frequent label of its points in every clustering, until no point\n\
+moves.\n\
+\n\
+@var{Clustering} holds the 0-based cluster of every point,\n\
+@var{Prototypes} the label rows of the prototypes, and @var{Cost} the\n\
+total number of disagreements.\n\
+\n\
+Options:\n\
+@table @code\n\
+@item max_iterations\n\
+Maximum number of iterations (1000).\n\
+@end table\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() < 2 || args.length() > 3 || nargout > 4) {
+    print_usage("comb_itmedian");
+    return octave_value_list();
+  }
+
+  // Check types of arguments
+  if (!args(0).is_real_matrix()) {
+    error("CLUSTERINGS should be a matrix");
+    return octave_value_list();
+  }
+
+  if (!args(1).is_real_scalar()) {
+    error("NCLUSTERS should be a scalar");
+    return octave_value_list();
+  }
+
+  if (args.length() > 2 && !args(2).is_map()) {
+    error("OPTS should be a struct");
+    return octave_value_list();
+  }
+
+  // Clusterings
+  Matrix data   = args(0).matrix_value();
+  int    nData  = data.rows();
+  int    nFeats = data.cols();
+  int    nClust = args(1).int_value();
+
+  if (nClust < 1 || nClust > nData) {
+    error("NCLUSTERS should be between 1 and the number of points");
+    return octave_value_list();
+  }
+
+  // Maximum number of iterations
+  int maxIters = 1000;
+  if (args.length() > 2) {
+    Octave_map opts = args(2).map_value();
+    Octave_map::const_iterator it = opts.seek("max_iterations");
+    if (it != opts.end()) {
+      if (!opts.contents(it)(0).is_real_scalar()) {
+        error("OPTS.max_iterations should be a number");
+        return octave_value_list();
+      }
+      maxIters = opts.contents(it)(0).int_value();
+    }
+  }
+
+  // Number of labels of each clustering, with a slot after them for -1
+  // (if it is used)
+  vector<int> offset(nFeats + 1, 0), unassigned(nFeats, -1);
+  int maxLabels = 0;
+  for (int f = 0; f < nFeats; ++f) {
+    int nLabels = 0;
+    for (int i = 0; i < nData; ++i) {
+      double value = data(i, f);
+      if (value < -1 || value >= 65536 || value != floor(value)) {
+        error("CLUSTERINGS should hold integer labels between -1 and 65535");
+        return octave_value_list();
+      }
+      if (int(value) >= nLabels)
+        nLabels = int(value) + 1;
+    }
+    for (int i = 0; i < nData; ++i)
+      if (data(i, f) == -1) {
+        unassigned[f] = nLabels++;
+        break;
+      }
+    if (nLabels > 65536) {
+      error("CLUSTERINGS with -1 labels should hold labels below 65535");
+      return octave_value_list();
+    }
+    offset[f + 1] = offset[f] + nLabels;
+    if (nLabels > maxLabels)
+      maxLabels = nLabels;
+  }
+
+  // Random starting points
+  octave_value_list permArgs;
+  permArgs(0) = octave_value(nData);
+  octave_value_list perm = feval("randperm", permArgs, 1);
+  if (error_state)
+    return octave_value_list();
+
+  Matrix      permutation = perm(0).matrix_value();
+  vector<int> start(nClust);
+  for (int c = 0; c < nClust; ++c)
+    start[c] = int(permutation(c)) - 1;
+
+  // Results
+  Matrix clustering(nData, 1);
+  Matrix prototypes(nClust, nFeats);
+  double cost;
+  int    iters;
+
+  // Run, with bytes if they are enough
+  if (maxLabels <= 256)
+    iters = itMedian<uint8_t>(clustering, prototypes, cost,
+                              data, offset, unassigned, start, maxIters);
+  else
+    iters = itMedian<uint16_t>(clustering, prototypes, cost,
+                               data, offset, unassigned, start, maxIters);
+
+  // Return
+  octave_value_list output;
+  output.resize(4);
+  output(0) = octave_value(clustering);
+  output(1) = octave_value(prototypes);
+  output(2) = octave_value(cost);
+  output(3) = octave_value(iters);
+  return output;
+}
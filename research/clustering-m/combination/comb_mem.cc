@@ -1,107 +1,348 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
 #include <octave/oct.h>
+#include <octave/parse.h>
 #include <octave/ov-struct.h>
 #include <octave/version.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-/****************/
-/* EM Functions */
-/****************/
+#include "octave_c_ptr_value.h"
+#include "read_clustering.h"
 
-// Expectation step
-void eStep(Matrix& expectation,
-           Matrix& data,
-           Matrix& alpha,
-           Matrix* coefs) {
 
-#ifdef DEBUG
-  // DEBUG
-  printf("E Step\n");
-#endif
+/******************/
+/* Label Matrices */
+/******************/
 
-  // Find useful sizes
-  int nData  = data.rows();
-  int nFeats = data.cols();
-  int nClust = alpha.rows();
+// Labels of every point in every clustering
+// Kept twice, feature-major for the M-step and point-major for the
+// E-step, as uint16 when every feature fits and as uint32 otherwise
+struct combLabels {
+  // Number of points and features
+  int nData;
+  int nFeats;
 
-  // For every point
-  for (int i = 0; i < nData; ++i) {
-    // Total (for normalization)
-    double total = 0.0;
+  // Number of values of each feature
+  std::vector<int> sizes;
 
-    // Find the possibility for each multinomial
-    for (int c = 0; c < nClust; ++c) {
-      // Prior
-      double val = alpha(c);
+  // Stored as uint32?
+  bool wide;
+
+  // Feature-major (f * nData + i) and point-major (i * nFeats + f) labels
+  std::vector<uint16_t> narrowF, narrowP;
+  std::vector<uint32_t> wideF,   wideP;
+};
+
+// Label matrix handle
+typedef octave_c_pointer_value<combLabels> combLabelsValue;
+octave_c_pointer_static(combLabels, "comb_mem_labels");
+
+
+// Size the labels
+void initLabels(combLabels& labels,
+                int nData,
+                const std::vector<int>& sizes) {
+  // Sizes
+  labels.nData  = nData;
+  labels.nFeats = sizes.size();
+  labels.sizes  = sizes;
+
+  // Does every feature fit in 16 bits?
+  labels.wide = false;
+  for (int f = 0; f < labels.nFeats; ++f)
+    if (sizes[f] > 65536)
+      labels.wide = true;
+
+  // Reserve (at least one, so that the front can always be taken)
+  int nLabels = std::max(nData * labels.nFeats, 1);
+  if (labels.wide) {
+    labels.wideF.resize(nLabels);
+    labels.wideP.resize(nLabels);
+  }
+  else {
+    labels.narrowF.resize(nLabels);
+    labels.narrowP.resize(nLabels);
+  }
+}
+
+
+// Set a label in both layouts
+inline void setLabel(combLabels& labels,
+                     int i, int f, unsigned int value) {
+  if (labels.wide) {
+    labels.wideF[f * labels.nData + i]  = value;
+    labels.wideP[i * labels.nFeats + f] = value;
+  }
+  else {
+    labels.narrowF[f * labels.nData + i]  = value;
+    labels.narrowP[i * labels.nFeats + f] = value;
+  }
+}
 
-      // Multinomial components
-      for (int f = 0; f < nFeats; ++f) {
-        val *= coefs[f](c, int(data(i, f)));
-      }
 
-      // Add to matrix and total
-      expectation(i, c) = val;
-      total += val;
+// Add a column of a matrix as the labels of feature f
+// Returns false (after reporting an error) if some label is not an
+// integer in 0..sizes[f]-1
+bool setColumn(combLabels& labels,
+               const Matrix& data,
+               int col, int f) {
+  for (int i = 0; i < labels.nData; ++i) {
+    double value = data(i, col);
+    if (value < 0 || value >= labels.sizes[f] || value != floor(value)) {
+      error("DATA should hold integer labels between 0 and k-1");
+      return false;
     }
+    setLabel(labels, i, f, (unsigned int)value);
+  }
+
+  // Fine
+  return true;
+}
+
+
+// Get a data argument, either a handle or a matrix
+// A matrix is converted into tmpLabels, checking it against sizes
+// Returns 0 (after reporting an error) if it is neither, or if it
+// does not match sizes
+combLabels* getLabels(const octave_value& arg,
+                      combLabels& tmpLabels,
+                      const std::vector<int>& sizes) {
+  // Labels
+  combLabels* labels = &tmpLabels;
+
+  // A handle?
+  if (combLabelsValue* value = combLabelsValue::cast(arg)) {
+    // Defined?
+    if (!value->is_defined()) {
+      error("DATA cannot be null");
+      return 0;
+    }
+    labels = &value->data();
+  }
+  else {
+    // A matrix?
+    if (!arg.is_real_matrix()) {
+      error("DATA should be a matrix or a comb_mem_labels handle");
+      return 0;
+    }
+    Matrix data = arg.matrix_value();
+
+    // Check the number of features
+    if (data.cols() != int(sizes.size())) {
+      error("DATA does not have the expected number of features");
+      return 0;
+    }
+
+    // Convert it
+    initLabels(tmpLabels, data.rows(), sizes);
+    for (int f = 0; f < tmpLabels.nFeats; ++f)
+      if (!setColumn(tmpLabels, data, f, f))
+        return 0;
+  }
+
+  // Check the features
+  if (labels->nFeats != int(sizes.size()) || labels->nFeats == 0) {
+    error("DATA does not have the expected number of features");
+    return 0;
+  }
+  for (int f = 0; f < labels->nFeats; ++f)
+    if (labels->sizes[f] > sizes[f]) {
+      error("DATA has more values than expected for some feature");
+      return 0;
+    }
+
+  // Fine
+  return labels;
+}
+
+
+/****************/
+/* EM Functions */
+/****************/
+
+// Log-probability tables
+// Built once per step, so that the probability of each point is found
+// by table lookups and additions, without underflowing when there are
+// many features
+struct logTables {
+  // Number of clusters
+  int nClust;
+
+  // Log-priors (nClust)
+  std::vector<double> logAlpha;
+
+  // weights(f) * log(coefs[f](c, v)), at offset[f] + v * nClust + c
+  std::vector<double> table;
+
+  // First entry of each feature
+  std::vector<int> offset;
+};
+
+
+// Build the tables
+// weights is 0 for unweighted models
+void buildTables(logTables& tables,
+                 Matrix& alpha,
+                 Matrix* coefs,
+                 int nFeats,
+                 Matrix* weights) {
+  // Clusters
+  int nClust = alpha.rows();
+  tables.nClust = nClust;
+
+  // Log-priors
+  tables.logAlpha.resize(nClust);
+  for (int c = 0; c < nClust; ++c)
+    tables.logAlpha[c] = log(alpha(c));
+
+  // Offsets
+  tables.offset.resize(nFeats + 1);
+  tables.offset[0] = 0;
+  for (int f = 0; f < nFeats; ++f)
+    tables.offset[f + 1] = tables.offset[f] + coefs[f].cols() * nClust;
 
-    // Normalize
-    if (total != 0.0)
+  // Weighted log-coefficients
+  // A zero-weight feature adds nothing, even where its coefficient is
+  // zero (pow(0, 0) = 1, but 0 * log(0) would be NaN)
+  tables.table.resize(tables.offset[nFeats]);
+  for (int f = 0; f < nFeats; ++f) {
+    double  w     = weights ? (*weights)(f) : 1.0;
+    double* entry = &tables.table[tables.offset[f]];
+    for (int v = 0; v < coefs[f].cols(); ++v)
       for (int c = 0; c < nClust; ++c)
-        expectation(i, c) /= total;
+        *entry++ = w == 0.0 ? 0.0 : w * log(coefs[f](c, v));
+  }
+}
+
+
+// Log-probability of a point for each cluster
+// Returns the maximum
+template <typename T>
+inline double pointLogProbs(double* logProbs,
+                            const logTables& tables,
+                            const T* labels,
+                            int nFeats) {
+  // Start from the priors
+  int nClust = tables.nClust;
+  for (int c = 0; c < nClust; ++c)
+    logProbs[c] = tables.logAlpha[c];
+
+  // Add each feature
+  for (int f = 0; f < nFeats; ++f) {
+    const double* entry = &tables.table[tables.offset[f] +
+                                        labels[f] * nClust];
+    for (int c = 0; c < nClust; ++c)
+      logProbs[c] += entry[c];
   }
+
+  // Maximum
+  double maxLogProb = -INFINITY;
+  for (int c = 0; c < nClust; ++c)
+    if (logProbs[c] > maxLogProb)
+      maxLogProb = logProbs[c];
+  return maxLogProb;
 }
 
 
 // Expectation step
-// Weighted
-void eStepW(Matrix& expectation,
-            Matrix& data,
-            Matrix& alpha,
-            Matrix* coefs,
-            Matrix& weights) {
+// labels is point-major
+// Returns the log-likelihood, found on the way
+template <typename T>
+double eStep(Matrix& expectation,
+             const T* labels,
+             int nData,
+             int nFeats,
+             const logTables& tables) {
 
 #ifdef DEBUG
   // DEBUG
-  printf("E Step W\n");
+  printf("E Step\n");
 #endif
 
   // Find useful sizes
-  int nData  = data.rows();
-  int nFeats = data.cols();
-  int nClust = alpha.rows();
+  int nClust = tables.nClust;
 
-  // For every point
-  for (int i = 0; i < nData; ++i) {
-    // Total (for normalization)
-    double total = 0.0;
+  // Raw arrays
+  double* rawExp = expectation.fortran_vec();
 
-    // Find the possibility for each multinomial
-    for (int c = 0; c < nClust; ++c) {
-      // Prior
-      double val = alpha(c);
+  // Total
+  double llike = 0.0;
 
-      // Multinomial components
-      for (int f = 0; f < nFeats; ++f) {
-        val *= pow(coefs[f](c, int(data(i, f))), weights(f));
+#pragma omp parallel reduction(+:llike)
+  {
+    // Log-probabilities of the current point
+    std::vector<double> logProbs(nClust);
+
+    // For every point
+#pragma omp for schedule(static)
+    for (int i = 0; i < nData; ++i) {
+      // Find the log-possibility for each multinomial
+      double maxLogProb = pointLogProbs(&logProbs[0], tables,
+                                        labels + i * nFeats, nFeats);
+
+      // Impossible for every cluster?
+      // (Its row is zeroed, as the buffer may hold a previous iteration)
+      if (maxLogProb == -INFINITY) {
+        for (int c = 0; c < nClust; ++c)
+          rawExp[i + c * nData] = 0.0;
+        llike += -INFINITY;
+        continue;
       }
 
-      // Add to matrix and total
-      expectation(i, c) = val;
-      total += val;
-    }
+      // Log-sum-exp
+      double total = 0.0;
+      for (int c = 0; c < nClust; ++c) {
+        logProbs[c] = exp(logProbs[c] - maxLogProb);
+        total      += logProbs[c];
+      }
 
-    // Normalize
-    if (total != 0.0)
+      // Normalize
       for (int c = 0; c < nClust; ++c)
-        expectation(i, c) /= total;
+        rawExp[i + c * nData] = logProbs[c] / total;
+
+      // Add to the log-likelihood
+      llike += maxLogProb + log(total);
+    }
   }
+
+  // Return it
+  return llike;
+}
+
+
+// Expectation step (on either layout width)
+double eStep(Matrix& expectation,
+             const combLabels& labels,
+             const logTables& tables) {
+  if (labels.wide)
+    return eStep(expectation, &labels.wideP[0],
+                 labels.nData, labels.nFeats, tables);
+  else
+    return eStep(expectation, &labels.narrowP[0],
+                 labels.nData, labels.nFeats, tables);
 }
 
 
 // Maximization step
+// Each thread adds the expectations of a slice of points into its own
+// count tables, feature by feature, and the tables are summed at the end
+// labels is feature-major
+template <typename T>
 void mStep(Matrix& alpha,
            Matrix* coefs,
-           Matrix& data,
-           Matrix& expectation) {
+           const T* labels,
+           int nData,
+           int nFeats,
+           const Matrix& expectation) {
 
 #ifdef DEBUG
   // DEBUG
@@ -109,36 +350,96 @@ void mStep(Matrix& alpha,
 #endif
 
   // Find useful sizes
-  int nData  = data.rows();
-  int nFeats = data.cols();
   int nClust = alpha.rows();
 
-  // Totals
-  double alphaTotal = 0.0;
+  // First count of each feature
+  // (counts of value v start at offset[f] + v * nClust)
+  std::vector<int> offset(nFeats + 1);
+  offset[0] = 0;
+  for (int f = 0; f < nFeats; ++f)
+    offset[f + 1] = offset[f] + coefs[f].cols() * nClust;
+  int nCounts = offset[nFeats];
 
-  // For every point
-  for (int i = 0; i < nData; ++i) {
-    // For every cluster
-    for (int c = 0; c < nClust; ++c) {
-      // Add to alpha
-      alpha(c)   += expectation(i, c);
-      alphaTotal += expectation(i, c);
+  // Number of threads
+  int nThreads = 1;
+#ifdef _OPENMP
+  nThreads = omp_get_max_threads();
+#endif
 
-      // Add to every feature
-      for (int f = 0; f < nFeats; ++f) {
-        int idx = int(data(i, f));
+  // Thread counts (nClust alpha counts, then the feature counts)
+  std::vector< std::vector<double> > threadCounts(nThreads);
 
-#ifdef DEBUG
-        // Check index validity
-        if (idx < 0 || idx >= coefs[f].cols()) {
-          printf("Error! i: %d c: %d f: %d idx: %d\nPrepare to die!\n",
-                 i, c, f, idx);
-        }
+  // Expectation, transposed so that each point is contiguous
+  std::vector<double> expT(nData * nClust);
+
+  // Reduced counts
+  std::vector<double> counts(nClust + nCounts);
+
+  // Raw arrays
+  const double* rawExp = expectation.data();
+
+#pragma omp parallel num_threads(nThreads)
+  {
+    // Transpose
+#pragma omp for schedule(static)
+    for (int i = 0; i < nData; ++i)
+      for (int c = 0; c < nClust; ++c)
+        expT[i * nClust + c] = rawExp[i + c * nData];
+
+    // Slice of points
+    int thread = 0, nActive = 1;
+#ifdef _OPENMP
+    thread  = omp_get_thread_num();
+    nActive = omp_get_num_threads();
 #endif
+    int first = int((long(nData) * thread)       / nActive);
+    int last  = int((long(nData) * (thread + 1)) / nActive);
+
+    // Private counts
+    std::vector<double>& myCounts = threadCounts[thread];
+    myCounts.assign(nClust + nCounts, 0.0);
+    double* alphaCounts = &myCounts[0];
+    double* featCounts  = &myCounts[nClust];
+
+    // Add to alpha
+    for (int i = first; i < last; ++i) {
+      const double* e = &expT[i * nClust];
+      for (int c = 0; c < nClust; ++c)
+        alphaCounts[c] += e[c];
+    }
 
-        coefs[f](c, idx) += expectation(i, c);
+    // Add to every feature
+    for (int f = 0; f < nFeats; ++f) {
+      double*       table = featCounts + offset[f];
+      const T*      col   = labels + f * nData;
+      for (int i = first; i < last; ++i) {
+        double*       row = table + col[i] * nClust;
+        const double* e   = &expT[i * nClust];
+        for (int c = 0; c < nClust; ++c)
+          row[c] += e[c];
       }
     }
+
+    // Wait for every thread
+#pragma omp barrier
+
+    // Sum the counts of the threads that took part
+#pragma omp for schedule(static)
+    for (int k = 0; k < nClust + nCounts; ++k) {
+      double sum = 0.0;
+      for (int t = 0; t < nActive; ++t)
+        sum += threadCounts[t][k];
+      counts[k] = sum;
+    }
+  }
+
+  // Totals
+  double alphaTotal = 0.0;
+
+  // Set alphas
+  for (int c = 0; c < nClust; ++c) {
+    alpha(c)    = counts[c];
+    alphaTotal += counts[c];
   }
 
   // Normalize alphas
@@ -146,13 +447,16 @@ void mStep(Matrix& alpha,
     for (int c = 0; c < nClust; ++c)
       alpha(c) /= alphaTotal;
 
-  // Normalize coefs
+  // Set and normalize coefs
   for (int f = 0; f < nFeats; ++f) {
-    int nValues = coefs[f].cols();
+    int           nValues = coefs[f].cols();
+    const double* table   = &counts[nClust + offset[f]];
     for (int c = 0; c < nClust; ++c) {
       double valTotal = 0.0;
-      for (int v = 0; v < nValues; ++v)
-        valTotal += coefs[f](c, v);
+      for (int v = 0; v < nValues; ++v) {
+        coefs[f](c, v) = table[v * nClust + c];
+        valTotal      += table[v * nClust + c];
+      }
 
       if (valTotal != 0.0)
         for (int v = 0; v < nValues; ++v)
@@ -162,10 +466,27 @@ void mStep(Matrix& alpha,
 }
 
 
+// Maximization step (on either layout width)
+void mStep(Matrix& alpha,
+           Matrix* coefs,
+           const combLabels& labels,
+           const Matrix& expectation) {
+  if (labels.wide)
+    mStep(alpha, coefs, &labels.wideF[0],
+          labels.nData, labels.nFeats, expectation);
+  else
+    mStep(alpha, coefs, &labels.narrowF[0],
+          labels.nData, labels.nFeats, expectation);
+}
+
+
 // Log-Likelihood of data
-double logLike(Matrix& alpha,
-               Matrix* coefs,
-               Matrix& data) {
+// labels is point-major
+template <typename T>
+double logLike(const T* labels,
+               int nData,
+               int nFeats,
+               const logTables& tables) {
 
 #ifdef DEBUG
   // DEBUG
@@ -173,125 +494,363 @@ double logLike(Matrix& alpha,
 #endif
 
   // Find useful sizes
-  int nData  = data.rows();
-  int nFeats = data.cols();
-  int nClust = alpha.rows();
+  int nClust = tables.nClust;
 
   // Total
   double llike = 0.0;
 
-  // For every point
-  for (int i = 0; i < nData; ++i) {
-    // The single factor
-    double factor = 0.0;
+#pragma omp parallel reduction(+:llike)
+  {
+    // Log-probabilities of the current point
+    std::vector<double> logProbs(nClust);
+
+    // For every point
+#pragma omp for schedule(static)
+    for (int i = 0; i < nData; ++i) {
+      // Find the log-possibility for each multinomial
+      double maxLogProb = pointLogProbs(&logProbs[0], tables,
+                                        labels + i * nFeats, nFeats);
+
+      // Impossible for every cluster?
+      if (maxLogProb == -INFINITY) {
+        llike += -INFINITY;
+        continue;
+      }
 
-    // For every cluster
-    for (int c = 0; c < nClust; ++c) {
-      // The single term
-      double term = alpha(c);
+      // Log-sum-exp
+      double factor = 0.0;
+      for (int c = 0; c < nClust; ++c)
+        factor += exp(logProbs[c] - maxLogProb);
 
-      // For every feature
-      for (int f = 0; f < nFeats; ++f) {
-        int idx = int(data(i, f));
+      // Add to the total
+      llike += maxLogProb + log(factor);
+    }
+  }
 
-#ifdef DEBUG
-        // Check index validity
-        if (idx < 0 || idx >= coefs[f].cols()) {
-          printf("Error! i: %d c: %d f: %d idx: %d\nPrepare to die!\n",
-                 i, c, f, idx);
-        }
-#endif
+  // Return it
+  return llike;
+}
 
-        // Add to the term
-        term *= coefs[f](c, idx);
-      }
 
-      // Add to the factor
-      factor += term;
+// Log-Likelihood of data (on either layout width)
+double logLike(const combLabels& labels,
+               const logTables& tables) {
+  if (labels.wide)
+    return logLike(&labels.wideP[0], labels.nData, labels.nFeats, tables);
+  else
+    return logLike(&labels.narrowP[0], labels.nData, labels.nFeats, tables);
+}
+
+
+/*************/
+/* EM Models */
+/*************/
+
+// Mixture of multinomials model
+struct combMemModel {
+  // Kind (1: unweighted, 2: weighted)
+  int kind;
+
+  // Cluster priors (nClust x 1)
+  Matrix alpha;
+
+  // Coefficients of each feature (nClust x nValues)
+  std::vector<Matrix> coefs;
+
+  // Feature weights (kind 2 only)
+  Matrix weights;
+};
+
+// Model handle
+typedef octave_c_pointer_value<combMemModel> combMemModelValue;
+octave_c_pointer_static(combMemModel, "comb_mem_model");
+
+
+// Read a model from a struct
+// Returns false (after reporting an error) if it is not well formed
+bool readModel(combMemModel& model,
+               const Octave_map& map) {
+  // Find the kind element of the struct
+  Octave_map::const_iterator iki = map.seek("kind");
+  if (iki == map.end()) {
+    error("MODEL does not have a kind field");
+    return false;
+  }
+
+  // Find the kind
+  if (!map.contents(iki)(0).is_real_scalar()) {
+    error("MODEL.kind should be an integer");
+    return false;
+  }
+  model.kind = map.contents(iki)(0).int_value();
+
+  // Check supported kinds
+  if (model.kind < 1 || model.kind > 2) {
+    error("MODEL.kind unsupported");
+    return false;
+  }
+
+  // Find the alpha element of the struct
+  Octave_map::const_iterator ial = map.seek("alpha");
+  if (ial == map.end()) {
+    error("MODEL does not have an alpha field");
+    return false;
+  }
+
+  // Find the alpha matrix
+  if (!map.contents(ial)(0).is_real_matrix()) {
+    error("MODEL.alpha should be a matrix");
+    return false;
+  }
+  model.alpha = map.contents(ial)(0).matrix_value();
+
+  // Find the coefs element of the struct
+  Octave_map::const_iterator ico = map.seek("coefs");
+  if (ico == map.end()) {
+    error("MODEL does not have a coefs field");
+    return false;
+  }
+
+  // Find the contents
+  if (!map.contents(ico)(0).is_cell()) {
+    error("MODEL.coefs should be a cell");
+    return false;
+  }
+  Cell ccoefs = map.contents(ico)(0).cell_value();
+
+  // Make a matrix array
+  model.coefs.resize(ccoefs.cols());
+  for (int c = 0; c < ccoefs.cols(); ++c) {
+    if (!ccoefs(c).is_real_matrix()) {
+      error("MODEL.coefs should contain matrices");
+      return false;
     }
+    model.coefs[c] = ccoefs(c).matrix_value();
+  }
 
-    // Add to the total
-    llike += log(factor);
+  // Weighted?
+  if (model.kind == 2) {
+    // Find the weights element of the struct
+    Octave_map::const_iterator iwe = map.seek("weights");
+    if (iwe == map.end()) {
+      error("MODEL does not have a weights field");
+      return false;
+    }
+
+    // Find the weights matrix
+    if (!map.contents(iwe)(0).is_real_matrix()) {
+      error("MODEL.weights should be a matrix");
+      return false;
+    }
+    model.weights = map.contents(iwe)(0).matrix_value();
   }
 
+  // Fine
+  return true;
+}
+
+
+// Write a model into a struct
+Octave_map writeModel(const combMemModel& model) {
+  // Create the coefs cell
+  Cell ccoefs(1, model.coefs.size());
+  for (unsigned int f = 0; f < model.coefs.size(); ++f)
+    ccoefs(f) = octave_value(model.coefs[f]);
+
+  // Fill the struct
+  Octave_map map;
+  map.assign("kind",  octave_value(model.kind));
+  map.assign("alpha", octave_value(model.alpha));
+  map.assign("coefs", Cell(octave_value(ccoefs)));
+  if (model.kind == 2)
+    map.assign("weights", octave_value(model.weights));
+
   // Return it
-  return llike;
+  return map;
 }
 
 
-// Log-Likelihood of data
-// Weighted
-double logLikeW(Matrix& alpha,
-                Matrix* coefs,
-                Matrix& data,
-                Matrix& weights) {
+// Get a model argument, either a handle or a struct
+// A struct is read into tmpModel
+// Returns 0 (after reporting an error) if it is neither
+combMemModel* getModel(const octave_value& arg,
+                       combMemModel& tmpModel) {
+  // A handle?
+  if (combMemModelValue* value = combMemModelValue::cast(arg)) {
+    // Defined?
+    if (!value->is_defined()) {
+      error("MODEL cannot be null");
+      return 0;
+    }
+    return &value->data();
+  }
 
-#ifdef DEBUG
-  // DEBUG
-  printf("Log-Likelihood W\n");
-#endif
+  // A struct?
+  if (!arg.is_map()) {
+    error("MODEL should be a struct or a comb_mem_model handle");
+    return 0;
+  }
 
-  // Find useful sizes
-  int nData  = data.rows();
-  int nFeats = data.cols();
-  int nClust = alpha.rows();
+  // Read it
+  if (!readModel(tmpModel, arg.map_value()))
+    return 0;
+  return &tmpModel;
+}
 
-  // Total
-  double llike = 0.0;
 
-  // For every point
-  for (int i = 0; i < nData; ++i) {
-    // The single factor
-    double factor = 0.0;
+/***********/
+/* EM Loop */
+/***********/
 
-    // For every cluster
-    for (int c = 0; c < nClust; ++c) {
-      // The single term
-      double term = alpha(c);
+// Convergence control
+struct emControl {
+  // Maximum number of iterations
+  int maxIters;
 
-      // For every feature
-      for (int f = 0; f < nFeats; ++f) {
-        int idx = int(data(i, f));
+  // Threshold on the squared change of the expectation
+  double delta;
 
-#ifdef DEBUG
-        // Check index validity
-        if (idx < 0 || idx >= coefs[f].cols()) {
-          printf("Error! i: %d c: %d f: %d idx: %d\nPrepare to die!\n",
-                 i, c, f, idx);
-        }
-#endif
+  // Threshold on the relative change of the log-likelihood (0: unused)
+  double tolerance;
+};
 
-        // Add to the term
-        term *= pow(coefs[f](c, idx), weights(f));
-      }
 
-      // Add to the factor
-      factor += term;
-    }
+// Squared difference between two expectations
+double sqDiff(const Matrix& a,
+              const Matrix& b) {
+  // Raw arrays
+  const double* rawA = a.data();
+  const double* rawB = b.data();
+  int           n    = a.rows() * a.cols();
+
+  // Add
+  double sum = 0.0;
+#pragma omp parallel for reduction(+:sum) schedule(static)
+  for (int k = 0; k < n; ++k)
+    sum += (rawA[k] - rawB[k]) * (rawA[k] - rawB[k]);
+  return sum;
+}
+
 
-    // Add to the total
-    llike += log(factor);
+// Run EM from a model until it converges
+// The log-likelihood of every iteration comes from its E-step, and it
+// is added to trace together with the change of the expectation
+// expectation (which ends up with the final one) and scratch should be
+// nData x nClust
+// Returns the final log-likelihood
+double emRun(combMemModel& model,
+             const combLabels& labels,
+             Matrix& expectation,
+             Matrix& scratch,
+             const emControl& control,
+             std::vector<double>& trace) {
+  // Sizes
+  int nFeats = labels.nFeats;
+
+  // Weights
+  Matrix* weights = model.kind == 2 ? &model.weights : 0;
+
+  // Initial expectation
+  logTables tables;
+  buildTables(tables, model.alpha, &model.coefs[0], nFeats, weights);
+  double llike = eStep(expectation, labels, tables);
+
+  // Current and previous expectations
+  Matrix* current  = &expectation;
+  Matrix* previous = &scratch;
+
+  // Iterate
+  trace.clear();
+  for (int iter = 0; iter < control.maxIters; ++iter) {
+    // Swap
+    std::swap(current, previous);
+    double oldLlike = llike;
+
+    // Maximization and expectation
+    mStep(model.alpha, &model.coefs[0], labels, *previous);
+    buildTables(tables, model.alpha, &model.coefs[0], nFeats, weights);
+    llike = eStep(*current, labels, tables);
+
+    // Change
+    double delta = sqDiff(*current, *previous);
+    trace.push_back(llike);
+    trace.push_back(delta);
+
+    // Converged?
+    if (delta < control.delta)
+      break;
+    if (control.tolerance > 0.0 &&
+        fabs(llike - oldLlike) <= control.tolerance * fabs(llike))
+      break;
   }
 
-  // Return it
+  // Leave the final expectation in place
+  if (current != &expectation)
+    std::copy(current->data(), current->data() + current->rows() *
+              current->cols(), expectation.fortran_vec());
+
+  // Return the log-likelihood
   return llike;
 }
 
 
+// Random model, as comb_mem_initialize makes
+// random holds nClust x (1 + sum of sizes) uniform numbers
+void randomModel(combMemModel& model,
+                 const Matrix& random,
+                 const std::vector<int>& sizes) {
+  // Sizes
+  int nClust = random.rows();
+  int nFeats = sizes.size();
+
+  // Priors
+  double total = 0.0;
+  model.alpha.resize_fill(nClust, 1, 0.0);
+  for (int c = 0; c < nClust; ++c) {
+    model.alpha(c) = random(c, 0);
+    total         += random(c, 0);
+  }
+  for (int c = 0; c < nClust; ++c)
+    model.alpha(c) /= total;
+
+  // Coefficients
+  int col = 1;
+  model.coefs.resize(nFeats);
+  for (int f = 0; f < nFeats; ++f) {
+    model.coefs[f].resize_fill(nClust, sizes[f], 0.0);
+    for (int c = 0; c < nClust; ++c) {
+      double valTotal = 0.0;
+      for (int v = 0; v < sizes[f]; ++v) {
+        model.coefs[f](c, v) = random(c, col + v);
+        valTotal            += random(c, col + v);
+      }
+      for (int v = 0; v < sizes[f]; ++v)
+        model.coefs[f](c, v) /= valTotal;
+    }
+    col += sizes[f];
+  }
+}
+
+
 /*******************/
 /* Octave-C++ Glue */
 /*******************/
 
-// Perform an expectation step
-DEFUN_DLD(comb_mem_expectation, args, nargout,
+// Create a model handle
+DEFUN_DLD(comb_mem_model, args, nargout,
           "-*- texinfo -*-\n\
-@deftypefn {Loadable Function} {Expectation =} comb_mem_expectation(@var{model}, @var{data})\n\
+@deftypefn {Loadable Function} {handle =} comb_mem_model(@var{model})\n\
 \n\
-Perform an expectation step.\n\
+Keep a model struct inside a native handle.\n\
+\n\
+The handle can be given to @code{comb_mem_expectation} and\n\
+@code{comb_mem_loglike} instead of the struct, and to\n\
+@code{comb_mem_maximization}, which then updates it in place. Use\n\
+@code{comb_mem_model_struct} to get the struct back.\n\
 @end deftypefn") {
   // Check argument number
-  if (args.length() != 2 || nargout > 1) {
-    print_usage("comb_mem_expectation");
+  if (args.length() != 1 || nargout > 1) {
+    print_usage("comb_mem_model");
     return octave_value_list();
   }
 
@@ -301,112 +860,263 @@ Perform an expectation step.\n\
     return octave_value_list();
   }
 
-  if (!args(1).is_real_matrix()) {
-    error("DATA should be a matrix");
+  // Read it
+  combMemModel* model = new combMemModel();
+  if (!readModel(*model, args(0).map_value())) {
+    delete model;
     return octave_value_list();
   }
 
-  // Find the kind element of the struct
-  Octave_map model         = args(0).map_value();
-  Octave_map::iterator iki = model.seek("kind");
-  if (iki == model.end()) {
-    error("MODEL does not have a kind field");
+  // Return
+  octave_value_list output;
+  output.resize(1);
+  output(0) = new combMemModelValue(model);
+  return output;
+}
+
+
+// Convert a model handle into a struct
+DEFUN_DLD(comb_mem_model_struct, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {model =} comb_mem_model_struct(@var{handle})\n\
+\n\
+Get the model struct kept inside a native handle.\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() != 1 || nargout > 1) {
+    print_usage("comb_mem_model_struct");
     return octave_value_list();
   }
 
-  // Find the kind
-  if (!model.contents(iki)(0).is_real_scalar()) {
-    error("MODEL.kind should be an integer");
+  // Get the model
+  combMemModel  tmpModel;
+  combMemModel* model = getModel(args(0), tmpModel);
+  if (!model)
     return octave_value_list();
-  }
-  int kind = model.contents(iki)(0).int_value();
 
-  // Check supported kinds
-  if (kind < 1 || kind > 2) {
-    error("MODEL.kind unsupported");
+  // Return
+  octave_value_list output;
+  output.resize(1);
+  output(0) = octave_value(writeModel(*model));
+  return output;
+}
+
+
+// Create a label matrix handle
+DEFUN_DLD(comb_mem_labels, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {[@var{handle}, @var{FeatureSizes}, @var{nelems}] =} comb_mem_labels(@var{clustering}, @var{k}, ...)\n\
+\n\
+Keep the labels of several clusterings inside a native handle.\n\
+\n\
+Each clustering is either a file name, loaded as @code{read_clustering}\n\
+does, or a matrix of 0-based labels followed by its number of clusters\n\
+(a matrix with several columns is followed by a vector with the number\n\
+of clusters of each one).\n\
+\n\
+The handle can be given to @code{comb_mem_expectation},\n\
+@code{comb_mem_maximization} and @code{comb_mem_loglike} instead of\n\
+the data matrix. Use @code{comb_mem_labels_matrix} to get the matrix\n\
+back.\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() == 0 || nargout > 3) {
+    print_usage("comb_mem_labels");
     return octave_value_list();
   }
 
-  // Find the alpha element of the struct
-  Octave_map::iterator ial = model.seek("alpha");
-  if (ial == model.end()) {
-    error("MODEL does not have an alpha field");
-    return octave_value_list();
+  // Clusterings read from files, and the matrices given
+  std::vector< std::vector<int> > files;
+  std::vector<Matrix> matrices;
+
+  // Source of each feature (file or matrix, and column)
+  std::vector<int> fromFile, source, column;
+
+  // Number of values of each feature
+  std::vector<int> sizes;
+
+  // Number of points
+  int nData = -1;
+
+  // Check every argument
+  int a = 0;
+  while (a < args.length()) {
+    // A file?
+    if (args(a).is_string()) {
+      // Read it
+      int k;
+      files.push_back(std::vector<int>());
+      if (!readClustering(files.back(), k, args(a).string_value(), false))
+        return octave_value_list();
+
+      // Add the feature
+      fromFile.push_back(1);
+      source  .push_back(files.size() - 1);
+      column  .push_back(0);
+      sizes   .push_back(k);
+
+      // Check the number of points
+      if (nData != -1 && int(files.back().size()) != nData) {
+        error("every clustering should have the same number of points");
+        return octave_value_list();
+      }
+      nData = files.back().size();
+      ++a;
+    }
+
+    // A matrix, followed by its number of clusters
+    else {
+      if (!args(a).is_real_matrix() || a + 1 == args.length() ||
+          !args(a + 1).is_real_matrix()) {
+        error("each clustering should be a file or a matrix followed by k");
+        return octave_value_list();
+      }
+      Matrix clustering = args(a).matrix_value();
+      Matrix ks         = args(a + 1).matrix_value();
+
+      // Check the sizes
+      if (ks.numel() != clustering.cols()) {
+        error("k should have one element per column of the clustering");
+        return octave_value_list();
+      }
+
+      if (nData != -1 && clustering.rows() != nData) {
+        error("every clustering should have the same number of points");
+        return octave_value_list();
+      }
+      nData = clustering.rows();
+
+      // Add the features
+      matrices.push_back(clustering);
+      for (int c = 0; c < clustering.cols(); ++c) {
+        fromFile.push_back(0);
+        source  .push_back(matrices.size() - 1);
+        column  .push_back(c);
+        sizes   .push_back(int(ks(c)));
+      }
+      a += 2;
+    }
   }
 
-  // Find the alpha matrix
-  if (!model.contents(ial)(0).is_real_matrix()) {
-    error("MODEL.alpha should be a matrix");
-    return octave_value_list();
+  // Fill the labels
+  combLabels* labels = new combLabels();
+  initLabels(*labels, nData, sizes);
+  for (int f = 0; f < labels->nFeats; ++f) {
+    if (fromFile[f]) {
+      const std::vector<int>& clustering = files[source[f]];
+      for (int i = 0; i < nData; ++i)
+        setLabel(*labels, i, f, clustering[i]);
+    }
+    else if (!setColumn(*labels, matrices[source[f]], column[f], f)) {
+      delete labels;
+      return octave_value_list();
+    }
   }
-  Matrix alpha = model.contents(ial)(0).matrix_value();
 
-  // Find the coefs element of the struct
-  Octave_map::iterator ico = model.seek("coefs");
-  if (ico == model.end()) {
-    error("MODEL does not have a coefs field");
+  // Feature sizes
+  ColumnVector featureSizes(labels->nFeats);
+  for (int f = 0; f < labels->nFeats; ++f)
+    featureSizes(f) = sizes[f];
+
+  // Return
+  octave_value_list output;
+  output.resize(3);
+  output(0) = new combLabelsValue(labels);
+  output(1) = octave_value(featureSizes);
+  output(2) = octave_value(nData);
+  return output;
+}
+
+
+// Convert a label matrix handle into a matrix
+DEFUN_DLD(comb_mem_labels_matrix, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {data =} comb_mem_labels_matrix(@var{handle})\n\
+\n\
+Get the labels kept inside a native handle, as a matrix with a row per\n\
+point and a column per clustering.\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() != 1 || nargout > 1) {
+    print_usage("comb_mem_labels_matrix");
     return octave_value_list();
   }
 
-  // Find the contents
-  if (!model.contents(ico)(0).is_cell()) {
-    error("MODEL.coefs should be a cell");
+  // Cast
+  combLabelsValue* value = combLabelsValue::cast(args(0));
+  if (!value) {
+    error("HANDLE should be a comb_mem_labels handle");
+    return octave_value_list();
+  }
+  if (!value->is_defined()) {
+    error("HANDLE cannot be null");
     return octave_value_list();
   }
-  Cell ccoefs = model.contents(ico)(0).cell_value();
+  const combLabels& labels = value->data();
 
-  // Make a matrix array
-  Matrix* coefs = new Matrix[ccoefs.cols()];
-  for (int c = 0; c < ccoefs.cols(); ++c) {
-    if (!ccoefs(c).is_real_matrix()) {
-      error("MODEL.coefs should contain matrices");
-      delete[] coefs;
-      return octave_value_list();
-    }
-    coefs[c] = ccoefs(c).matrix_value();
+  // Fill the matrix from the feature-major layout
+  Matrix data(labels.nData, labels.nFeats);
+  double* rawData = data.fortran_vec();
+  int     nLabels = labels.nData * labels.nFeats;
+  for (int l = 0; l < nLabels; ++l)
+    rawData[l] = labels.wide ? labels.wideF[l] : labels.narrowF[l];
+
+  // Return
+  octave_value_list output;
+  output.resize(1);
+  output(0) = octave_value(data);
+  return output;
+}
+
+
+// Perform an expectation step
+DEFUN_DLD(comb_mem_expectation, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {Expectation =} comb_mem_expectation(@var{model}, @var{data})\n\
+\n\
+Perform an expectation step.\n\
+\n\
+@var{model} may be a struct or a @code{comb_mem_model} handle, and\n\
+@var{data} a matrix or a @code{comb_mem_labels} handle.\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() != 2 || nargout > 1) {
+    print_usage("comb_mem_expectation");
+    return octave_value_list();
   }
 
-  // Find the data
-  Matrix data = args(1).matrix_value();
+  // Get the model
+  combMemModel  tmpModel;
+  combMemModel* model = getModel(args(0), tmpModel);
+  if (!model)
+    return octave_value_list();
+
+  // Number of values of each feature
+  int nFeats = model->coefs.size();
+  std::vector<int> sizes(nFeats);
+  for (int f = 0; f < nFeats; ++f)
+    sizes[f] = model->coefs[f].cols();
+
+  // Get the data
+  combLabels  tmpLabels;
+  combLabels* labels = getLabels(args(1), tmpLabels, sizes);
+  if (!labels)
+    return octave_value_list();
 
   // Sizes
-  int nData  = data.rows();
-  int nClust = alpha.rows();
+  int nData  = labels->nData;
+  int nClust = model->alpha.rows();
 
   // Return value
   Matrix expectation(nData, nClust, 0.0);
 
-  // According to the kind
-  switch (kind) {
-  case 1:
-    // Unweighted
-    // Call the function
-    eStep(expectation, data, alpha, coefs);
-    break;
+  // Tables (weighted or not, according to the kind)
+  logTables tables;
+  buildTables(tables, model->alpha, &model->coefs[0], nFeats,
+              model->kind == 2 ? &model->weights : 0);
 
-  case 2:
-    // Find the weights element of the struct
-    Octave_map::iterator iwe = model.seek("weights");
-    if (iwe == model.end()) {
-      error("MODEL does not have a weights field");
-      delete[] coefs;
-      return octave_value_list();
-    }
-
-    // Find the weights matrix
-    if (!model.contents(iwe)(0).is_real_matrix()) {
-      error("MODEL.weights should be a matrix");
-      delete[] coefs;
-      return octave_value_list();
-    }
-    Matrix weights = model.contents(iwe)(0).matrix_value();
-
-    // Call the function
-    eStepW(expectation, data, alpha, coefs, weights);
-  }
-
-  // Free the coefs array
-  delete[] coefs;
+  // Call the function
+  eStep(expectation, *labels, tables);
 
   // Return
   octave_value_list output;
@@ -420,21 +1130,23 @@ Perform an expectation step.\n\
 DEFUN_DLD(comb_mem_maximization, args, nargout,
           "-*- texinfo -*-\n\
 @deftypefn {Loadable Function} {model =} comb_mem_maximization(@var{data}, @var{FeatureSizes}, @var{expectation})\n\
+@deftypefnx {Loadable Function} {handle =} comb_mem_maximization(@var{data}, @var{FeatureSizes}, @var{expectation}, @var{handle})\n\
 \n\
-Perform an expectation step.\n\
+Perform a maximization step.\n\
+\n\
+If a @code{comb_mem_model} handle is given, its priors and coefficients\n\
+are updated in place (keeping its kind and weights), and it is returned.\n\
+Otherwise, a new unweighted model struct is returned.\n\
+\n\
+@var{data} may be a matrix or a @code{comb_mem_labels} handle.\n\
 @end deftypefn") {
   // Check argument number
-  if (args.length() != 3 || nargout > 1) {
+  if (args.length() < 3 || args.length() > 4 || nargout > 1) {
     print_usage("comb_mem_maximization");
     return octave_value_list();
   }
 
   // Check types of arguments
-  if (!args(0).is_real_matrix()) {
-    error("DATA should be a matrix");
-    return octave_value_list();
-  }
-
   if (!args(1).is_real_matrix()) {
     error("FEATURESIZES should be a column vector");
     return octave_value_list();
@@ -445,61 +1157,71 @@ Perform an expectation step.\n\
     return octave_value_list();
   }
 
+  if (args.length() > 3 &&
+      !combMemModelValue::cast(args(3))) {
+    error("HANDLE should be a comb_mem_model handle");
+    return octave_value_list();
+  }
+
   // Get the matrices
-  Matrix data         = args(0).matrix_value();
   Matrix featureSizes = args(1).matrix_value();
   Matrix expectation  = args(2).matrix_value();
 
-  // Check dimensions of DATA and EXPECTATION
-  int nData = data.rows();
-  if (expectation.rows() != nData) {
-    error("DATA and EXPECTATION should have the same number of rows");
-    return octave_value_list();
-  }
-
   // Check dimensions of FEATURESIZES
-  int nFeats = data.cols();
   if (featureSizes.cols() != 1) {
     error("FEATURESIZES should be a column vector");
     return octave_value_list();
   }
 
-  if (featureSizes.rows() != nFeats) {
-    error("FEATURESIZES does not match the number of features in DATA");
+  // Number of values of each feature
+  int nFeats = featureSizes.rows();
+  std::vector<int> sizes(nFeats);
+  for (int f = 0; f < nFeats; ++f)
+    sizes[f] = int(featureSizes(f));
+
+  // Get the data
+  combLabels  tmpLabels;
+  combLabels* labels = getLabels(args(0), tmpLabels, sizes);
+  if (!labels)
     return octave_value_list();
-  }
 
-  // Output alpha
-  int nClust = expectation.cols();
-  Matrix alpha(nClust, 1, 0.0);
+  // Check dimensions of DATA and EXPECTATION
+  if (expectation.rows() != labels->nData) {
+    error("DATA and EXPECTATION should have the same number of rows");
+    return octave_value_list();
+  }
 
-  // Output coefs
-  Matrix* coefs = new Matrix[nFeats];
-  for (int f = 0; f < nFeats; ++f) {
-    coefs[f].resize_fill(nClust, int(featureSizes(f)), 0.0);
+  // Model to fill
+  combMemModel  tmpModel;
+  combMemModel* model = &tmpModel;
+  if (args.length() > 3) {
+    model = getModel(args(3), tmpModel);
+    if (!model)
+      return octave_value_list();
+  }
+  else {
+    model->kind = 1;
   }
 
-  // Call
-  mStep(alpha, coefs, data, expectation);
+  // Size alpha
+  int nClust = expectation.cols();
+  model->alpha.resize_fill(nClust, 1, 0.0);
 
-  // Create the coefs cell
-  Cell ccoefs(1, nFeats);
+  // Size coefs
+  model->coefs.resize(nFeats);
   for (int f = 0; f < nFeats; ++f)
-    ccoefs(f) = octave_value(coefs[f]);
-
-  // Free the coefs array
-  delete[] coefs;
+    model->coefs[f].resize_fill(nClust, sizes[f], 0.0);
 
-  // Return
-  Octave_map model;
-  model.assign("kind",  octave_value(1));
-  model.assign("alpha", octave_value(alpha));
-  model.assign("coefs", Cell(octave_value(ccoefs)));
+  // Call
+  mStep(model->alpha, &model->coefs[0], *labels, expectation);
 
   // Return
   octave_value_list output;
   output.resize(1);
-  output(0) = octave_value(model);
+  if (args.length() > 3)
+    output(0) = args(3);
+  else
+    output(0) = octave_value(writeModel(*model));
   return output;
 }
 
@@ -510,6 +1232,9 @@ DEFUN_DLD(comb_mem_loglike, args, nargout,
 @deftypefn {Loadable Function} {logLike =} comb_mem_loglike(@var{model}, @var{data})\n\
 \n\
 Find the log-likelihood of data according to the model.\n\
+\n\
+@var{model} may be a struct or a @code{comb_mem_model} handle, and\n\
+@var{data} a matrix or a @code{comb_mem_labels} handle.\n\
 @end deftypefn") {
   // Check argument number
   if (args.length() != 2 || nargout > 1) {
@@ -517,115 +1242,239 @@ Find the log-likelihood of data according to the model.\n\
     return octave_value_list();
   }
 
-  // Check types of arguments
-  if (!args(0).is_map()) {
-    error("MODEL should be a struct");
+  // Get the model
+  combMemModel  tmpModel;
+  combMemModel* model = getModel(args(0), tmpModel);
+  if (!model)
     return octave_value_list();
-  }
 
-  if (!args(1).is_real_matrix()) {
-    error("DATA should be a matrix");
-    return octave_value_list();
-  }
+  // Number of values of each feature
+  int nFeats = model->coefs.size();
+  std::vector<int> sizes(nFeats);
+  for (int f = 0; f < nFeats; ++f)
+    sizes[f] = model->coefs[f].cols();
 
-  // Find the kind element of the struct
-  Octave_map model         = args(0).map_value();
-  Octave_map::iterator iki = model.seek("kind");
-  if (iki == model.end()) {
-    error("MODEL does not have a kind field");
+  // Get the data
+  combLabels  tmpLabels;
+  combLabels* labels = getLabels(args(1), tmpLabels, sizes);
+  if (!labels)
     return octave_value_list();
+
+  // Tables (weighted or not, according to the kind)
+  logTables tables;
+  buildTables(tables, model->alpha, &model->coefs[0], nFeats,
+              model->kind == 2 ? &model->weights : 0);
+
+  // Call the function
+  double llike = logLike(*labels, tables);
+
+  // Return
+  octave_value_list output;
+  output.resize(1);
+  output(0) = octave_value(llike);
+  return output;
+}
+
+
+// Read a numeric option
+// Returns false (after reporting an error) if it is not a scalar
+bool readOption(double& value,
+                const Octave_map& opts,
+                const std::string& name) {
+  // Given?
+  Octave_map::const_iterator it = opts.seek(name);
+  if (it == opts.end())
+    return true;
+
+  // Check it
+  if (!opts.contents(it)(0).is_real_scalar()) {
+    error("OPTS.%s should be a number", name.c_str());
+    return false;
   }
+  value = opts.contents(it)(0).double_value();
+  return true;
+}
 
-  // Find the kind
-  if (!model.contents(iki)(0).is_real_scalar()) {
-    error("MODEL.kind should be an integer");
+
+// Fit a model
+DEFUN_DLD(comb_mem_fit, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {[@var{model}, @var{expectation}, @var{logLikes}, @var{trace}] =} comb_mem_fit(@var{data}, @var{FeatureSizes}, @var{k} [, @var{opts}])\n\
+\n\
+Fit a mixture of @var{k} multinomials by EM, from several random\n\
+starting models, and return the one with the best log-likelihood,\n\
+together with its expectation.\n\
+\n\
+@var{data} may be a matrix or a @code{comb_mem_labels} handle.\n\
+@var{logLikes} holds the final log-likelihood of every start, and\n\
+@var{trace} a matrix for every start, with the log-likelihood and the\n\
+squared change of the expectation after each iteration.\n\
+\n\
+Options:\n\
+@table @code\n\
+@item restarts\n\
+Number of random starting models (5), run in parallel.\n\
+@item max_iterations\n\
+Maximum number of iterations of each start (1000, Inf for no cap).\n\
+@item delta\n\
+Stop when the squared change of the expectation is below it\n\
+(1e-8 times the number of points).\n\
+@item tolerance\n\
+Stop when the relative change of the log-likelihood is at most it\n\
+(0, unused).\n\
+@item weights\n\
+Feature weights, for a weighted model (none).\n\
+@end table\n\
+\n\
+The starting models are drawn with @code{rand}, as\n\
+@code{comb_mem_initialize} does.\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() < 3 || args.length() > 4 || nargout > 4) {
+    print_usage("comb_mem_fit");
     return octave_value_list();
   }
-  int kind = model.contents(iki)(0).int_value();
 
-  // Check supported kinds
-  if (kind < 1 || kind > 2) {
-    error("MODEL.kind unsupported");
+  // Check types of arguments
+  if (!args(1).is_real_matrix() || args(1).columns() != 1) {
+    error("FEATURESIZES should be a column vector");
     return octave_value_list();
   }
 
-  // Find the alpha element of the struct
-  Octave_map::iterator ial = model.seek("alpha");
-  if (ial == model.end()) {
-    error("MODEL does not have an alpha field");
+  if (!args(2).is_real_scalar() || args(2).int_value() < 1) {
+    error("K should be a positive integer");
     return octave_value_list();
   }
 
-  // Find the alpha matrix
-  if (!model.contents(ial)(0).is_real_matrix()) {
-    error("MODEL.alpha should be a matrix");
+  if (args.length() > 3 && !args(3).is_map()) {
+    error("OPTS should be a struct");
     return octave_value_list();
   }
-  Matrix alpha = model.contents(ial)(0).matrix_value();
 
-  // Find the coefs element of the struct
-  Octave_map::iterator ico = model.seek("coefs");
-  if (ico == model.end()) {
-    error("MODEL does not have a coefs field");
-    return octave_value_list();
+  // Number of values of each feature
+  Matrix featureSizes = args(1).matrix_value();
+  int nFeats = featureSizes.rows();
+  std::vector<int> sizes(nFeats);
+  int nValues = 0;
+  for (int f = 0; f < nFeats; ++f) {
+    sizes[f]  = int(featureSizes(f));
+    nValues  += sizes[f];
   }
 
-  // Find the contents
-  if (!model.contents(ico)(0).is_cell()) {
-    error("MODEL.coefs should be a cell");
+  // Get the data
+  combLabels  tmpLabels;
+  combLabels* labels = getLabels(args(0), tmpLabels, sizes);
+  if (!labels)
     return octave_value_list();
-  }
-  Cell ccoefs = model.contents(ico)(0).cell_value();
 
-  // Make a matrix array
-  Matrix* coefs = new Matrix[ccoefs.cols()];
-  for (int c = 0; c < ccoefs.cols(); ++c) {
-    if (!ccoefs(c).is_real_matrix()) {
-      error("MODEL.coefs should contain matrices");
-      delete[] coefs;
+  // Sizes
+  int nData  = labels->nData;
+  int nClust = args(2).int_value();
+
+  // Options
+  double restarts = 5;
+  double maxIters = 1000;
+  emControl control;
+  control.delta     = 1e-8 * nData;
+  control.tolerance = 0.0;
+
+  // Weighted model?
+  int    kind = 1;
+  Matrix weights;
+
+  // Read them
+  if (args.length() > 3) {
+    Octave_map opts = args(3).map_value();
+    if (!readOption(restarts,          opts, "restarts")       ||
+        !readOption(maxIters,          opts, "max_iterations") ||
+        !readOption(control.delta,     opts, "delta")          ||
+        !readOption(control.tolerance, opts, "tolerance"))
       return octave_value_list();
+
+    Octave_map::const_iterator iwe = opts.seek("weights");
+    if (iwe != opts.end()) {
+      if (!opts.contents(iwe)(0).is_real_matrix() ||
+          opts.contents(iwe)(0).rows() != nFeats ||
+          opts.contents(iwe)(0).columns() != 1) {
+        error("OPTS.weights should have an element per feature");
+        return octave_value_list();
+      }
+      kind    = 2;
+      weights = opts.contents(iwe)(0).matrix_value();
     }
-    coefs[c] = ccoefs(c).matrix_value();
   }
 
-  // Find the data
-  Matrix data = args(1).matrix_value();
-
-  // According to the kind
-  double llike;
-  switch (kind) {
-  case 1:
-    // Unweighted
-    // Call the function
-    llike = logLike(alpha, coefs, data);
-
-  case 2:
-    // Find the weights element of the struct
-    Octave_map::iterator iwe = model.seek("weights");
-    if (iwe == model.end()) {
-      error("MODEL does not have a weights field");
-      delete[] coefs;
+  if (restarts < 1 || maxIters < 0) {
+    error("OPTS.restarts should be positive and OPTS.max_iterations not negative");
+    return octave_value_list();
+  }
+  int nRestarts    = int(restarts);
+  control.maxIters = maxIters >= INT_MAX ? INT_MAX : int(maxIters);
+
+  // Random starting models, and room for their expectations
+  std::vector<combMemModel> models(nRestarts);
+  std::vector<Matrix>       expectations(nRestarts), scratches(nRestarts);
+  for (int r = 0; r < nRestarts; ++r) {
+    // Draw
+    octave_value_list randArgs;
+    randArgs(0) = octave_value(nClust);
+    randArgs(1) = octave_value(1 + nValues);
+    octave_value_list random = feval("rand", randArgs, 1);
+    if (error_state)
       return octave_value_list();
-    }
 
-    // Find the weights matrix
-    if (!model.contents(iwe)(0).is_real_matrix()) {
-      error("MODEL.weights should be a matrix");
-      delete[] coefs;
-      return octave_value_list();
-    }
-    Matrix weights = model.contents(iwe)(0).matrix_value();
+    // Fill
+    randomModel(models[r], random(0).matrix_value(), sizes);
+    models[r].kind    = kind;
+    models[r].weights = weights;
+
+    // Unshare the weights, so that no thread touches a shared count
+    models[r].weights.fortran_vec();
 
-    // Call the function
-    llike = logLikeW(alpha, coefs, data, weights);
+    // Expectations
+    expectations[r] = Matrix(nData, nClust, 0.0);
+    scratches   [r] = Matrix(nData, nClust, 0.0);
   }
 
-  // Free the coefs array
-  delete[] coefs;
+  // Results of every start
+  std::vector<double>               llikes(nRestarts);
+  std::vector< std::vector<double> > traces(nRestarts);
+
+  // Run them
+  // (Every start owns its model and expectations, and the E and M
+  // steps inside run on a single thread when the starts are parallel)
+#pragma omp parallel for schedule(dynamic) if (nRestarts > 1)
+  for (int r = 0; r < nRestarts; ++r)
+    llikes[r] = emRun(models[r], *labels, expectations[r], scratches[r],
+                      control, traces[r]);
+
+  // Best one
+  int best = 0;
+  for (int r = 1; r < nRestarts; ++r)
+    if (llikes[r] > llikes[best])
+      best = r;
+
+  // Log-likelihoods and traces
+  ColumnVector logLikes(nRestarts);
+  Cell         trace(nRestarts, 1);
+  for (int r = 0; r < nRestarts; ++r) {
+    logLikes(r) = llikes[r];
+
+    int    nIters = traces[r].size() / 2;
+    Matrix rTrace(nIters, 2);
+    for (int it = 0; it < nIters; ++it) {
+      rTrace(it, 0) = traces[r][2 * it];
+      rTrace(it, 1) = traces[r][2 * it + 1];
+    }
+    trace(r) = octave_value(rTrace);
+  }
 
   // Return
   octave_value_list output;
-  output.resize(1);
-  output(0) = octave_value(llike);
+  output.resize(4);
+  output(0) = octave_value(writeModel(models[best]));
+  output(1) = octave_value(expectations[best]);
+  output(2) = octave_value(logLikes);
+  output(3) = octave_value(trace);
   return output;
 }
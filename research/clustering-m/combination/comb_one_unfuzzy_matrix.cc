@@ -1,9 +1,13 @@
 #include <octave/oct.h>
 #include <octave/ov-struct.h>
 
+#include <cctype>
 #include <cstdio>
-#include <map>
+#include <cstring>
 #include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
 
 using namespace std;
 
@@ -11,15 +15,20 @@ using namespace std;
 // Buffer sizes
 #define MAX_LINE_LENGTH 2048
 
-/******************/
-/* Unfuzzy matrix */
-/******************/
+// Document map
+typedef boost::unordered_map<string, int> docMap;
+
+/****************/
+/* Rlabel files */
+/****************/
 
-// Fill an unfuzzy matrix
-bool fillUnfuzzy(Matrix& unfuzzy,
-                 string_vector& labels,
-                 Matrix& clustering,
-                 string rlabel) {
+// Read the document of every line of an rlabel file
+// Documents are numbered in order of appearance, and their names
+// appended to labels
+bool readRlabel(vector<int>& docOf,
+                string_vector& labels,
+                const string& rlabel,
+                int nData) {
   // Line buffer
   char buffer[MAX_LINE_LENGTH];
 
@@ -31,13 +40,11 @@ bool fillUnfuzzy(Matrix& unfuzzy,
   }
 
   // Map
-  map<string, int> docMap;
-  int nDocs = 0;
-
-  // NData
-  int nData = clustering.rows();
+  docMap docs;
+  int    nDocs = 0;
 
   // Read every line
+  docOf.clear();
   int line = 1;
   while (fgets(buffer, MAX_LINE_LENGTH, file)) {
     // Check
@@ -72,6 +79,7 @@ bool fillUnfuzzy(Matrix& unfuzzy,
     while (isdigit(*p)) {
       if (p == buffer) {
         error("ill-formed line (all numbers) at %s:%d", rlabel.c_str(), line);
+        fclose(file);
         return false;
       }
       --p;
@@ -81,6 +89,7 @@ bool fillUnfuzzy(Matrix& unfuzzy,
     // Is there no prefix?
     if (*p != 'S' && *p != 's' && *p != 'X' && *p != 'x') {
       error("ill-formed line (no separator) at %s:%d", rlabel.c_str(), line);
+      fclose(file);
       return false;
     }
 
@@ -95,20 +104,21 @@ bool fillUnfuzzy(Matrix& unfuzzy,
     // Empty prefix?
     if (begin == p) {
       error("ill-formed line (empty prefix) at %s:%d", rlabel.c_str(), line);
+      fclose(file);
       return false;
     }
 
-    // Find?
-    string doc = string(begin);
-    map<string, int>::iterator it = docMap.find(doc);
-    if (it == docMap.end()) {
+    // Find or add, with a single lookup
+    pair<docMap::iterator, bool> found =
+      docs.insert(make_pair(string(begin, p), nDocs));
+    if (found.second) {
       // New doc
-      docMap.insert(make_pair(doc, nDocs++));
-      labels.append(doc);
+      labels.append(found.first->first);
+      ++nDocs;
     }
 
-    // Assign matrix
-    ++unfuzzy(docMap[doc], int(clustering(line - 1)));
+    // Keep it
+    docOf.push_back(found.first->second);
 
     // Next line
     ++line;
@@ -124,14 +134,50 @@ bool fillUnfuzzy(Matrix& unfuzzy,
   // Free
   fclose(file);
 
-  // Extract
-  unfuzzy = unfuzzy.extract(0, 0, nDocs - 1, unfuzzy.cols() - 1);
-
   // Everything OK
   return true;
 }
 
 
+/******************/
+/* Unfuzzy matrix */
+/******************/
+
+// Check the labels of a clustering
+bool checkClustering(const Matrix& clustering,
+                     int nClust,
+                     int nLines) {
+  for (int i = 0; i < nLines; ++i) {
+    double label = clustering(i);
+    if (label < 0 || label >= nClust || label != int(label)) {
+      error("CLUSTERING should hold labels between 0 and NCLUSTERS - 1");
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// Add a clustering to the columns of an unfuzzy matrix starting at
+// first, which has a row per document
+void fillUnfuzzy(Matrix& unfuzzy,
+                 const vector<int>& docOf,
+                 const Matrix& clustering,
+                 int first) {
+  // Sizes
+  int nDocs  = unfuzzy.rows();
+  int nLines = docOf.size();
+
+  // Raw data
+  double*       out    = unfuzzy.fortran_vec() + first * nDocs;
+  const double* labels = clustering.data();
+
+  // Count
+  for (int i = 0; i < nLines; ++i)
+    ++out[int(labels[i]) * nDocs + docOf[i]];
+}
+
+
 
 /*******************/
 /* Octave-C++ Glue */
@@ -180,14 +226,19 @@ Find the unfuzzy matrix for one clustering.\n\
   // String
   string rlabel = args(2).string_value();
 
-  // Return values
-  Matrix        unfuzzy(nData, nClust, 0.0);
+  // Documents
+  vector<int>   docOf;
   string_vector labels;
+  if (!readRlabel(docOf, labels, rlabel, nData))
+    return octave_value_list();
 
-  // Call the function
-  if (!fillUnfuzzy(unfuzzy, labels, clustering, rlabel))
+  if (!checkClustering(clustering, nClust, docOf.size()))
     return octave_value_list();
 
+  // Count
+  Matrix unfuzzy(labels.length(), nClust, 0.0);
+  fillUnfuzzy(unfuzzy, docOf, clustering, 0);
+
   // Return
   octave_value_list output;
   output.resize(2);
@@ -195,3 +246,82 @@ Find the unfuzzy matrix for one clustering.\n\
   output(1) = octave_value(Cell(labels));
   return output;
 }
+
+
+// Find the unfuzzy matrix of several clusterings
+DEFUN_DLD(comb_unfuzzy_matrices, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {[Matrix, KM, Labels] =} comb_unfuzzy_matrices(@var{rlabel_file}, @var{clustering}, @var{nclusters}, ...)\n\
+\n\
+Find the unfuzzy matrix of several clusterings of the same data,\n\
+reading @var{rlabel_file} only once.\n\
+\n\
+The unfuzzy matrices of the <@var{clustering}, @var{nclusters}> pairs\n\
+are joined side by side, and @var{KM} holds their numbers of clusters.\n\
+@end deftypefn") {
+  // Check argument number
+  int nArgs = args.length();
+  if (nArgs < 3 || nArgs % 2 != 1 || nargout > 3) {
+    print_usage("comb_unfuzzy_matrices");
+    return octave_value_list();
+  }
+
+  // Check types of arguments
+  if (!args(0).is_string()) {
+    error("RLABEL_FILE should be a filename");
+    return octave_value_list();
+  }
+
+  int nClusterings = (nArgs - 1) / 2;
+  vector<Matrix> clusterings(nClusterings);
+  vector<int>    first(nClusterings + 1, 0);
+  for (int c = 0; c < nClusterings; ++c) {
+    if (!args(2 * c + 1).is_real_matrix() ||
+        args(2 * c + 1).columns() != 1) {
+      error("CLUSTERING should be a column vector");
+      return octave_value_list();
+    }
+
+    if (!args(2 * c + 2).is_real_scalar()) {
+      error("NCLUSTERS should be a scalar");
+      return octave_value_list();
+    }
+
+    clusterings[c] = args(2 * c + 1).matrix_value();
+    first[c + 1]   = first[c] + args(2 * c + 2).int_value();
+
+    if (clusterings[c].rows() != clusterings[0].rows()) {
+      error("every CLUSTERING should have the same length");
+      return octave_value_list();
+    }
+  }
+
+  // String
+  string rlabel = args(0).string_value();
+
+  // Documents, once
+  vector<int>   docOf;
+  string_vector labels;
+  if (!readRlabel(docOf, labels, rlabel, clusterings[0].rows()))
+    return octave_value_list();
+
+  // Count
+  Matrix unfuzzy(labels.length(), first[nClusterings], 0.0);
+  Matrix km(nClusterings, 1);
+  for (int c = 0; c < nClusterings; ++c) {
+    if (!checkClustering(clusterings[c], first[c + 1] - first[c],
+                         docOf.size()))
+      return octave_value_list();
+
+    fillUnfuzzy(unfuzzy, docOf, clusterings[c], first[c]);
+    km(c) = first[c + 1] - first[c];
+  }
+
+  // Return
+  octave_value_list output;
+  output.resize(3);
+  output(0) = octave_value(unfuzzy);
+  output(1) = octave_value(km);
+  output(2) = octave_value(Cell(labels));
+  return output;
+}
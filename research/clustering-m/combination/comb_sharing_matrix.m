@@ -7,8 +7,13 @@ function M = comb_sharing_matrix (Clustering)
     error('Clustering should be a column vector');
   end
 
-  %% Create the matrix
-  M = ((Clustering * ones(1, nelems) ==
-        ones(nelems, 1) * Clustering'));
+  %% Create the matrix (sparse, only the pairs sharing a cluster)
+  M = comb_coassociation(Clustering) ~= 0;
+
+  %% Keep it sparse only if it is: a sparse logical entry takes about
+  %% ten times the memory of a dense one
+  if nnz(M) > nelems ^ 2 / 10
+    M = full(M);
+  end
 
 % end function
@@ -12,18 +12,8 @@ function [ CM KM Labels ] = comb_unfuzzy_matrix (rlabel, varargin)
     error('The number of arguments should be pair');
   end
 
-  %% Turn it into a single matrix
-  CM = [];
-  KM = zeros((nargin - 1)/ 2, 1);
-
-  j  = 1;
-  for i = 1 : 2 : (nargin - 1)
-    [TM Labels] = comb_one_unfuzzy_matrix (varargin{i}, varargin{i+1}, rlabel);
-    CM          = [ CM TM ];
-    KM(j)       = varargin{i+1};
-
-    j = j + 1;
-  end
+  %% Turn it into a single matrix, reading rlabel once
+  [ CM KM Labels ] = comb_unfuzzy_matrices (rlabel, varargin{:});
 
   %% That's all
 
@@ -11,18 +11,16 @@ rlabel  = argv{2};
 %% Load labels
 [ L n ] = read_labels_num(rlabel, doc2cat);
 
-%% Read every cluster
+%% Evaluate every clustering at once
 [ length dummy ] = size(argv);
-for i = 3:length
-  %% Read
-  [ C nc ] = read_clustering(argv{i});
-
-  %% Find purity
-  [ nmi Occ ] = meas_nmi(C, L);
+M = meas_batch(L, argv{3:length});
 
-  %% Number of clusters (real)
-  nr = sum(sum(Occ') ~= 0);
+%% Output
+for i = 3:length
+  %% Number of clusters (real and given)
+  nr = M.clusters(i - 2);
+  nc = M.k(i - 2);
 
   %% Output
-  printf("%s %g %d/%d/%d\n", argv{i}, nmi, nr, nc, n);
+  printf("%s %g %d/%d/%d\n", argv{i}, M.nmi(i - 2), nr, nc, n);
 end
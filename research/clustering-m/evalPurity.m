@@ -12,18 +12,17 @@ rlabel  = args{2};
 %% Load labels
 [ L n ] = read_labels_num(rlabel, doc2cat);
 
-%% Read every cluster
+%% Evaluate every clustering at once
 [ length dummy ] = size(args);
-for i = 3 : length
-  %% Read
-  [ C nc ] = read_clustering(args{i});
-
-  %% Find purity
-  [ pur ipur f1 Occ ] = meas_purity(C, L);
+M = meas_batch(L, args{3 : length});
 
-  %% Number of clusters (real)
-  nr = sum(sum(Occ') ~= 0);
+%% Output
+for i = 3 : length
+  %% Number of clusters (real and given)
+  nr = M.clusters(i - 2);
+  nc = M.k(i - 2);
 
   %% Output
-  printf("%s %g %g %g %d/%d/%d\n", args{i}, pur, ipur, f1, nr, nc, n);
+  printf("%s %g %g %g %d/%d/%d\n", args{i}, M.purity(i - 2), ...
+         M.ipurity(i - 2), M.f1(i - 2), nr, nc, n);
 end
@@ -11,18 +11,17 @@ rlabel  = argv{2};
 %% Load labels
 [ L n ] = read_labels_num(rlabel, doc2cat);
 
-%% Read every cluster
+%% Evaluate every clustering at once
 [ length dummy ] = size(argv);
-for i = 3:length
-  %% Read
-  [ C nc ] = read_clustering(argv{i});
+M = meas_batch(L, argv{3 : length});
 
-  %% Find purity
-  [ pur ipur f1 Occ ] = meas_purity(C, L);
-
-  %% Number of clusters (real)
-  nr = sum(sum(Occ') ~= 0);
+%% Output
+for i = 3 : length
+  %% Number of clusters (real and given)
+  nr = M.clusters(i - 2);
+  nc = M.k(i - 2);
 
   %% Output
-  printf("%s %g %g %g %d/%d/%d\n", argv{i}, pur, ipur, f1, nr, nc, n);
+  printf("%s %g %g %g %d/%d/%d\n", argv{i}, M.purity(i - 2), ...
+         M.ipurity(i - 2), M.f1(i - 2), nr, nc, n);
 end
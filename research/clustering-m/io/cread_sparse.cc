@@ -7,6 +7,9 @@
 #include <map>
 #include <set>
 #include <vector>
+
+#include "read_clustering.h"
+
 using namespace std;
 
 // Buffer sizes
@@ -686,73 +689,17 @@ DEFUN_DLD(read_clustering, args, nargout,
 \n\
 Load a clustering.\n\
 @end deftypefn") {
-  // Buffer
-  char buffer  [MAX_LINE_LENGTH];
-  char filename[MAX_LINE_LENGTH];
-
   // Check the parameter
   if (args.length() != 1 || !args(0).is_string()) {
     print_usage("cread_clustering");
     return octave_value_list();
   }
 
-  // Open the file
-  strcpy(filename, args(0).string_value().c_str());
-  FILE* file = fopen(filename, "r");
-  if (!file) {
-    error("cread_clustering: cannot open file %s", filename);
-    return octave_value_list();
-  }
-
-  // Now, reserve a vector
+  // Read it
   vector<int> clustering;
-
-  // Different clusters
-  int k = -1;
-
-  // Current row
-  int r = 1;
-
-  // Auxiliary vars
-  char *p, *q, *perr;
-  unsigned long int col;
-  double val;
-  bool   more;
-
-  // Read every line
-  while(fgets(buffer, MAX_LINE_LENGTH, file)) {
-    // Current cluster
-    int cluster;
-
-    // Process
-    if (!sscanf(buffer, "%d", &cluster)) {
-      error("cread_clustering: ill formed line (not an integer) at %s:%d",
-            filename, r);
-      fclose(file);
-      return octave_value_list();
-    }
-
-    // Update k?
-    if (cluster > k)
-      k = cluster;
-
-    // Add it
-    clustering.push_back(cluster);
-
-    // Next row
-    ++r;
-  }
-
-  // Error or EOF?
-  if (ferror(file)) {
-    error("cread_clustering: input error at %s:%d",
-          filename, r);
-    fclose(file);
+  int k;
+  if (!readClustering(clustering, k, args(0).string_value(), true))
     return octave_value_list();
-  }
-
-  // Free
-  fclose(file);
 
   // Output colum vector
   ColumnVector dclust(clustering.size());
@@ -766,6 +713,6 @@ Load a clustering.\n\
   octave_value_list output;
   output.resize(2);
   output(0) = octave_value(dclust);
-  output(1) = octave_value(k + 1);
+  output(1) = octave_value(k);
   return output;
 }
@@ -0,0 +1,65 @@
+#ifndef READ_CLUSTERING_H
+#define READ_CLUSTERING_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <octave/oct.h>
+
+// Read a clustering file, with a cluster label per line
+// k is set to the largest label plus one. Labels must be non-negative,
+// or -1 (an unassigned point) if allowUnassigned is true.
+// Returns false (after reporting an error) if it cannot be read
+inline bool readClustering(std::vector<int>& clustering,
+                           int& k,
+                           const std::string& filename,
+                           bool allowUnassigned) {
+  // Open the file
+  FILE* file = fopen(filename.c_str(), "r");
+  if (!file) {
+    error("cannot open file %s", filename.c_str());
+    return false;
+  }
+
+  // Buffer
+  char buffer[2048];
+
+  // Smallest valid label
+  int minLabel = allowUnassigned ? -1 : 0;
+
+  // Read every line
+  k = 0;
+  int r = 1;
+  clustering.clear();
+  while (fgets(buffer, sizeof(buffer), file)) {
+    // Current cluster
+    int cluster;
+    if (sscanf(buffer, "%d", &cluster) != 1 || cluster < minLabel) {
+      error("ill formed line (not a label) at %s:%d", filename.c_str(), r);
+      fclose(file);
+      return false;
+    }
+
+    // Update k?
+    if (cluster >= k)
+      k = cluster + 1;
+
+    // Add it
+    clustering.push_back(cluster);
+    ++r;
+  }
+
+  // Error or EOF?
+  bool failed = ferror(file);
+  fclose(file);
+  if (failed) {
+    error("input error at %s:%d", filename.c_str(), r);
+    return false;
+  }
+
+  // Fine
+  return true;
+}
+
+#endif
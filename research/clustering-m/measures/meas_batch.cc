@@ -0,0 +1,427 @@
+#include <octave/oct.h>
+#include <octave/oct-map.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "read_clustering.h"
+
+using namespace std;
+
+
+/*******************/
+/* Occurrency data */
+/*******************/
+
+// Dense tables are always allowed up to this size (in cells), and up
+// to the number of points beyond it; larger ones are kept in a hash
+#define MIN_DENSE_CELLS (1 << 16)
+
+// Occurrency table of a clustering against the labels
+// Dense when it is small enough, and a hash of the non-empty cells
+// (open addressing, keyed by cluster * nLabels + label) otherwise
+struct occTable {
+  // Sizes
+  int nClust;
+  int nLabels;
+
+  // Dense counts (cluster * nLabels + label)
+  vector<int> dense;
+
+  // Hash keys (-1 when empty) and counts
+  vector<int64_t> keys;
+  vector<int>     counts;
+  size_t          used;
+};
+
+
+// Prepare a table
+void initTable(occTable& table,
+               int nClust,
+               int nLabels,
+               int nData) {
+  table.nClust  = nClust;
+  table.nLabels = nLabels;
+  table.used    = 0;
+
+  double cells = double(nClust) * nLabels;
+  if (cells <= MIN_DENSE_CELLS || cells <= nData) {
+    table.dense.assign(nClust * nLabels, 0);
+  }
+  else {
+    table.keys  .assign(1024, -1);
+    table.counts.assign(1024,  0);
+  }
+}
+
+
+// Slot of a key in a hash
+inline size_t hashSlot(const vector<int64_t>& keys,
+                       int64_t key) {
+  size_t mask = keys.size() - 1;
+  size_t slot = size_t((uint64_t(key) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+  while (keys[slot] != -1 && keys[slot] != key)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+
+// Add a point to a table
+inline void addPoint(occTable& table,
+                     int cluster,
+                     int label) {
+  // Dense?
+  if (!table.dense.empty()) {
+    ++table.dense[cluster * table.nLabels + label];
+    return;
+  }
+
+  // Grow the hash when half full
+  if (2 * (table.used + 1) > table.keys.size()) {
+    vector<int64_t> oldKeys  (table.keys.size() * 2, -1);
+    vector<int>     oldCounts(table.keys.size() * 2,  0);
+    oldKeys  .swap(table.keys);
+    oldCounts.swap(table.counts);
+    for (size_t s = 0; s < oldKeys.size(); ++s)
+      if (oldKeys[s] != -1) {
+        size_t slot = hashSlot(table.keys, oldKeys[s]);
+        table.keys  [slot] = oldKeys  [s];
+        table.counts[slot] = oldCounts[s];
+      }
+  }
+
+  // Add
+  int64_t key  = int64_t(cluster) * table.nLabels + label;
+  size_t  slot = hashSlot(table.keys, key);
+  if (table.keys[slot] == -1) {
+    table.keys[slot] = key;
+    ++table.used;
+  }
+  ++table.counts[slot];
+}
+
+
+// Non-empty cells of a table
+void tableCells(vector<int>& clusters,
+                vector<int>& labels,
+                vector<int>& counts,
+                const occTable& table) {
+  clusters.clear();
+  labels  .clear();
+  counts  .clear();
+
+  // Dense
+  if (!table.dense.empty()) {
+    for (int c = 0; c < table.nClust; ++c)
+      for (int l = 0; l < table.nLabels; ++l)
+        if (table.dense[c * table.nLabels + l]) {
+          clusters.push_back(c);
+          labels  .push_back(l);
+          counts  .push_back(table.dense[c * table.nLabels + l]);
+        }
+  }
+
+  // Hash
+  else {
+    for (size_t s = 0; s < table.keys.size(); ++s)
+      if (table.keys[s] != -1) {
+        clusters.push_back(int(table.keys[s] / table.nLabels));
+        labels  .push_back(int(table.keys[s] % table.nLabels));
+        counts  .push_back(table.counts[s]);
+      }
+  }
+}
+
+
+/************/
+/* Measures */
+/************/
+
+// Measures found for every clustering
+enum measure {
+  M_NMI, M_PURITY, M_IPURITY, M_F1, M_ARI,
+  M_PART_DIFF, M_KATZ_POWELL, M_COHEN_KAPPA, M_CHISQ, M_CAT_UTIL,
+  M_CLUSTERS, M_K, N_MEASURES
+};
+
+// Their names in the output struct
+const char* measureNames[N_MEASURES] = {
+  "nmi", "purity", "ipurity", "f1", "ari",
+  "part_diff", "katz_powell", "cohen_kappa", "chisq", "cat_util",
+  "clusters", "k"
+};
+
+
+// Pairs among n elements
+inline double pairs(double n) {
+  return n * (n - 1) / 2;
+}
+
+
+// Find the measures of a table
+// nFillC and nFillL are the points with a cluster and with a label
+void tableMeasures(double* result,
+                   const occTable& table,
+                   double nFillC,
+                   double nFillL) {
+  // Cells
+  vector<int> clusters, labels, counts;
+  tableCells(clusters, labels, counts, table);
+
+  // Marginals, and largest cell of each cluster and label
+  vector<double> marC(table.nClust,  0.0), maxC(table.nClust,  0.0);
+  vector<double> marL(table.nLabels, 0.0), maxL(table.nLabels, 0.0);
+  double tot = 0.0;
+  for (size_t k = 0; k < counts.size(); ++k) {
+    marC[clusters[k]] += counts[k];
+    marL[labels  [k]] += counts[k];
+    maxC[clusters[k]]  = max(maxC[clusters[k]], double(counts[k]));
+    maxL[labels  [k]]  = max(maxL[labels  [k]], double(counts[k]));
+    tot += counts[k];
+  }
+
+  // Sums over the marginals
+  double entC = 0.0, entL = 0.0, sumMaxC = 0.0, sumMaxL = 0.0;
+  double sqC = 0.0, sqL = 0.0, pairsC = 0.0, pairsL = 0.0, nonEmpty = 0.0;
+  for (int c = 0; c < table.nClust; ++c)
+    if (marC[c] > 0) {
+      entC     += marC[c] * log(marC[c] / tot);
+      sumMaxC  += maxC[c];
+      sqC      += marC[c] * marC[c];
+      pairsC   += pairs(marC[c]);
+      nonEmpty += 1;
+    }
+  for (int l = 0; l < table.nLabels; ++l)
+    if (marL[l] > 0) {
+      entL     += marL[l] * log(marL[l] / tot);
+      sumMaxL  += maxL[l];
+      sqL      += marL[l] * marL[l];
+      pairsL   += pairs(marL[l]);
+    }
+
+  // Sums over the cells
+  double mi = 0.0, sq = 0.0, pairsCL = 0.0, chisq = 0.0, condSq = 0.0;
+  for (size_t k = 0; k < counts.size(); ++k) {
+    double n      = counts[k];
+    double expect = marC[clusters[k]] * marL[labels[k]] / tot;
+    mi      += n * log(n / expect);
+    sq      += n * n;
+    pairsCL += pairs(n);
+    chisq   += (n - expect) * (n - expect) / expect - expect;
+    condSq  += n * n / marC[clusters[k]];
+  }
+
+  // The empty cells add their expected value to chi square
+  chisq += tot;
+
+  // NMI
+  result[M_NMI] = mi / sqrt(entC * entL);
+
+  // Purity, inverse purity and F1
+  result[M_PURITY]  = sumMaxC / nFillC;
+  result[M_IPURITY] = sumMaxL / nFillL;
+  result[M_F1]      = 2 * result[M_PURITY] * result[M_IPURITY] /
+                      (result[M_PURITY] + result[M_IPURITY]);
+
+  // Adjusted Rand index
+  double expected = pairsC * pairsL / pairs(tot);
+  double maximum  = (pairsC + pairsL) / 2;
+  result[M_ARI]   = (pairsCL - expected) / (maximum - expected);
+
+  // Consensus measures, as meas_consensus finds them from the sharing
+  // matrices (n1, n2 and n12 are the number of ones in the first, the
+  // second and both), and chi square
+  double n1 = sqC, n2 = sqL, n12 = sq, n2tot = tot * tot;
+  result[M_PART_DIFF]   = n1 + n2 - 2 * n12;
+  result[M_KATZ_POWELL] = (n2tot * n12 - n1 * n2) /
+                          sqrt(n1 * (n2tot - n1) * n2 * (n2tot - n2));
+  result[M_COHEN_KAPPA] = n2tot == n1 * n2 ? 1.0 :
+                          (n12 - n1 * n2) / (n2tot - n1 * n2);
+  result[M_CHISQ]       = chisq;
+  result[M_CAT_UTIL]    = condSq - sqL;
+
+  // Non-empty clusters
+  result[M_CLUSTERS] = nonEmpty;
+}
+
+
+// Read a column of labels
+// Returns false (after reporting an error) if some value is not an
+// integer label (or -1)
+bool readColumn(vector<int>& column,
+                const Matrix& mat,
+                int col) {
+  column.resize(mat.rows());
+  for (int i = 0; i < mat.rows(); ++i) {
+    double value = mat(i, col);
+    if (value < -1 || value != floor(value) || value > 2e9) {
+      error("clusterings should hold integer labels (or -1)");
+      return false;
+    }
+    column[i] = int(value);
+  }
+  return true;
+}
+
+
+/*******************/
+/* Octave-C++ Glue */
+/*******************/
+
+// Evaluate several clusterings at once
+DEFUN_DLD(meas_batch, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {M =} meas_batch(@var{labels}, @var{clustering}, ...)\n\
+\n\
+Evaluate several clusterings against reference @var{labels}.\n\
+\n\
+Each clustering is either a file name, loaded as @code{read_clustering}\n\
+does, or a matrix with a clustering per column. Points labelled -1 in\n\
+the reference or in a clustering are left out of its measures, as\n\
+@code{meas_occ} does.\n\
+\n\
+@var{M} is a struct with a column vector, holding an element per\n\
+clustering, for each of: nmi, purity, ipurity, f1 (as @code{meas_nmi}\n\
+and @code{meas_purity} find them), ari (adjusted Rand index),\n\
+part_diff, katz_powell, cohen_kappa, cat_util (as @code{meas_consensus}\n\
+finds them), chisq (Pearson's chi square of the occurrency matrix, the\n\
+expected count of a cell being the product of its marginals over the\n\
+points), clusters (non-empty clusters) and k (largest cluster plus one,\n\
+as @code{read_clustering} gives it).\n\
+@end deftypefn") {
+  // Check argument number
+  if (args.length() < 2 || nargout > 1) {
+    print_usage("meas_batch");
+    return octave_value_list();
+  }
+
+  // Check the labels
+  if (!args(0).is_real_matrix() || args(0).columns() != 1) {
+    error("LABELS should be a column vector");
+    return octave_value_list();
+  }
+
+  vector<int> labels;
+  if (!readColumn(labels, args(0).matrix_value(), 0))
+    return octave_value_list();
+  int nData = labels.size();
+
+  // Read the clusterings (point-major)
+  vector< vector<int> > columns;
+  for (int a = 1; a < args.length(); ++a) {
+    // A file?
+    if (args(a).is_string()) {
+      columns.push_back(vector<int>());
+      int k;
+      if (!readClustering(columns.back(), k, args(a).string_value(), true))
+        return octave_value_list();
+    }
+
+    // A matrix
+    else if (args(a).is_real_matrix()) {
+      Matrix mat = args(a).matrix_value();
+      for (int c = 0; c < mat.cols(); ++c) {
+        columns.push_back(vector<int>());
+        if (!readColumn(columns.back(), mat, c))
+          return octave_value_list();
+      }
+    }
+
+    // Something else
+    else {
+      error("each clustering should be a file name or a matrix");
+      return octave_value_list();
+    }
+
+    // Same size?
+    if (!columns.empty() && int(columns.back().size()) != nData) {
+      error("every clustering should have as many points as LABELS");
+      return octave_value_list();
+    }
+  }
+
+  int nClusterings = columns.size();
+  vector<int> clusterings(max(nData * nClusterings, 1));
+  for (int f = 0; f < nClusterings; ++f) {
+    for (int i = 0; i < nData; ++i)
+      clusterings[i * nClusterings + f] = columns[f][i];
+    vector<int>().swap(columns[f]);
+  }
+
+  // Number of labels, and of clusters in each clustering
+  int nLabels = 0;
+  for (int i = 0; i < nData; ++i)
+    nLabels = max(nLabels, labels[i] + 1);
+
+  vector<int> nClust(nClusterings, 0);
+  for (int i = 0; i < nData; ++i)
+    for (int f = 0; f < nClusterings; ++f)
+      nClust[f] = max(nClust[f], clusterings[i * nClusterings + f] + 1);
+
+  // Results (clustering-major)
+  vector<double> results(max(nClusterings * N_MEASURES, 1));
+
+#pragma omp parallel
+  {
+    // Block of clusterings of this thread
+    int thread = 0, nThreads = 1;
+#ifdef _OPENMP
+    thread   = omp_get_thread_num();
+    nThreads = omp_get_num_threads();
+#endif
+    int first = (nClusterings * thread)       / nThreads;
+    int last  = (nClusterings * (thread + 1)) / nThreads;
+
+    // Tables, and filled points
+    vector<occTable> tables(last - first);
+    vector<double>   nFillC(last - first, 0.0);
+    for (int f = first; f < last; ++f)
+      initTable(tables[f - first], max(nClust[f], 1), max(nLabels, 1), nData);
+
+    // One pass over the points
+    double nFillL = 0.0;
+    for (int i = 0; i < nData; ++i) {
+      int        label = labels[i];
+      const int* row   = &clusterings[i * nClusterings];
+      if (label != -1)
+        nFillL += 1;
+
+      for (int f = first; f < last; ++f)
+        if (row[f] != -1) {
+          nFillC[f - first] += 1;
+          if (label != -1)
+            addPoint(tables[f - first], row[f], label);
+        }
+    }
+
+    // Measures
+    for (int f = first; f < last; ++f) {
+      tableMeasures(&results[f * N_MEASURES], tables[f - first],
+                    nFillC[f - first], nFillL);
+      results[f * N_MEASURES + M_K] = nClust[f];
+    }
+  }
+
+  // Fill the struct
+  Octave_map measures;
+  for (int m = 0; m < N_MEASURES; ++m) {
+    ColumnVector values(nClusterings);
+    for (int f = 0; f < nClusterings; ++f)
+      values(f) = results[f * N_MEASURES + m];
+    measures.assign(measureNames[m], octave_value(values));
+  }
+
+  // Return
+  octave_value_list output;
+  output.resize(1);
+  output(0) = octave_value(measures);
+  return output;
+}
@@ -12,34 +12,27 @@ function c = meas_consensus (cfunc, Clust1, Clust2)
     error('Clusterings should be of the same size');
   end
 
+  %% Pairs sharing a cluster in the first, the second and both
+  %% clusterings (the number of ones in their sharing matrices, and in
+  %% their product)
+  if any(strcmp(cfunc, { 'part_diff', 'katz_powell', 'cohen_kappa' }))
+    n1  = nnz(comb_coassociation(Clust1));
+    n2  = nnz(comb_coassociation(Clust2));
+    n12 = nnz(comb_coassociation([ Clust1, Clust2 ], 2));
+  end
+
   %% Switch
   if strcmp(cfunc, 'part_diff')
     %% Partition difference
-    M1 = comb_sharing_matrix(Clust1);
-    M2 = comb_sharing_matrix(Clust2);
-    c  = sum(sum((M1 - M2) .^ 2));
+    c   = n1 + n2 - 2 * n12;
 
   elseif strcmp(cfunc, 'katz_powell')
     %% Katz & Powell Index
-    M1  = comb_sharing_matrix(Clust1);
-    M2  = comb_sharing_matrix(Clust2);
-
-    n1  = sum(sum(M1));
-    n2  = sum(sum(M2));
-    n12 = sum(sum(M1 .* M2));
-
     c   = (nelems ^ 2 * n12 - n1 * n2) / ...
         sqrt(n1 * (nelems ^ 2 - n1) * n2 * (nelems ^ 2 - n2));
 
   elseif strcmp(cfunc, 'cohen_kappa')
     %% Cohen's kappa
-    M1  = comb_sharing_matrix(Clust1);
-    M2  = comb_sharing_matrix(Clust2);
-
-    n1  = sum(sum(M1))
-    n2  = sum(sum(M2))
-    n12 = sum(sum(M1 .* M2))
-
     if nelems ^ 2 == n1 * n2
       c = 1;
     else
@@ -0,0 +1,66 @@
+%% -*- mode: octave; -*-
+
+%% comb_coassociation test
+%% Its counts are the sums of the sharing matrices of every clustering,
+%% as comb_sharing_matrix found them before, -1 labels included
+
+%% Path
+addpath ../combination
+addpath ../measures
+
+%% Sharing matrix, as comb_sharing_matrix found it
+function M = old_sharing_matrix(Clustering)
+  nelems = rows(Clustering);
+  M      = (Clustering * ones(1, nelems) == ones(nelems, 1) * Clustering');
+endfunction
+
+%% Random clusterings of 120 points, some of them with unassigned
+%% points, and one with labels far larger than their number
+rand("seed", 29);
+nelems      = 120;
+clusterings = floor(diag([ 2, 4, 7, 12 ]) * rand(4, nelems))';
+clusterings(rand(nelems, 1) < 0.2, 2) = -1;
+clusterings(rand(nelems, 1) < 0.5, 3) = -1;
+clusterings(:, 4) = 1000 * clusterings(:, 4) + 7;
+
+%% One by one
+Sum = zeros(nelems);
+for c = 1 : columns(clusterings)
+  Old = old_sharing_matrix(clusterings(:, c));
+  CC  = comb_coassociation(clusterings(:, c));
+  assert(issparse(CC));
+  assert(full(CC), double(Old));
+  assert(full(comb_sharing_matrix(clusterings(:, c))), Old);
+  Sum = Sum + Old;
+endfor
+
+%% Every unassigned point together
+assert(full(comb_coassociation(-ones(nelems, 1))), ones(nelems));
+
+%% All of them, with and without a minimum count
+assert(full(comb_coassociation(clusterings)), Sum);
+for minCount = 2 : 4
+  assert(full(comb_coassociation(clusterings, minCount)), ...
+         Sum .* (Sum >= minCount));
+endfor
+
+%% The pairwise consensus measures take unassigned points
+Clust1 = clusterings(:, 1);
+Clust2 = clusterings(:, 3);
+M1     = old_sharing_matrix(Clust1);
+M2     = old_sharing_matrix(Clust2);
+n1     = sum(sum(M1));
+n2     = sum(sum(M2));
+n12    = sum(sum(M1 .* M2));
+assert(meas_consensus("part_diff", Clust1, Clust2), sum(sum((M1 - M2) .^ 2)));
+assert(meas_consensus("katz_powell", Clust1, Clust2), ...
+       (nelems ^ 2 * n12 - n1 * n2) / ...
+       sqrt(n1 * (nelems ^ 2 - n1) * n2 * (nelems ^ 2 - n2)), 1e-12);
+assert(meas_consensus("cohen_kappa", Clust1, Clust2), ...
+       (n12 - n1 * n2) / (nelems ^ 2 - n1 * n2), 1e-12);
+
+%% Non-integer labels are rejected
+fail("comb_coassociation([ 0 ; 0.5 ])");
+
+%% Display
+printf("comb_coassociation: OK\n");
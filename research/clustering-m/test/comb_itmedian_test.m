@@ -0,0 +1,64 @@
+%% -*- mode: octave; -*-
+
+%% comb_itmedian test
+%% A hand-computed median, unassigned points, a cost that never goes up,
+%% and the byte and uint16 label rows giving the same partitions
+
+%% Path
+addpath ../combination
+
+%% Five points in four clusterings, the last one with unassigned points
+%% With a single cluster the prototype is the most frequent label of
+%% each clustering, [ 0 1 1 -1 ], and the points disagree with it in
+%% 1 + 0 + 1 + 2 + 2 = 6 clusterings
+tiny = [ 0 0 1 -1 ;
+         0 1 1 -1 ;
+         0 1 0 -1 ;
+         1 1 1  0 ;
+         2 1 1  1 ];
+rand("seed", 3);
+[ clust, protos, cost, iters ] = comb_itmedian(tiny, 1);
+assert(clust,  zeros(5, 1));
+assert(protos, [ 0 1 1 -1 ]);
+assert(cost,   6);
+
+%% With as many clusters as points, every point is its own prototype
+[ clust, protos, cost ] = comb_itmedian(tiny, 5);
+assert(cost, 0);
+assert(sortrows(protos), sortrows(tiny));
+assert(protos(clust + 1, :), tiny);
+
+%% Random clusterings of 400 points, with some unassigned points
+rand("seed", 41);
+nelems      = 400;
+clusterings = floor(diag([ 3, 5, 8, 4, 6 ]) * rand(5, nelems))';
+clusterings(rand(nelems, 1) < 0.1, 2) = -1;
+
+%% The cost after each iteration never goes up
+rand("state", 8);
+[ clust, protos, cost, iters ] = comb_itmedian(clusterings, 6);
+costs = zeros(iters + 1, 1);
+for i = 0 : iters
+  rand("state", 8);
+  [ c_i, p_i, costs(i + 1) ] = ...
+      comb_itmedian(clusterings, 6, struct("max_iterations", i));
+endfor
+assert(all(diff(costs) <= 0));
+assert(costs(end), cost);
+
+%% Labels above 255 use uint16 rows, and only their equality matters
+wide       = clusterings;
+wide(:, 3) = 300 * wide(:, 3);
+assert(max(wide(:, 3)) > 255);
+rand("state", 8);
+[ clust_w, protos_w, cost_w, iters_w ] = comb_itmedian(wide, 6);
+assert(clust_w, clust);
+assert(cost_w,  cost);
+assert(iters_w, iters);
+assert(protos_w(:, 3), 300 * protos(:, 3));
+
+%% Labels below -1 are rejected
+fail("comb_itmedian([ 0 ; -2 ], 1)");
+
+%% Display
+printf("comb_itmedian: OK\n");
@@ -0,0 +1,83 @@
+%% -*- mode: octave; -*-
+
+%% comb_mem_fit test
+%% From the same seed, comb_mem_fit finds the same starts, models and
+%% log-likelihoods as the EM loop that comb_combine_mem ran in Octave
+
+%% Path
+addpath ../combination
+
+%% Tolerance
+tol = 1e-8;
+
+%% Four random clusterings of 150 points
+rand("seed", 23);
+sizes_in    = [ 3 ; 4 ; 5 ; 3 ];
+clusterings = floor(diag(sizes_in) * rand(4, 150))';
+[ CM, KM, elems ] = comb_mem_labels(clusterings, sizes_in);
+
+%% EM settings
+k        = 4;
+restarts = 5;
+deltaTh  = 1e-8 * elems;
+
+%% Unweighted and weighted models
+for w = { [], [ 0.5 ; 1.5 ; 1 ; 1 ] }
+  Weights = w{1};
+
+  %% The Octave loop
+  rand("seed", 7);
+  llikes = zeros(restarts, 1);
+  iters  = zeros(restarts, 1);
+  for j = 1 : restarts
+    %% Random starting model
+    model = comb_mem_initialize(k, KM);
+    if !isempty(Weights)
+      model = comb_mem_addweight(model, Weights);
+    endif
+    model = comb_mem_model(model);
+
+    %% Iterate until it converges
+    Exp = comb_mem_expectation(model, CM);
+    do
+      OExp     = Exp;
+      model    = comb_mem_maximization(CM, KM, Exp, model);
+      Exp      = comb_mem_expectation(model, CM);
+      delta    = sum(sum((Exp - OExp) .^ 2));
+      iters(j) = iters(j) + 1;
+    until (delta < deltaTh)
+
+    %% Keep the best
+    llikes(j) = comb_mem_loglike(model, CM);
+    if llikes(j) == max(llikes(1 : j))
+      bestExp = Exp;
+    endif
+  endfor
+
+  %% comb_mem_fit, with no iteration cap
+  opts = struct("restarts", restarts, "delta", deltaTh, ...
+                "max_iterations", Inf);
+  if !isempty(Weights)
+    opts.weights = Weights;
+  endif
+  rand("seed", 7);
+  [ fit_model, fit_Exp, fit_llikes, trace ] = comb_mem_fit(CM, KM, k, opts);
+
+  %% The same
+  assert(fit_llikes, llikes, tol * max(abs(llikes)));
+  assert(fit_Exp, bestExp, tol);
+  for j = 1 : restarts
+    assert(rows(trace{j}), iters(j));
+  endfor
+
+  %% With a cap, every start stops there
+  opts.max_iterations = 2;
+  rand("seed", 7);
+  [ fit_model, fit_Exp, fit_llikes, trace ] = comb_mem_fit(CM, KM, k, opts);
+  for j = 1 : restarts
+    assert(rows(trace{j}), min(iters(j), 2));
+  endfor
+endfor
+
+%% Display
+printf("comb_mem_fit: OK\n");
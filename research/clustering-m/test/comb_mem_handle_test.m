@@ -0,0 +1,36 @@
+%% -*- mode: octave; -*-
+
+%% comb_mem handle test
+%% Handles given in the wrong place are rejected, not taken for another
+%% kind of handle
+
+%% Path
+addpath ../combination
+
+%% Two random clusterings of 50 points, in a labels handle
+rand("seed", 5);
+clusterings             = floor(3 * rand(50, 2));
+[ data, sizes, nelems ] = comb_mem_labels(clusterings, [ 3 ; 3 ]);
+
+%% A model, in a model handle
+model  = comb_mem_initialize(3, sizes);
+handle = comb_mem_model(model);
+
+%% In the right place
+expec = comb_mem_expectation(handle, data);
+assert(size(expec), [ nelems, 3 ]);
+assert(comb_mem_loglike(handle, data), comb_mem_loglike(model, data), 1e-10);
+comb_mem_maximization(data, sizes, expec, handle);
+assert(comb_mem_labels_matrix(data), clusterings);
+comb_mem_model_struct(handle);
+
+%% Swapped
+fail("comb_mem_expectation(data, handle)");
+fail("comb_mem_loglike(data, handle)");
+fail("comb_mem_maximization(handle, sizes, expec)");
+fail("comb_mem_maximization(data, sizes, expec, data)");
+fail("comb_mem_labels_matrix(handle)");
+fail("comb_mem_model_struct(data)");
+
+%% Display
+printf("comb_mem handles: OK\n");
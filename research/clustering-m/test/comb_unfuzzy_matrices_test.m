@@ -0,0 +1,80 @@
+%% -*- mode: octave; -*-
+
+%% comb_unfuzzy_matrices test
+%% Reading the rlabel file once gives the same matrix as joining the
+%% comb_one_unfuzzy_matrix of every clustering
+
+%% Path
+addpath ../combination
+
+%% An rlabel file of 40 lines from 6 documents, in no particular order,
+%% with both separators
+rand("seed", 49);
+nelems = 40;
+docs   = { "alpha", "beta", "gamma", "delta", "doc 5", "last" };
+doc_of = floor(6 * rand(nelems, 1)) + 1;
+doc_of(1 : 6) = [ 3 ; 1 ; 3 ; 6 ; 2 ; 1 ];
+doc_of(7 : 9) = [ 4 ; 5 ; 4 ];
+seps   = "SXsx";
+file   = tmpnam();
+fid    = fopen(file, "w");
+for i = 1 : nelems
+  fprintf(fid, "%s%c%d\n", docs{doc_of(i)}, seps(1 + mod(i, 4)), i);
+endfor
+fclose(fid);
+
+%% Documents are numbered in order of appearance
+order = { "gamma", "alpha", "last", "beta", "delta", "doc 5" };
+
+%% Three clusterings
+ks          = [ 2 ; 5 ; 3 ];
+clusterings = floor(diag(ks) * rand(3, nelems))';
+
+%% One by one
+CM_one = [];
+for c = 1 : 3
+  [ M, Labels ] = comb_one_unfuzzy_matrix(clusterings(:, c), ks(c), file);
+  assert(size(M), [ 6, ks(c) ]);
+  assert(Labels(:)', order);
+  assert(sum(M(:)), nelems);
+
+  %% Counts by hand
+  for d = 1 : 6
+    in_doc = strcmp(docs(doc_of), order{d});
+    for l = 1 : ks(c)
+      assert(M(d, l), sum(in_doc(:) & clusterings(:, c) == l - 1));
+    endfor
+  endfor
+
+  CM_one = [ CM_one, M ];
+endfor
+
+%% All of them at once, directly and through comb_unfuzzy_matrix
+[ CM, KM, Labels ] = comb_unfuzzy_matrices(file, ...
+                                           clusterings(:, 1), ks(1), ...
+                                           clusterings(:, 2), ks(2), ...
+                                           clusterings(:, 3), ks(3));
+assert(CM, CM_one);
+assert(KM, ks);
+assert(Labels(:)', order);
+
+[ CM_w, KM_w, Labels_w ] = comb_unfuzzy_matrix(file, ...
+                                               clusterings(:, 1), ks(1), ...
+                                               clusterings(:, 2), ks(2), ...
+                                               clusterings(:, 3), ks(3));
+assert(CM_w, CM_one);
+assert(KM_w, ks);
+
+%% A single clustering
+assert(comb_unfuzzy_matrices(file, clusterings(:, 2), ks(2)), ...
+       CM_one(:, ks(1) + (1 : ks(2))));
+
+%% Labels out of range, clusterings of different lengths, and rlabel
+%% files longer than the clusterings are rejected
+fail("comb_unfuzzy_matrices(file, clusterings(:, 1), ks(1), clusterings(:, 2), 2)");
+fail("comb_unfuzzy_matrices(file, clusterings(:, 1), ks(1), clusterings(1 : 30, 2), ks(2))");
+fail("comb_unfuzzy_matrices(file, clusterings(1 : 30, 1), ks(1))");
+unlink(file);
+
+%% Display
+printf("comb_unfuzzy_matrices: OK\n");
@@ -0,0 +1,81 @@
+%% -*- mode: octave; -*-
+
+%% meas_batch test
+%% Its measures match those of meas_nmi, meas_purity and meas_consensus
+%% on random clusterings, given as matrices or as files
+
+%% Path
+addpath ../measures
+addpath ../combination
+addpath ../io
+
+%% Tolerance
+tol = 1e-10;
+
+%% Random labels and clusterings of 200 points, where every label and
+%% cluster is used
+rand("seed", 11);
+nelems      = 200;
+labels      = floor(4 * rand(nelems, 1));
+labels(1:4) = 0 : 3;
+clusterings = floor(diag([ 2, 5, 9 ]) * rand(3, nelems))';
+clusterings(1:9, :) = [ mod(0 : 8, 2) ; mod(0 : 8, 5) ; 0 : 8 ]';
+
+%% All of them at once
+M = meas_batch(labels, clusterings);
+assert(size(M.nmi), [ 3, 1 ]);
+
+%% One by one
+for c = 1 : 3
+  clust = clusterings(:, c);
+
+  %% meas_nmi and meas_purity
+  assert(M.nmi(c), meas_nmi(clust, labels), tol);
+  [ pur ipur f1 ] = meas_purity(clust, labels);
+  assert([ M.purity(c), M.ipurity(c), M.f1(c) ], [ pur, ipur, f1 ], tol);
+
+  %% meas_consensus
+  assert(M.part_diff(c),   meas_consensus("part_diff",   clust, labels), tol);
+  assert(M.katz_powell(c), meas_consensus("katz_powell", clust, labels), tol);
+  assert(M.cohen_kappa(c), meas_consensus("cohen_kappa", clust, labels), tol);
+  assert(M.cat_util(c),    meas_consensus("cat_util",    clust, labels), tol);
+
+  %% Pearson's chi square
+  Occ = meas_occ(clust, labels);
+  Exp = sum(Occ, 2) * sum(Occ) / nelems;
+  assert(M.chisq(c), sum(sum((Occ - Exp) .^ 2 ./ Exp)), tol);
+
+  %% Clusters
+  assert(M.clusters(c), max(clust) + 1);
+  assert(M.k(c),        max(clust) + 1);
+endfor
+
+%% Some points left out, in the labels and in a clustering
+labels_u         = labels;
+labels_u(10:20)  = -1;
+clust_u          = clusterings(:, 2);
+clust_u(15:30)   = -1;
+M_u = meas_batch(labels_u, clust_u);
+assert(M_u.nmi, meas_nmi(clust_u, labels_u), tol);
+[ pur ipur f1 ] = meas_purity(clust_u, labels_u);
+assert([ M_u.purity, M_u.ipurity, M_u.f1 ], [ pur, ipur, f1 ], tol);
+
+%% The same clustering from a file
+file = tmpnam();
+fid  = fopen(file, "w");
+fprintf(fid, "%d\n", clust_u);
+fclose(fid);
+[ clust_f, k_f ] = read_clustering(file);
+assert(clust_f, clust_u);
+assert(k_f, max(clust_u) + 1);
+M_f = meas_batch(labels_u, file, clust_u);
+for field = fieldnames(M_f)'
+  assert(M_f.(field{1}), M_u.(field{1}) * [ 1 ; 1 ], tol);
+endfor
+
+%% comb_mem_labels does not take unassigned points
+fail("comb_mem_labels(file)");
+unlink(file);
+
+%% Display
+printf("meas_batch: OK\n");
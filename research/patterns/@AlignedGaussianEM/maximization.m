@@ -23,18 +23,18 @@ function [ model ] = maximization(this, data, expec)
   %% Mean
   cl_mu = full(data * expec') ./ (ones(n_dims, 1) * cl_sizes); % n_dims * k
 
+  %% Sums of squares
+  %% (All clusters in a single pass)
+  cl_sum2 = full((data .* data) * expec'); % n_dims * k
+
   %% Inverse covariances and normalization factors
   cl_isigma = zeros(n_dims, k); % n_dims * k
   cl_norm   = zeros(1, k);
 
   %% Find each
   for c = 1 : k
-    %% Sum of squares
-    sum2 = full(sum((data .* data) .* ...
-                    (ones(n_dims, 1) * expec(c, :)), 2)); % n_dims * 1
-
     %% Variances
-    sigma = sum2 / cl_sizes(c) - cl_mu(:, c) .* cl_mu(:, c);
+    sigma = cl_sum2(:, c) / cl_sizes(c) - cl_mu(:, c) .* cl_mu(:, c);
 
     %% Check the minimum covariance is OK
     if ~isnan(this.min_covar) && min(sigma) < this.min_covar
@@ -50,7 +50,8 @@ function [ model ] = maximization(this, data, expec)
 
       %% Normalization factor
       %% \log \frac{1}{\sqrt{(2 \pi)^k \cdot | \Sigma |}}
-      cl_norm(c) = -0.5 * (n_dims * log(2 * pi) + log(prod(sigma)));
+      %% (Summing logs, as prod(sigma) underflows in high dimension)
+      cl_norm(c) = -0.5 * (n_dims * log(2 * pi) + sum(log(sigma)));
     endif
   endfor
 
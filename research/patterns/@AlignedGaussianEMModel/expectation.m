@@ -14,24 +14,10 @@ function [ expec, log_like ] = expectation(this, data)
                   " @AlignedGaussianEMModel/expectation(this, data)"));
   endif
 
-  %% Number of data
-  [ n_dims, n_data ] = size(data);
-
   %% Raw probability
-  %% Start with the a priori probabilities and normalization terms
-  expec = this.alpha_norm' * ones(1, n_data);
-
-  %% For each cluster
-  for c = 1 : this.k
-    %% Center the data
-    cdata = data - this.mu(:, c) * ones(1, n_data);
-
-    %% Distance
-    dist = sum(cdata .* (diag(this.isigma(:, c)) * cdata), 1);
-
-    %% Find it
-    expec(c, :) -= 0.5 * dist;
-  endfor
+  %% A priori probabilities and normalization terms, minus half the
+  %% variance-weighted distance
+  expec = diagonal_log_density(this.alpha_norm, this.mu, this.isigma, data);
 
   %% Normalize
   max_expec = max(expec);
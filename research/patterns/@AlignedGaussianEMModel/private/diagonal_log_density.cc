@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <exception>
+// #include <iostream>
+#include <vector>
+
+#include <octave/oct.h>
+
+// Helper function (dense data)
+/* Fills _expec(c, j) = alpha_norm(c) - 0.5 * sum_d (x_dj - mu_dc)^2 / s_dc
+*/
+static void diagonal_log_density(Matrix& _expec,
+                                 const RowVector& _alpha_norm,
+                                 const Matrix& _mu,
+                                 const Matrix& _isigma,
+                                 const Matrix& _data) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type k      = _mu.columns();
+
+  // Resize expectation
+  _expec.resize(k, n_data, 0.0);
+
+  // Raw arrays
+  double*       expec  = _expec.fortran_vec();
+  const double* alpha  = _alpha_norm.data();
+  const double* mu     = _mu.data();
+  const double* isigma = _isigma.data();
+  const double* data   = _data.data();
+
+  // For each sample
+#pragma omp parallel for schedule(static)
+  for (octave_idx_type j = 0; j < n_data; ++j) {
+    const double* x = data + j * n_dims;
+
+    // For each cluster
+    for (octave_idx_type c = 0; c < k; ++c) {
+      const double* mu_c = mu     + c * n_dims;
+      const double* iv_c = isigma + c * n_dims;
+
+      // Weighted distance
+      double dist = 0.0;
+#pragma omp simd reduction(+:dist)
+      for (octave_idx_type d = 0; d < n_dims; ++d) {
+        double diff = x[d] - mu_c[d];
+        dist += diff * diff * iv_c[d];
+      }
+
+      // Set it
+      expec[c + j * k] = alpha[c] - 0.5 * dist;
+    }
+  }
+}
+
+// Helper function (sparse data)
+/* Uses the decomposition
+   sum_d (x_d - mu_d)^2 / s_d =
+     sum_d x_d^2 / s_d - 2 sum_d x_d mu_d / s_d + sum_d mu_d^2 / s_d
+   where the first two terms only involve the non-zeros of x
+*/
+static void diagonal_log_density(Matrix& _expec,
+                                 const RowVector& _alpha_norm,
+                                 const Matrix& _mu,
+                                 const Matrix& _isigma,
+                                 const SparseMatrix& _data) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type k      = _mu.columns();
+
+  // Resize expectation
+  _expec.resize(k, n_data, 0.0);
+
+  // Transposed inverse variances and scaled centers
+  /* Cluster-major, so that each non-zero touches contiguous memory */
+  std::vector<double> iv_t(n_dims * k);
+  std::vector<double> mu_t(n_dims * k);
+
+  // Constant terms
+  std::vector<double> base(k);
+
+  // Find them
+  for (octave_idx_type c = 0; c < k; ++c) {
+    double mu2 = 0.0;
+    for (octave_idx_type d = 0; d < n_dims; ++d) {
+      double iv = _isigma(d, c);
+      iv_t[c + d * k] = iv;
+      mu_t[c + d * k] = 2.0 * iv * _mu(d, c);
+      mu2            += iv * _mu(d, c) * _mu(d, c);
+    }
+    base[c] = _alpha_norm(c) - 0.5 * mu2;
+  }
+
+  // Raw arrays
+  double*                expec = _expec.fortran_vec();
+  const octave_idx_type* cidx  = _data.cidx();
+  const octave_idx_type* ridx  = _data.ridx();
+  const double*          nnz   = _data.data();
+  const double*          iv    = &iv_t.front();
+  const double*          mux   = &mu_t.front();
+
+  // For each sample
+#pragma omp parallel for schedule(dynamic, 256)
+  for (octave_idx_type j = 0; j < n_data; ++j) {
+    // Output column
+    double* e_j = expec + j * k;
+
+    // Start with the constant terms
+    std::copy(base.begin(), base.end(), e_j);
+
+    // Add the non-zeros
+    for (octave_idx_type p = cidx[j]; p < cidx[j + 1]; ++p) {
+      const double* iv_d  = iv  + ridx[p] * k;
+      const double* mux_d = mux + ridx[p] * k;
+      double x  = nnz[p];
+      double x2 = x * x;
+#pragma omp simd
+      for (octave_idx_type c = 0; c < k; ++c)
+        e_j[c] -= 0.5 * (x2 * iv_d[c] - x * mux_d[c]);
+    }
+  }
+}
+
+// Octave callback
+DEFUN_DLD(diagonal_log_density, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{expec} ] =} diagonal_log_density(@var{alpha_norm}, @var{mu},\
+ @var{isigma}, @var{data})\n\
+\n\
+Find the unnormalized log-density of @var{data} for each cluster of an\n\
+axis-aligned Gaussian mixture, given the inverse variances @var{isigma}\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() != 4 or nargout > 1)
+      throw (const char*)0;
+
+    // Check alpha_norm
+    if (not args(0).is_matrix_type() or args(0).rows() != 1)
+      throw "alpha_norm should be a row vector";
+
+    // Get alpha_norm
+    RowVector alpha_norm = args(0).row_vector_value();
+    octave_idx_type k = alpha_norm.length();
+
+    // Check mu
+    if (not args(1).is_matrix_type())
+      throw "mu should be a matrix";
+
+    // Get mu
+    Matrix mu = args(1).matrix_value();
+    octave_idx_type n_dims = mu.rows();
+    if (mu.columns() != k)
+      throw "mu and alpha_norm should have the same number of columns";
+
+    // Check isigma
+    if (not args(2).is_matrix_type())
+      throw "isigma should be a matrix";
+
+    // Get isigma
+    Matrix isigma = args(2).matrix_value();
+    if (isigma.rows() != n_dims or isigma.columns() != k)
+      throw "isigma and mu should have the same size";
+
+    // Check data
+    if (not args(3).is_matrix_type())
+      throw "data should be a matrix";
+
+    // Expectation
+    Matrix expec;
+
+    // Get data
+    if (args(3).is_sparse_type()) {
+      // As a sparse matrix
+      SparseMatrix data = args(3).sparse_matrix_value();
+
+      // Check dimensions
+      if (data.rows() != n_dims)
+        throw "mu and data should have the same number of rows";
+
+      // Find log-densities
+      diagonal_log_density(expec, alpha_norm, mu, isigma, data);
+    }
+    else {
+      // As a dense matrix
+      Matrix data = args(3).matrix_value();
+
+      // Check dimensions
+      if (data.rows() != n_dims)
+        throw "mu and data should have the same number of rows";
+
+      // Find log-densities
+      diagonal_log_density(expec, alpha_norm, mu, isigma, data);
+    }
+
+    // Prepare output
+    result.resize(1);
+    result(0) = expec;
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
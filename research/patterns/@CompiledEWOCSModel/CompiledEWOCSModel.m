@@ -0,0 +1,31 @@
+%% -*- mode: octave; -*-
+
+%% Ensemble Weak One-Class Scoring
+%% Compiled model constructor
+
+%% Author: Edgar Gonzalez
+
+function [ this ] = CompiledEWOCSModel(centroids, offsets, radii, ...
+                                       cluster_scores, inter_model)
+
+  %% Check arguments
+  if nargin() ~= 5
+    usage(cstrcat("[ this ] = CompiledEWOCSModel(centroids, offsets, ", ...
+                  "radii, cluster_scores, inter_model)"));
+  endif
+
+  %% This object
+  this = struct();
+
+  %% Set fields
+  this.centroids      = centroids;      % n_dims * sum(k_r)
+  this.offsets        = offsets;        % 1 * (r + 1)
+  this.radii          = radii;          % 1 * r
+  this.cluster_scores = cluster_scores; % 1 * sum(k_r)
+  this.inter_model    = inter_model;
+
+  %% Bless
+  %% And add inheritance
+  this = class(this, "CompiledEWOCSModel", ...
+               Simple());
+endfunction
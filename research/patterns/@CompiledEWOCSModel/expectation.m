@@ -0,0 +1,24 @@
+%% -*- mode: octave; -*-
+
+%% Ensemble Weak One-Class Scoring
+%% Compiled expectation
+
+%% Author: Edgar Gonzalez
+
+function [ expec, log_like, scores ] = expectation(this, data)
+
+  %% Check arguments
+  if nargin() ~= 2
+    usage(cstrcat("[ expec, log_like, scores ] = ", ...
+                  "@CompiledEWOCSModel/expectation(this, data)"));
+  endif
+
+  %% Find the scores
+  scores = score(this, data);
+
+  %% Interpolate them
+  expec = apply(this.inter_model, scores);
+
+  %% Log-like is not considered here
+  log_like = nan;
+endfunction
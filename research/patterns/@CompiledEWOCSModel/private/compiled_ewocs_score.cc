@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+// #include <iostream>
+#include <vector>
+
+#include <octave/oct.h>
+
+// Flattened ensemble
+struct flat_ensemble {
+  // Number of dimensions
+  octave_idx_type n_dims;
+
+  // Number of members
+  octave_idx_type n_members;
+
+  // Total number of clusters
+  octave_idx_type n_clusters;
+
+  // Centroids (n_dims x n_clusters, column-major)
+  const double* centroids;
+
+  // Centroids transposed (n_clusters x n_dims, for sparse data)
+  std::vector<double> centroids_t;
+
+  // Squared centroid norms
+  std::vector<double> norms;
+
+  // First cluster of each member (n_members + 1 entries)
+  std::vector<octave_idx_type> offsets;
+
+  // Radius of each member
+  const double* radii;
+
+  // Score of each cluster
+  const double* cluster_scores;
+};
+
+// Accumulate the score of one sample
+/* _dots holds x . c for every centroid, _x2 is || x ||^2 */
+static inline double sample_score(const flat_ensemble& _ens,
+                                  const double* _dots, double _x2) {
+  // Score
+  double score = 0.0;
+
+  // For each member
+  for (octave_idx_type m = 0; m < _ens.n_members; ++m) {
+    // Closest cluster
+    octave_idx_type win      = -1;
+    double          win_dist = INFINITY;
+    for (octave_idx_type c = _ens.offsets[m]; c < _ens.offsets[m + 1]; ++c) {
+      double dist = _x2 - 2.0 * _dots[c] + _ens.norms[c];
+      if (dist < win_dist) {
+        win      = c;
+        win_dist = dist;
+      }
+    }
+
+    // Within the radius?
+    if (win != -1 and win_dist <= _ens.radii[m])
+      score += _ens.cluster_scores[win];
+  }
+
+  // Return it
+  return score;
+}
+
+// Helper function (dense data)
+static void compiled_ewocs_score(RowVector& _scores,
+                                 const flat_ensemble& _ens,
+                                 const Matrix& _data) {
+  // Sizes
+  octave_idx_type n_dims = _ens.n_dims;
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type n_cls  = _ens.n_clusters;
+
+  // Raw arrays
+  double*       scores = _scores.fortran_vec();
+  const double* data   = _data.data();
+
+#pragma omp parallel
+  {
+    // Thread-private dot products
+    std::vector<double> dots(n_cls);
+
+    // For each sample
+#pragma omp for schedule(static)
+    for (octave_idx_type j = 0; j < n_data; ++j) {
+      const double* x = data + j * n_dims;
+
+      // Norm
+      double x2 = 0.0;
+#pragma omp simd reduction(+:x2)
+      for (octave_idx_type d = 0; d < n_dims; ++d)
+        x2 += x[d] * x[d];
+
+      // Dot products
+      for (octave_idx_type c = 0; c < n_cls; ++c) {
+        const double* cen = _ens.centroids + c * n_dims;
+        double dot = 0.0;
+#pragma omp simd reduction(+:dot)
+        for (octave_idx_type d = 0; d < n_dims; ++d)
+          dot += x[d] * cen[d];
+        dots[c] = dot;
+      }
+
+      // Score
+      scores[j] = sample_score(_ens, &dots.front(), x2) / _ens.n_members;
+    }
+  }
+}
+
+// Helper function (sparse data)
+static void compiled_ewocs_score(RowVector& _scores,
+                                 const flat_ensemble& _ens,
+                                 const SparseMatrix& _data) {
+  // Sizes
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type n_cls  = _ens.n_clusters;
+
+  // Raw arrays
+  double*                scores = _scores.fortran_vec();
+  const octave_idx_type* cidx   = _data.cidx();
+  const octave_idx_type* ridx   = _data.ridx();
+  const double*          nnz    = _data.data();
+  const double*          cen_t  = &_ens.centroids_t.front();
+
+#pragma omp parallel
+  {
+    // Thread-private dot products
+    std::vector<double> dots(n_cls);
+
+    // For each sample
+#pragma omp for schedule(dynamic, 256)
+    for (octave_idx_type j = 0; j < n_data; ++j) {
+      // Reset
+      std::fill(dots.begin(), dots.end(), 0.0);
+      double x2 = 0.0;
+
+      // Add the non-zeros
+      for (octave_idx_type p = cidx[j]; p < cidx[j + 1]; ++p) {
+        const double* cen_d = cen_t + ridx[p] * n_cls;
+        double x = nnz[p];
+        x2 += x * x;
+#pragma omp simd
+        for (octave_idx_type c = 0; c < n_cls; ++c)
+          dots[c] += x * cen_d[c];
+      }
+
+      // Score
+      scores[j] = sample_score(_ens, &dots.front(), x2) / _ens.n_members;
+    }
+  }
+}
+
+// Octave callback
+DEFUN_DLD(compiled_ewocs_score, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{scores} ] =} compiled_ewocs_score(@var{centroids}, @var{offsets},\
+ @var{radii}, @var{cluster_scores}, @var{data})\n\
+\n\
+Find the EWOCS ensemble scores of @var{data}, given the flattened\n\
+@var{centroids} and @var{cluster_scores} of every member, the 1-based\n\
+@var{offsets} of the first cluster of each member (plus one past the\n\
+last), and the @var{radii} of each member\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() != 5 or nargout > 1)
+      throw (const char*)0;
+
+    // Check centroids
+    if (not args(0).is_matrix_type() or args(0).is_sparse_type())
+      throw "centroids should be a full matrix";
+
+    // Get centroids
+    Matrix centroids = args(0).matrix_value();
+
+    // Flattened ensemble
+    flat_ensemble ens;
+    ens.n_dims     = centroids.rows();
+    ens.n_clusters = centroids.columns();
+    ens.centroids  = centroids.data();
+
+    // Check offsets
+    if (not args(1).is_matrix_type() or args(1).rows() != 1 or
+        args(1).columns() < 2)
+      throw "offsets should be a row vector";
+
+    // Get offsets
+    RowVector offsets = args(1).row_vector_value();
+    ens.n_members = offsets.length() - 1;
+    ens.offsets.resize(offsets.length());
+    for (octave_idx_type m = 0; m <= ens.n_members; ++m) {
+      ens.offsets[m] = octave_idx_type(offsets(m)) - 1;
+      if (ens.offsets[m] < 0 or ens.offsets[m] > ens.n_clusters or
+          (m > 0 and ens.offsets[m] < ens.offsets[m - 1]))
+        throw "offsets should be increasing indices into centroids";
+    }
+    if (ens.offsets[ens.n_members] != ens.n_clusters)
+      throw "the last offset should be one past the last centroid";
+
+    // Check radii
+    if (not args(2).is_matrix_type() or args(2).rows() != 1 or
+        args(2).columns() != ens.n_members)
+      throw "radii should be a row vector with one element per member";
+
+    // Get radii
+    RowVector radii = args(2).row_vector_value();
+    ens.radii = radii.data();
+
+    // Check cluster_scores
+    if (not args(3).is_matrix_type() or args(3).rows() != 1 or
+        args(3).columns() != ens.n_clusters)
+      throw "cluster_scores should be a row vector with one element per centroid";
+
+    // Get cluster_scores
+    RowVector cluster_scores = args(3).row_vector_value();
+    ens.cluster_scores = cluster_scores.data();
+
+    // Squared norms and transposed centroids
+    ens.norms      .resize(ens.n_clusters);
+    ens.centroids_t.resize(ens.n_clusters * ens.n_dims);
+    for (octave_idx_type c = 0; c < ens.n_clusters; ++c) {
+      double norm = 0.0;
+      for (octave_idx_type d = 0; d < ens.n_dims; ++d) {
+        norm += centroids(d, c) * centroids(d, c);
+        ens.centroids_t[c + d * ens.n_clusters] = centroids(d, c);
+      }
+      ens.norms[c] = norm;
+    }
+
+    // Check data
+    if (not args(4).is_matrix_type())
+      throw "data should be a matrix";
+
+    // Scores
+    RowVector scores(args(4).columns(), 0.0);
+
+    // Get data
+    if (args(4).is_sparse_type()) {
+      // As a sparse matrix
+      SparseMatrix data = args(4).sparse_matrix_value();
+
+      // Check dimensions
+      if (data.rows() != ens.n_dims)
+        throw "centroids and data should have the same number of rows";
+
+      // Find scores
+      compiled_ewocs_score(scores, ens, data);
+    }
+    else {
+      // As a dense matrix
+      Matrix data = args(4).matrix_value();
+
+      // Check dimensions
+      if (data.rows() != ens.n_dims)
+        throw "centroids and data should have the same number of rows";
+
+      // Find scores
+      compiled_ewocs_score(scores, ens, data);
+    }
+
+    // Prepare output
+    result.resize(1);
+    result(0) = scores;
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
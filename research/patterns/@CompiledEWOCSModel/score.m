@@ -0,0 +1,18 @@
+%% -*- mode: octave; -*-
+
+%% Ensemble Weak One-Class Scoring
+%% Compiled scoring function
+
+%% Author: Edgar Gonzalez
+
+function [ scores ] = score(this, data)
+
+  %% Check arguments
+  if nargin() ~= 2
+    usage("[ scores ] = @CompiledEWOCSModel/score(this, data)");
+  endif
+
+  %% Call the helper function
+  scores = compiled_ewocs_score(this.centroids, this.offsets, this.radii, ...
+                                this.cluster_scores, data);
+endfunction
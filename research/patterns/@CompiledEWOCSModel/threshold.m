@@ -0,0 +1,17 @@
+%% -*- mode: octave; -*-
+
+%% Ensemble Weak One-Class Scoring
+%% Compiled score threshold
+
+%% Author: Edgar Gonzalez
+
+function [ score_threshold ] = threshold(this)
+
+  %% Check arguments
+  if nargin() ~= 1
+    usage("[ score_threshold ] = @CompiledEWOCSModel/threshold(this)");
+  endif
+
+  %% It is the inverse of 0.5 by the interpolation model
+  score_threshold = inverse(this.inter_model, 0.5);
+endfunction
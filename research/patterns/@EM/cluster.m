@@ -36,6 +36,9 @@ function [ expec, model, info ] = cluster(this, data, k, expec_0)
     fig = [];
   endif
 
+  %% Keep what every maximization on this data set shares
+  this = prepare(this, data);
+
   %% First maximization
   model = maximization(this, data, expec_0);
 
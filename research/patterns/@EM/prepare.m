@@ -0,0 +1,10 @@
+%% -*- mode: octave; -*-
+
+%% Expectation-Maximization clustering
+%% Preparation for a data set
+
+%% Author: Edgar Gonzalez
+
+function [ this ] = prepare(this, data)
+  %% Nothing to keep by default
+endfunction
@@ -34,6 +34,15 @@ function [ this ] = EWOCS(clusterer, opts = struct())
   %% Default -> false
   this.verbose = getfielddef(opts, "verbose", false());
 
+  %% Ensemble seed
+  %% Member i is run after seeding with a value derived from it and i
+  %% Default -> [] (drawn from the current random state)
+  this.seed = getfielddef(opts, "seed", []);
+
+  %% Number of worker processes
+  %% Default -> 1 (run in this process)
+  this.workers = getfielddef(opts, "workers", 1);
+
   %% Scoring function name
   %% Default -> Size
   if ~isfield(opts, "score_function")
@@ -0,0 +1,84 @@
+%% -*- mode: octave; -*-
+
+%% Ensemble Weak One-Class Scoring
+%% Run the ensemble members on forked worker processes
+
+%% Author: Edgar Gonzalez
+
+function [ ensemble_models, ensemble_cluster_scores, ensemble_scores ] = ...
+      fork_members(this, data, ensemble_seed, eff_min_clusters, eff_range)
+
+  %% Number of workers
+  n_workers = min(this.workers, this.ensemble_size);
+
+  %% Ensemble components
+  ensemble_models         = cell(1, this.ensemble_size);
+  ensemble_cluster_scores = cell(1, this.ensemble_size);
+  ensemble_scores         = cell(1, this.ensemble_size);
+
+  %% Get temporary prefix
+  tmp_prefix = tmpnam();
+  out_files  = cell(1, n_workers);
+  pids       = zeros(1, n_workers);
+
+  %% Start the workers
+  for w = 1 : n_workers
+    out_files{w} = sprintf("%s.%d", tmp_prefix, w);
+
+    %% Fork
+    [ pid, msg ] = fork();
+    if pid < 0
+      error("Cannot fork worker %d: %s", w, msg);
+
+    elseif pid == 0
+      %% Child
+      %% Members are dealt round-robin
+      members        = w : n_workers : this.ensemble_size;
+      models         = cell(1, length(members));
+      cluster_scores = cell(1, length(members));
+      member_scores  = cell(1, length(members));
+      status         = 0;
+      try
+        for m = 1 : length(members)
+          [ models{m}, cluster_scores{m}, member_scores{m} ] = ...
+              run_member(this, data, members(m), ensemble_seed, ...
+                         eff_min_clusters, eff_range);
+        endfor
+        save("-binary", out_files{w}, ...
+             "members", "models", "cluster_scores", "member_scores");
+      catch
+        fprintf(2, "Worker %d failed: %s\n", w, lasterr());
+        status = 1;
+      end_try_catch
+      exit(status);
+    endif
+
+    %% Parent
+    pids(w) = pid;
+  endfor
+
+  %% Collect them
+  failed = false();
+  for w = 1 : n_workers
+    %% Wait
+    waitpid(pids(w));
+
+    %% Load
+    try
+      load(out_files{w}, ...
+           "members", "models", "cluster_scores", "member_scores");
+      unlink(out_files{w});
+
+      ensemble_models        (members) = models;
+      ensemble_cluster_scores(members) = cluster_scores;
+      ensemble_scores        (members) = member_scores;
+    catch
+      failed = true();
+    end_try_catch
+  endfor
+
+  %% Failed?
+  if failed
+    error("Some ensemble workers failed");
+  endif
+endfunction
@@ -0,0 +1,55 @@
+%% -*- mode: octave; -*-
+
+%% Ensemble Weak One-Class Scoring
+%% Run a single ensemble member
+
+%% Author: Edgar Gonzalez
+
+function [ ind_model, ind_cluster_scores, ind_scores ] = ...
+      run_member(this, data, i, ensemble_seed, eff_min_clusters, eff_range)
+
+  %% Size
+  [ n_dims, n_samples ] = size(data);
+
+  %% Keep the state of the caller's generators
+  saved_seeds = get_all_seeds();
+
+  %% Seed the generators for this member
+  %% (Mixed, so that consecutive members get unrelated seeds)
+  set_all_seeds(mod(ensemble_seed * 1000003 + i * 2654435761, 2 ^ 31 - 1));
+
+  %% Select the number of classes and seeds
+  k     = floor(eff_min_clusters + eff_range * rand());
+  seeds = sort(randperm(n_samples)(1 : k));
+
+  %% Seed expectation
+  seed_expec = sparse(1 : k, seeds, ones(1, k), k, n_samples);
+
+  %% Log
+  if this.verbose
+    fprintf(2, "Selected %d seeds for element %d\n", k, i);
+  endif
+
+  %% Find the model
+  [ ind_expec, ind_model, ind_info ] = ...
+      cluster(this.clusterer, data, k, seed_expec);
+
+  %% Log
+  if this.verbose
+    fprintf(2, "Found clustering\n");
+  endif
+
+  %% Cluster scores
+  ind_cluster_scores = cluster_scores(this.score_function, data, ind_expec);
+
+  %% Log
+  if this.verbose
+    fprintf(2, "Found cluster scores\n");
+  endif
+
+  %% Scores
+  ind_scores = full(ind_cluster_scores * ind_expec);
+
+  %% Give the caller's generators back
+  set_all_seeds(saved_seeds);
+endfunction
@@ -32,51 +32,41 @@ function [ scores, model, info, expec ] = score(this, data)
   %% Effective range
   eff_range = eff_max_clusters - eff_min_clusters + 1;
 
-  %% Scores
-  scores = zeros(1, n_samples);
-
-  %% Ensemble components: models and cluster scores
-  ensemble_models         = cell(1, this.ensemble_size);
-  ensemble_cluster_scores = cell(1, this.ensemble_size);
-
-  %% For each element in the ensemble
-  for i = 1 : this.ensemble_size
-
-    %% Select the number of classes and seeds
-    k     = floor(eff_min_clusters + eff_range * rand());
-    seeds = sort(randperm(n_samples)(1 : k));
-
-    %% Seed expectation
-    seed_expec = sparse(1 : k, seeds, ones(1, k), k, n_samples);
-
-    %% Log
-    if this.verbose
-      fprintf(2, "Selected %d seeds for element %d\n", k, i);
-    endif
-
-    %% Find the model
-    [ ind_expec, ind_model, ind_info ] = ...
-        cluster(this.clusterer, data, k, seed_expec);
-
-    %% Log
-    if this.verbose
-      fprintf(2, "Found clustering\n");
-    endif
-
-    %% Cluster scores
-    ind_cluster_scores = cluster_scores(this.score_function, data, ind_expec);
+  %% Ensemble seed
+  if isempty(this.seed)
+    ensemble_seed = floor(rand() * (2 ^ 31 - 1));
+  else
+    ensemble_seed = this.seed;
+  endif
 
-    %% Log
-    if this.verbose
-      fprintf(2, "Found cluster scores\n");
-    endif
+  %% Run the ensemble
+  %% Each member is seeded from ensemble_seed and its index, so the
+  %% result does not depend on the number of workers
+  if this.workers > 1
+    [ ensemble_models, ensemble_cluster_scores, ensemble_scores ] = ...
+        fork_members(this, data, ensemble_seed, ...
+                     eff_min_clusters, eff_range);
 
-    %% Add scores
-    scores += ind_cluster_scores * ind_expec;
+  else
+    %% Ensemble components: models, cluster scores and sample scores
+    ensemble_models         = cell(1, this.ensemble_size);
+    ensemble_cluster_scores = cell(1, this.ensemble_size);
+    ensemble_scores         = cell(1, this.ensemble_size);
+
+    %% For each element in the ensemble
+    for i = 1 : this.ensemble_size
+      [ ensemble_models{i}, ensemble_cluster_scores{i}, ...
+        ensemble_scores{i} ] = ...
+          run_member(this, data, i, ensemble_seed, ...
+                     eff_min_clusters, eff_range);
+    endfor
+  endif
 
-    %% Store for the model
-    ensemble_models        {i} = ind_model;
-    ensemble_cluster_scores{i} = ind_cluster_scores;
+  %% Add scores
+  %% (Always in member order, so the sum is reproducible)
+  scores = zeros(1, n_samples);
+  for i = 1 : this.ensemble_size
+    scores += ensemble_scores{i};
   endfor
 
   %% Divide scores
@@ -0,0 +1,53 @@
+%% -*- mode: octave; -*-
+
+%% Ensemble Weak One-Class Scoring
+%% Compile into a flat model
+
+%% Author: Edgar Gonzalez
+
+function [ compiled ] = compile(this)
+
+  %% Check arguments
+  if nargin() ~= 1
+    usage("[ compiled ] = @EWOCSModel/compile(this)");
+  endif
+
+  %% Ensemble size
+  ensemble_size = length(this.models);
+
+  %% Members
+  member_centroids = cell(1, ensemble_size);
+  radii            = zeros(1, ensemble_size);
+  offsets          = ones(1, ensemble_size + 1);
+
+  %% For each element in the ensemble
+  for i = 1 : ensemble_size
+    %% Model
+    ind_model = this.models{i};
+
+    %% Radius
+    switch class(ind_model)
+      case "KMeansModel"
+        radii(i) = Inf;
+      case "BregmanBallModel"
+        radii(i) = -threshold(ind_model);
+      otherwise
+        error("Cannot compile ensemble members of class '%s'", ...
+              class(ind_model));
+    endswitch
+
+    %% Only squared euclidean distances are supported
+    if ~isa(divergence(ind_model), "SqEuclideanDistance")
+      error("Cannot compile ensemble members with a '%s' divergence", ...
+            class(divergence(ind_model)));
+    endif
+
+    %% Centroids
+    member_centroids{i} = full(centroids(ind_model));
+    offsets(i + 1)      = offsets(i) + columns(member_centroids{i});
+  endfor
+
+  %% Create the compiled model
+  compiled = CompiledEWOCSModel([ member_centroids{:} ], offsets, radii, ...
+                                [ this.cluster_scores{:} ], this.inter_model);
+endfunction
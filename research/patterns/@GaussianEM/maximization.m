@@ -22,9 +22,9 @@ function [ model ] = maximization(this, data, expec)
   %% Mean
   cl_mu = full(data * expec') ./ (ones(n_dims, 1) * cl_sizes); % n_dims * k
 
-  %% Inverse covariances and normalization factors
-  cl_isigma = zeros(n_dims, n_dims, k); % n_dims * n_dims * k
-  cl_norm   = zeros(1, k);
+  %% Cholesky factors and normalization factors
+  cl_chol = zeros(n_dims, n_dims, k); % n_dims * n_dims * k
+  cl_norm = zeros(1, k);
 
   %% Find each
   for c = 1 : k
@@ -35,21 +35,25 @@ function [ model ] = maximization(this, data, expec)
     %% Covariance
     sigma = sum2 / cl_sizes(c) - cl_mu(:, c) * cl_mu(:, c)';
 
+    %% Upper Cholesky factor (sigma = R' * R)
+    [ R, p ] = chol(sigma);
+
     %% Check the minimum covariance is OK
-    if ~isnan(this.min_covar) && min(svd(sigma)) < this.min_covar
+    if p ~= 0 || (~isnan(this.min_covar) && min(svd(sigma)) < this.min_covar)
       %% Unitary covariance
-      cl_isigma(:, :, c) = eye(n_dims);
+      cl_chol(:, :, c) = eye(n_dims);
 
       %% Normalization factor
       cl_norm(c) = -0.5 * n_dims * log(2 * pi);
 
     else
-      %% Inverse
-      cl_isigma(:, :, c) = inv(sigma);
+      %% Factor
+      cl_chol(:, :, c) = R;
 
       %% Normalization factor
       %% \log \frac{1}{\sqrt{(2 \pi)^k \cdot | \Sigma |}}
-      cl_norm(c) = -0.5 * (n_dims * log(2 * pi) + log(det(sigma)));
+      %% with \log | \Sigma | = 2 \sum_i \log R_{ii}
+      cl_norm(c) = -0.5 * n_dims * log(2 * pi) - sum(log(diag(R)));
     endif
   endfor
 
@@ -62,5 +66,5 @@ function [ model ] = maximization(this, data, expec)
   model = GaussianEMModel(k, ...
                           cl_sizes + cl_norm, ... % 1 * k
                           cl_mu,              ... % n_dims * k
-                          cl_isigma);             % n_dims * n_dims * k
+                          cl_chol);               % n_dims * n_dims * k
 endfunction
@@ -5,11 +5,11 @@
 
 %% Author: Edgar Gonzalez
 
-function [ this ] = GaussianEMModel(k, alpha_norm, mu, isigma)
+function [ this ] = GaussianEMModel(k, alpha_norm, mu, chol_sigma)
 
   %% Check arguments
   if nargin() ~= 4
-    usage("[ this ] = GaussianEMModel(k, alpha_norm, mu, isigma)");
+    usage("[ this ] = GaussianEMModel(k, alpha_norm, mu, chol_sigma)");
   endif
 
   %% This object
@@ -19,7 +19,7 @@ function [ this ] = GaussianEMModel(k, alpha_norm, mu, isigma)
   this.k          = k;
   this.alpha_norm = alpha_norm; % 1 * k
   this.mu         = mu;         % n_dims * k
-  this.isigma     = isigma;     % n_dims * n_dims * k
+  this.chol_sigma = chol_sigma; % n_dims * n_dims * k
 
   %% Bless
   %% And add inheritance
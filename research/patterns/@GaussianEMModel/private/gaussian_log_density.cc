@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <exception>
+// #include <iostream>
+#include <vector>
+
+#include <octave/oct.h>
+
+// Block size
+/* Number of data columns solved together against a Cholesky factor */
+static const octave_idx_type BLOCK_SIZE = 64;
+
+// Load a dense block of columns, centered on mu
+static void load_block(double* _block, const double* _mu,
+                       const Matrix& _data,
+                       octave_idx_type _first, octave_idx_type _last) {
+  // Number of dimensions
+  octave_idx_type n_dims = _data.rows();
+
+  // Data
+  const double* data = _data.data();
+
+  // For each column
+  for (octave_idx_type j = _first; j < _last; ++j) {
+    const double* col = data + j * n_dims;
+    for (octave_idx_type d = 0; d < n_dims; ++d)
+      _block[d] = col[d] - _mu[d];
+    _block += n_dims;
+  }
+}
+
+// Load a sparse block of columns, centered on mu
+static void load_block(double* _block, const double* _mu,
+                       const SparseMatrix& _data,
+                       octave_idx_type _first, octave_idx_type _last) {
+  // Number of dimensions
+  octave_idx_type n_dims = _data.rows();
+
+  // Get arrays
+  const octave_idx_type* cidx = _data.cidx();
+  const octave_idx_type* ridx = _data.ridx();
+  const double*          nnz  = _data.data();
+
+  // For each column
+  for (octave_idx_type j = _first; j < _last; ++j) {
+    // Start from -mu
+    for (octave_idx_type d = 0; d < n_dims; ++d)
+      _block[d] = -_mu[d];
+
+    // Add the non-zeros
+    for (octave_idx_type p = cidx[j]; p < cidx[j + 1]; ++p)
+      _block[ridx[p]] += nnz[p];
+
+    _block += n_dims;
+  }
+}
+
+// Helper function
+/* Fills _expec(c, j) = alpha_norm(c) - 0.5 * || R_c^-T (x_j - mu_c) ||^2,
+   where R_c is the upper Cholesky factor of the covariance of cluster c
+*/
+template <typename DMatrix>
+static void gaussian_log_density(Matrix& _expec,
+                                 const RowVector& _alpha_norm,
+                                 const Matrix& _mu,
+                                 const NDArray& _chol,
+                                 const DMatrix& _data) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type k      = _mu.columns();
+
+  // Number of blocks
+  octave_idx_type n_blocks = (n_data + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  // Resize expectation
+  _expec.resize(k, n_data, 0.0);
+
+  // Raw arrays
+  /* Octave containers are not touched inside the parallel region */
+  double*       expec = _expec.fortran_vec();
+  const double* alpha = _alpha_norm.data();
+  const double* mu    = _mu.data();
+  const double* chol  = _chol.data();
+
+#pragma omp parallel
+  {
+    // Thread-private block
+    std::vector<double> block(n_dims * BLOCK_SIZE);
+
+    // For each block and cluster
+#pragma omp for collapse(2) schedule(dynamic)
+    for (octave_idx_type b = 0; b < n_blocks; ++b) {
+      for (octave_idx_type c = 0; c < k; ++c) {
+        // Limits
+        octave_idx_type first = b * BLOCK_SIZE;
+        octave_idx_type last  = std::min(first + BLOCK_SIZE, n_data);
+
+        // Cluster factor and center
+        const double* r_c  = chol + c * n_dims * n_dims;
+        const double* mu_c = mu   + c * n_dims;
+
+        // Center the block
+        load_block(&block.front(), mu_c, _data, first, last);
+
+        // For each column in the block
+        double* y = &block.front();
+        for (octave_idx_type j = first; j < last; ++j) {
+          // Forward substitution on R' y = x - mu
+          /* Column i of R holds R(0:i, i) contiguously */
+          double dist = 0.0;
+          for (octave_idx_type i = 0; i < n_dims; ++i) {
+            const double* r_i = r_c + i * n_dims;
+            double acc = y[i];
+            for (octave_idx_type l = 0; l < i; ++l)
+              acc -= r_i[l] * y[l];
+            y[i]  = acc / r_i[i];
+            dist += y[i] * y[i];
+          }
+
+          // Set it
+          expec[c + j * k] = alpha[c] - 0.5 * dist;
+
+          // Next column
+          y += n_dims;
+        }
+      }
+    }
+  }
+}
+
+// Octave callback
+DEFUN_DLD(gaussian_log_density, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{expec} ] =} gaussian_log_density(@var{alpha_norm}, @var{mu},\
+ @var{chol_sigma}, @var{data})\n\
+\n\
+Find the unnormalized log-density of @var{data} for each cluster of a\n\
+full-covariance Gaussian mixture, given the upper Cholesky factors\n\
+@var{chol_sigma} of the cluster covariances\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() != 4 or nargout > 1)
+      throw (const char*)0;
+
+    // Check alpha_norm
+    if (not args(0).is_matrix_type() or args(0).rows() != 1)
+      throw "alpha_norm should be a row vector";
+
+    // Get alpha_norm
+    RowVector alpha_norm = args(0).row_vector_value();
+    octave_idx_type k = alpha_norm.length();
+
+    // Check mu
+    if (not args(1).is_matrix_type())
+      throw "mu should be a matrix";
+
+    // Get mu
+    Matrix mu = args(1).matrix_value();
+    octave_idx_type n_dims = mu.rows();
+    if (mu.columns() != k)
+      throw "mu and alpha_norm should have the same number of columns";
+
+    // Check chol_sigma
+    if (not args(2).is_matrix_type())
+      throw "chol_sigma should be an array";
+
+    // Get chol_sigma
+    NDArray chol = args(2).array_value();
+    dim_vector chol_dims = chol.dims();
+    if (chol_dims(0) != n_dims or chol_dims(1) != n_dims or
+        chol.numel() != n_dims * n_dims * k)
+      throw "chol_sigma should be of size n_dims x n_dims x k";
+
+    // Check data
+    if (not args(3).is_matrix_type())
+      throw "data should be a matrix";
+
+    // Expectation
+    Matrix expec;
+
+    // Get data
+    if (args(3).is_sparse_type()) {
+      // As a sparse matrix
+      SparseMatrix data = args(3).sparse_matrix_value();
+
+      // Check dimensions
+      if (data.rows() != n_dims)
+        throw "mu and data should have the same number of rows";
+
+      // Find log-densities
+      gaussian_log_density(expec, alpha_norm, mu, chol, data);
+    }
+    else {
+      // As a dense matrix
+      Matrix data = args(3).matrix_value();
+
+      // Check dimensions
+      if (data.rows() != n_dims)
+        throw "mu and data should have the same number of rows";
+
+      // Find log-densities
+      gaussian_log_density(expec, alpha_norm, mu, chol, data);
+    }
+
+    // Prepare output
+    result.resize(1);
+    result(0) = expec;
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
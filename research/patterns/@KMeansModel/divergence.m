@@ -0,0 +1,17 @@
+%% -*- mode: octave; -*-
+
+%% k-Means clustering
+%% Divergence accessor
+
+%% Author: Edgar Gonzalez
+
+function [ div ] = divergence(this);
+
+  %% Check arguments
+  if nargin() ~= 1
+    usage("[ div ] = @KMeansModel/divergence(this)");
+  endif
+
+  %% Return the divergence
+  div = this.divergence;
+endfunction
@@ -22,6 +22,19 @@ function [ this ] = KdeEM(kernel, opts = struct())
   %% Default -> false
   this.verbose = getfielddef(opts, "verbose", false());
 
+  %% Number of landmarks of the low-rank (Nystrom) approximation
+  %% Default -> 0 (exact kernel)
+  this.landmarks = getfielddef(opts, "landmarks", 0);
+
+  %% Landmark selection method ("uniform" or "farthest")
+  %% Default -> "farthest"
+  this.landmark_method = getfielddef(opts, "landmark_method", "farthest");
+
+  %% Landmarks of the current data set, and their K(base, L) * pinv(K(L, L))
+  %% (set by prepare)
+  this.landmark_idx    = [];
+  this.landmark_factor = [];
+
   %% Bless
   %% And add inheritance
   this = class(this, "KdeEM", ...
@@ -12,6 +12,22 @@ function [ model ] = maximization(this, data, expec)
     usage("[ model ] = @KdeEM/maximization(this, data, expec)");
   endif
 
-  %% Just store it
-  model = KdeEMModel(this.kernel, data, expec);
+  %% Number of data
+  [ n_dims, n_data ] = size(data);
+
+  %% Exact?
+  if this.landmarks <= 0 || this.landmarks >= n_data
+    %% Just store it
+    model = KdeEMModel(this.kernel, data, expec);
+
+  else
+    %% Not prepared for this data set (called outside of cluster)?
+    if rows(this.landmark_factor) ~= n_data
+      this = prepare(this, data);
+    endif
+
+    %% Low-rank model
+    model = KdeEMModel(this.kernel, data, expec, ...
+                       data(:, this.landmark_idx), this.landmark_factor);
+  endif
 endfunction
@@ -0,0 +1,36 @@
+%% -*- mode: octave; -*-
+
+%% Kernel Density Estimation EM clustering
+%% Preparation for a data set
+
+%% Author: Edgar Gonzalez
+
+function [ this ] = prepare(this, data)
+
+  %% Check arguments
+  if nargin() ~= 2
+    usage("[ this ] = @KdeEM/prepare(this, data)");
+  endif
+
+  %% Number of data
+  [ n_dims, n_data ] = size(data);
+
+  %% Exact?
+  if this.landmarks <= 0 || this.landmarks >= n_data
+    this.landmark_idx    = [];
+    this.landmark_factor = [];
+
+  else
+    %% Select the landmarks
+    idx = select_landmarks(this.kernel, data, this.landmarks, ...
+                           this.landmark_method);
+
+    %% Nystrom factor, which does not depend on the expectation
+    %% K(base, x) ~ K(base, L) * pinv(K(L, L)) * K(L, x)
+    K_bl = apply(this.kernel, data, data(:, idx)); % n_base * m
+    K_ll = apply(this.kernel, data(:, idx));       % m * m
+
+    this.landmark_idx    = idx;
+    this.landmark_factor = K_bl * pinv(K_ll); % n_base * m
+  endif
+endfunction
@@ -0,0 +1,39 @@
+%% -*- mode: octave; -*-
+
+%% Kernel Density Estimation EM clustering
+%% Landmark selection
+
+%% Author: Edgar Gonzalez
+
+function [ idx ] = select_landmarks(kernel, data, m, method)
+
+  %% Number of data
+  [ n_dims, n_data ] = size(data);
+
+  %% Which method?
+  switch method
+    case "uniform"
+      %% Evenly spaced samples
+      idx = unique(round(linspace(1, n_data, m)));
+
+    case "farthest"
+      %% Farthest-first traversal, taking the farthest sample (in the
+      %% kernel-induced distance) to the landmarks chosen so far
+      self = self_apply(kernel, data); % 1 * n_data
+
+      %% Start with the first sample
+      idx    = zeros(1, m);
+      idx(1) = 1;
+      min_d  = self + self(1) - 2 * apply(kernel, data(:, 1), data);
+
+      %% Add the others
+      for i = 2 : m
+        [ max_d, idx(i) ] = max(min_d);
+        min_d = min(min_d, self + self(idx(i)) - ...
+                           2 * apply(kernel, data(:, idx(i)), data));
+      endfor
+
+    otherwise
+      error(sprintf("Wrong landmark selection method '%s'", method));
+  endswitch
+endfunction
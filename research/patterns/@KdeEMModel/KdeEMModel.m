@@ -5,21 +5,47 @@
 
 %% Author: Edgar Gonzalez
 
-function [ this ] = KdeEMModel(kernel, data, expec)
+function [ this ] = KdeEMModel(kernel, data, expec, landmarks = [], ...
+                                base_factor = [])
 
   %% Check arguments
-  if nargin() ~= 3
-    usage("[ this ] = KdeEMModel(kernel, data, expec)");
+  if ~any(nargin() == [ 3, 4, 5 ])
+    usage(cstrcat("[ this ] = KdeEMModel(kernel, data, expec ", ...
+                  "[, landmarks [, base_factor ] ])"));
   endif
 
   %% This object
   this = struct();
 
   %% Set fields
-  this.kernel = kernel;
-  this.data   = data;
-  this.expec  = expec;
-  this.k      = size(expec, 1);
+  this.kernel    = kernel;
+  this.k         = size(expec, 1);
+  this.landmarks = landmarks; % n_dims * m
+
+  %% Exact?
+  if isempty(landmarks)
+    %% Keep the base data
+    this.data   = data;
+    this.expec  = expec;
+    this.factor = [];
+
+  else
+    %% Nystrom approximation
+    %% K(base, x) ~ K(base, L) * pinv(K(L, L)) * K(L, x)
+    %% base_factor = K(base, L) * pinv(K(L, L)) may be given, as it does
+    %% not change between EM iterations
+    if isempty(base_factor)
+      K_bl        = apply(kernel, data, landmarks); % n_base * m
+      K_ll        = apply(kernel, landmarks);       % m * m
+      base_factor = K_bl * pinv(K_ll);
+    endif
+
+    %% The expectation is folded into the factor, so that only
+    %% K(L, x) is needed afterwards
+    this.data   = [];
+    this.expec  = [];
+    this.factor = expec * base_factor; % k * m
+  endif
 
   %% Bless
   %% And add inheritance
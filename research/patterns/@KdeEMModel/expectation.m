@@ -12,11 +12,22 @@ function [ expec, log_like ] = expectation(this, data)
     usage("[ expec, log_like ] = @KdeEMModel/expectation(this, data)");
   endif
 
-  %% Find the kernel
-  KM = apply(this.kernel, this.data, data); % n_base * n_data
+  %% Exact?
+  if isempty(this.landmarks)
+    %% Find the kernel
+    KM = apply(this.kernel, this.data, data); % n_base * n_data
 
-  %% Add it
-  expec = this.expec * KM;
+    %% Add it
+    expec = this.expec * KM;
+
+  else
+    %% Find the kernel against the landmarks only
+    KM = apply(this.kernel, this.landmarks, data); % m * n_data
+
+    %% Add it
+    %% (The approximation may go slightly negative)
+    expec = max(this.factor * KM, realmin());
+  endif
 
   %% Normalize
   sum_expec = sum(expec);
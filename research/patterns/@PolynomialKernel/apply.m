@@ -12,14 +12,12 @@ function [ result ] = apply(this, source, target)
     usage("[ result ] = @PolynomialKernel/apply(this, source [, target])");
   endif
 
-  %% Find dot product
+  %% Find dot product, add heterogeneousness and elevate, tile by tile
   if nargin() == 2
-    result = source' * source;
+    result = kernel_gram("polynomial", [ this.degree, this.heterogeneous ], ...
+                         source);
   else %% nargin() == 3
-    result = source' * target;
+    result = kernel_gram("polynomial", [ this.degree, this.heterogeneous ], ...
+                         source, target);
   endif
-
-  %% Now, add heterogeneousness and elevate
-  result += this.heterogeneous;
-  result .^ this.degree;
 endfunction
@@ -17,5 +17,5 @@ function [ result ] = apply(this, source)
 
   %% Now, add heterogeneousness and elevate
   result += this.heterogeneous;
-  result .^ this.degree;
+  result  = result .^ this.degree;
 endfunction
@@ -12,18 +12,10 @@ function [ result ] = apply(this, source, target)
     usage("[ result ] = @RBFKernel/apply(this, source [, target])");
   endif
 
-  %% Sizes
-  [ n_dims, n_source ] = size(source);
-
-  %% Squared euclidean distance
-  %% Call helper functions
+  %% Squared euclidean distance and RBF, fused tile by tile
   if nargin() == 2
-    result = sq_euclidean_distance1(source);
+    result = kernel_gram("rbf", this.rbf_gamma, source);
   else %% nargin() == 3
-    result = sq_euclidean_distance2(source, target);
+    result = kernel_gram("rbf", this.rbf_gamma, source, target);
   endif
-
-  %% Now, apply RBF
-  result *= -this.rbf_gamma;
-  result  = exp(result);
 endfunction
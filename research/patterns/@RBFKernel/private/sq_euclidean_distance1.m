@@ -1 +0,0 @@
-../../@SqEuclideanDistance/private/sq_euclidean_distance1.m
\ No newline at end of file
@@ -1 +0,0 @@
-../../@SqEuclideanDistance/private/sq_euclidean_distance2.m
\ No newline at end of file
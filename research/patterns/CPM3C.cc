@@ -1,44 +1,220 @@
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
 #include <vector>
 
 #include <octave/oct.h>
+#include <octave/parse.h>
+#include <octave/ov-struct.h>
 
 #include <ttcl/ut/range.hxx>
 
 
-/*******************************************/
-/* Find the CPM3C most violated constraint */
-/*******************************************/
+/*********************/
+/* Fused column scan */
+/*********************/
+
+// Block size
+/* Number of data columns per parallel work unit */
+static const octave_idx_type BLOCK_SIZE = 256;
+
+// Scan result
+struct cpm3c_scan {
+  // Winner of each sample
+  std::vector<octave_idx_type> win;
+
+  // Runner-up of each sample with a margin under 1 (-1 otherwise)
+  std::vector<octave_idx_type> rup;
+
+  // Violation (normalized)
+  double violation;
+};
+
+// Find the scores of a dense column
+/* _omega_t is omega transposed, k x n_dims */
+static inline void column_scores(double* _scores, const double* _omega_t,
+                                 octave_idx_type _k,
+                                 const Matrix& _data, octave_idx_type _j) {
+  // Column
+  octave_idx_type n_dims = _data.rows();
+  const double*   x      = _data.data() + _j * n_dims;
+
+  // Accumulate
+  std::fill(_scores, _scores + _k, 0.0);
+  for (octave_idx_type d = 0; d < n_dims; ++d) {
+    const double* omega_d = _omega_t + d * _k;
+    double        x_d     = x[d];
+    for (octave_idx_type r = 0; r < _k; ++r)
+      _scores[r] += x_d * omega_d[r];
+  }
+}
 
-DEFUN_DLD(CPM3C_mvc, args, nargout,
-          "-*- texinfo -*-\n\
-@deftypefn {Loadable Function}\
- {[ @var{constraint}, @var{violation}, @var{z}, @var{product} ] =}\
- CPM3C_mvc(@var{data}, @var{omega})\n\
-\n\
-Find the CPM3C most violated constraint\n\
-@end deftypefn") {
-  // Check the number of parameters
-  if (args.length() != 2 or nargout < 1 or nargout > 4) {
-    print_usage();
-    return octave_value_list();
+// Find the scores of a sparse column
+static inline void column_scores(double* _scores, const double* _omega_t,
+                                 octave_idx_type _k,
+                                 const SparseMatrix& _data,
+                                 octave_idx_type _j) {
+  // Arrays
+  const octave_idx_type* cidx = _data.cidx();
+  const octave_idx_type* ridx = _data.ridx();
+  const double*          nnz  = _data.data();
+
+  // Accumulate
+  std::fill(_scores, _scores + _k, 0.0);
+  for (octave_idx_type p = cidx[_j]; p < cidx[_j + 1]; ++p) {
+    const double* omega_d = _omega_t + ridx[p] * _k;
+    double        x_d     = nnz[p];
+    for (octave_idx_type r = 0; r < _k; ++r)
+      _scores[r] += x_d * omega_d[r];
+  }
+}
+
+// Scan the data columns
+/* Streams the columns of data, finding the k scores of each one into a
+   small buffer, and keeping only the winner, the runner-up (if
+   _margin) and the violation. The k x n product is only written if
+   _product is given.
+*/
+template <typename DMatrix>
+static void cpm3c_scan_columns(cpm3c_scan& _scan,
+                               const DMatrix& _data, const Matrix& _omega,
+                               bool _margin, Matrix* _product) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type k      = _omega.columns();
+
+  // Transposed omega
+  std::vector<double> omega_t(k * n_dims);
+  for (octave_idx_type r = 0; r < k; ++r)
+    for (octave_idx_type d = 0; d < n_dims; ++d)
+      omega_t[r + d * k] = _omega(d, r);
+
+  // Outputs
+  _scan.win.resize(n_data);
+  _scan.rup.resize(_margin ? n_data : 0);
+  _scan.violation = 0.0;
+
+  // Product
+  double* product = 0;
+  if (_product) {
+    _product->resize(k, n_data, 0.0);
+    product = _product->fortran_vec();
   }
 
+  // Empty?
+  if (n_data == 0 or k == 0)
+    return;
+
+  // Raw arrays
+  const double*    om  = &omega_t.front();
+  octave_idx_type* win = &_scan.win.front();
+  octave_idx_type* rup = _margin ? &_scan.rup.front() : 0;
+
+  // Partial violations, per block
+  /* Added in block order afterwards, so the result does not depend on
+     the scheduling */
+  octave_idx_type     n_blocks = (n_data + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  std::vector<double> partial(n_blocks, 0.0);
+
+#pragma omp parallel
+  {
+    // Thread-private scores
+    std::vector<double> scores(k);
+    double* s = &scores.front();
+
+    // For each block
+#pragma omp for schedule(dynamic)
+    for (octave_idx_type b = 0; b < n_blocks; ++b) {
+      // Limits
+      octave_idx_type first = b * BLOCK_SIZE;
+      octave_idx_type last  = std::min(first + BLOCK_SIZE, n_data);
+
+      // For each sample
+      double violation = 0.0;
+      for (octave_idx_type i = first; i < last; ++i) {
+        // Scores
+        column_scores(s, om, k, _data, i);
+
+        // Keep them?
+        if (product)
+          std::copy(s, s + k, product + i * k);
+
+        // Margin?
+        if (_margin) {
+          // Starting winner and runner's up
+          octave_idx_type w, u;
+          if (s[0] > s[1]) { w = 0; u = 1; }
+          else             { w = 1; u = 0; }
+
+          // For the others
+          for (octave_idx_type r = 2; r < k; ++r) {
+            if      (s[r] > s[w]) { u = w; w = r; }
+            else if (s[r] > s[u]) { u = r; }
+          }
+
+          // Is the margin not enough?
+          if (s[w] - s[u] < 1) {
+            violation += 1.0 - s[w] + s[u];
+            rup[i] = u;
+          }
+          else {
+            rup[i] = -1;
+          }
+
+          // Winner
+          win[i] = w;
+        }
+        else {
+          // Starting winner
+          octave_idx_type w = 0;
+
+          // For the others
+          for (octave_idx_type r = 1; r < k; ++r)
+            if (s[r] > s[w])
+              w = r;
+
+          // Winner
+          win[i] = w;
+        }
+      }
+
+      // Partial
+      partial[b] = violation;
+    }
+  }
+
+  // Add violations
+  for (octave_idx_type b = 0; b < n_blocks; ++b)
+    _scan.violation += partial[b];
+
+  // Normalize violation
+  _scan.violation /= n_data;
+}
+
+// Scan, according to the data type
+/* Returns false (after raising an error) if the arguments are wrong */
+static bool cpm3c_scan_args(cpm3c_scan& _scan, const octave_value_list& args,
+                            bool _margin, Matrix* _product) {
   // Check data
   if (not args(0).is_matrix_type()) {
     error("data should be a matrix");
-    return octave_value_list();
+    return false;
   }
 
   // Get omega
   if (not args(1).is_matrix_type()) {
     error("omega should be a matrix");
-    return octave_value_list();
+    return false;
   }
   Matrix omega = args(1).matrix_value();
 
-  // Product
-  Matrix product;
+  // Enough clusters?
+  if (_margin and omega.columns() < 2) {
+    error("omega should have at least two columns");
+    return false;
+  }
 
   // Get data
   if (args(0).is_sparse_type()) {
@@ -48,11 +224,11 @@ Find the CPM3C most violated constraint\n\
     // Check dimensions
     if (data.rows() != omega.rows()) {
       error("data and omega should have the same number of rows");
-      return octave_value_list();
+      return false;
     }
 
-    // Multiply
-    product = omega.transpose() * data;
+    // Scan
+    cpm3c_scan_columns(_scan, data, omega, _margin, _product);
   }
   else {
     // As a dense matrix
@@ -61,69 +237,85 @@ Find the CPM3C most violated constraint\n\
     // Check dimensions
     if (data.rows() != omega.rows()) {
       error("data and omega should have the same number of rows");
-      return octave_value_list();
+      return false;
     }
 
-    // Multiply
-    product = omega.transpose() * data;
+    // Scan
+    cpm3c_scan_columns(_scan, data, omega, _margin, _product);
   }
 
-  // Violation
-  double violation = 0.0;
+  // OK
+  return true;
+}
+
+// Create the z matrix
+static SparseMatrix cpm3c_z_matrix(const cpm3c_scan& _scan,
+                                   octave_idx_type _k) {
+  // Sparse matrix with a one per column
+  octave_idx_type n_samples = _scan.win.size();
+  SparseMatrix z = SparseMatrix(_k, n_samples, n_samples);
+  std::fill(z.data(), z.data() + n_samples, 1.0);
+  std::copy(_scan.win.begin(), _scan.win.end(), z.ridx());
+  std::copy(ttcl::ut::range(octave_idx_type(0)),
+            ttcl::ut::range(n_samples + 1), z.cidx());
+  return z;
+}
+
+
+/*******************************************/
+/* Find the CPM3C most violated constraint */
+/*******************************************/
+
+DEFUN_DLD(CPM3C_mvc, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{constraint}, @var{violation}, @var{z}, @var{product} ] =}\
+ CPM3C_mvc(@var{data}, @var{omega})\n\
+\n\
+Find the CPM3C most violated constraint\n\
+@end deftypefn") {
+  // Check the number of parameters
+  if (args.length() != 2 or nargout < 1 or nargout > 4) {
+    print_usage();
+    return octave_value_list();
+  }
+
+  // Product
+  /* Only materialized when asked for */
+  Matrix product;
+
+  // Scan
+  cpm3c_scan scan;
+  if (not cpm3c_scan_args(scan, args, true, nargout > 3 ? &product : 0))
+    return octave_value_list();
+
+  // Sizes
+  octave_idx_type k         = args(1).columns();
+  octave_idx_type n_samples = scan.win.size();
 
   // Constraint sparse matrix rows and cols
   std::vector<octave_idx_type> constraint_rows;
   std::vector<octave_idx_type> constraint_cols;
 
-  // z sparse matrix rows
-  std::vector<octave_idx_type> z_rows;
-
   // Reserve
-  int n_samples = product.columns();
   constraint_rows.reserve(n_samples);
-  constraint_cols.reserve(n_samples);
-  z_rows         .reserve(n_samples);
+  constraint_cols.reserve(n_samples + 1);
 
-  // Now, for each sample, find the winner and the runner's up
+  // Add a constraint for each sample with a runner's up
   constraint_cols.push_back(0);
-  for (int i = 0; i < n_samples; ++i) {
-    // Starting winner and runner's up
-    octave_idx_type win, rup;
-    if (product(0, i) > product(1, i)) { win = 0; rup = 1; }
-    else                               { win = 1; rup = 0; }
-
-    // For the others
-    for (int r = 2; r < product.rows(); ++r) {
-      if      (product(r, i) > product(win, i)) { rup = win; win = r; }
-      else if (product(r, i) > product(rup, i)) { rup = r; }
-    }
-
-    // Add the winer
-    z_rows.push_back(win);
-
-    // Is the margin not enough?
-    if (product(win, i) - product(rup, i) < 1) {
-      // Count violation
-      violation += 1.0 - product(win, i) + product(rup, i);
-
-      // Add a constraint
-      constraint_rows.push_back(rup);
-    }
-
-    // Index column
+  for (octave_idx_type i = 0; i < n_samples; ++i) {
+    if (scan.rup[i] != -1)
+      constraint_rows.push_back(scan.rup[i]);
     constraint_cols.push_back(constraint_rows.size());
   }
 
-  // Normalize violation
-  violation /= n_samples;
-
   // Prepare output
   octave_value_list output;
   output.resize(nargout);
 
   // Create a sparse matrix for constraint
   int n_sparse = constraint_rows.size();
-  SparseMatrix constraint = SparseMatrix(product.rows(), n_samples, n_sparse);
+  SparseMatrix constraint = SparseMatrix(k, n_samples, n_sparse);
   std::fill(constraint.data(), constraint.data() + n_sparse, 1.0);
   std::copy(constraint_rows.begin(), constraint_rows.end(), constraint.ridx());
   std::copy(constraint_cols.begin(), constraint_cols.end(), constraint.cidx());
@@ -134,18 +326,12 @@ Find the CPM3C most violated constraint\n\
   // More output?
   if (nargout > 1) {
     // Violation
-    output(1) = violation;
+    output(1) = scan.violation;
 
     // More output?
     if (nargout > 2) {
-      // Create a sparse matrix for z
-      SparseMatrix z = SparseMatrix(product.rows(), n_samples, n_samples);
-      std::fill(z.data(), z.data() + n_samples, 1.0);
-      std::copy(z_rows.begin(), z_rows.end(), z.ridx());
-      std::copy(ttcl::ut::range(0), ttcl::ut::range(n_samples + 1), z.cidx());
-
-      // Assign
-      output(2) = z;
+      // Assign z
+      output(2) = cpm3c_z_matrix(scan, k);
 
       // More output?
       if (nargout > 3) {
@@ -176,102 +362,531 @@ Find the CPM3C z matrix\n\
     return octave_value_list();
   }
 
-  // Check data
-  if (not args(0).is_matrix_type()) {
-    error("data should be a matrix");
+  // Scan
+  cpm3c_scan scan;
+  if (not cpm3c_scan_args(scan, args, false, 0))
     return octave_value_list();
-  }
 
-  // Get omega
-  if (not args(1).is_matrix_type()) {
-    error("omega should be a matrix");
+  // Prepare output
+  octave_value_list output;
+  output.resize(nargout);
+
+  // Assign
+  output(0) = cpm3c_z_matrix(scan, args(1).columns());
+
+  // Return the output
+  return output;
+}
+
+
+/*****************************/
+/* Find the CPM3C clustering */
+/*****************************/
+
+DEFUN_DLD(CPM3C_cluster, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{clustering} =}\
+ CPM3C_cluster(@var{data}, @var{omega})\n\
+\n\
+Find the CPM3C clustering\n\
+@end deftypefn") {
+  // Check the number of parameters
+  if (args.length() != 2 or nargout != 1) {
+    print_usage();
     return octave_value_list();
   }
-  Matrix omega = args(1).matrix_value();
 
-  // Product
-  Matrix product;
+  // Scan
+  cpm3c_scan scan;
+  if (not cpm3c_scan_args(scan, args, false, 0))
+    return octave_value_list();
 
-  // Get data
-  if (args(0).is_sparse_type()) {
-    // As a sparse matrix
-    SparseMatrix data = args(0).sparse_matrix_value();
+  // Output
+  octave_idx_type n_samples = scan.win.size();
+  RowVector clustering(n_samples);
 
-    // Check dimensions
-    if (data.rows() != omega.rows()) {
-      error("data and omega should have the same number of rows");
-      return octave_value_list();
+  // Set the winners
+  std::copy(scan.win.begin(), scan.win.end(), clustering.fortran_vec());
+
+  // Prepare output
+  octave_value_list output;
+  output.resize(nargout);
+  output(0) = clustering;
+
+  // Return the output
+  return output;
+}
+
+
+/*********************************/
+/* Find the CPM3C cutting planes */
+/*********************************/
+
+// Add a scaled dense column
+static inline void add_column(double* _target, double _scale,
+                              const Matrix& _data, octave_idx_type _j) {
+  octave_idx_type n_dims = _data.rows();
+  const double*   x      = _data.data() + _j * n_dims;
+  for (octave_idx_type d = 0; d < n_dims; ++d)
+    _target[d] += _scale * x[d];
+}
+
+// Add a scaled sparse column
+static inline void add_column(double* _target, double _scale,
+                              const SparseMatrix& _data, octave_idx_type _j) {
+  const octave_idx_type* cidx = _data.cidx();
+  const octave_idx_type* ridx = _data.ridx();
+  const double*          nnz  = _data.data();
+  for (octave_idx_type p = cidx[_j]; p < cidx[_j + 1]; ++p)
+    _target[ridx[p]] += _scale * nnz[p];
+}
+
+// Find the z-dependent part of every constraint in the working set
+/* For constraint w, column r of _zprod(:, w) (reshaped to n_dims x k)
+   is the sum of the samples active in w whose winner is r, over n;
+   _agree(w) counts the active samples whose runner-up is their winner
+*/
+template <typename DMatrix>
+static void cpm3c_cuts(Matrix& _zprod, RowVector& _agree,
+                       const DMatrix& _data,
+                       const std::vector<octave_idx_type>& _win,
+                       const Matrix& _rup, octave_idx_type _k) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type n_W    = _rup.columns();
+
+  // Resize
+  _zprod.resize(n_dims * _k, n_W, 0.0);
+  _agree.resize(n_W, 0.0);
+
+  // Raw arrays
+  double*                zprod = _zprod.fortran_vec();
+  double*                agree = _agree.fortran_vec();
+  const double*          rup   = _rup.data();
+  const octave_idx_type* win   = n_data ? &_win.front() : 0;
+  double                 scale = 1.0 / n_data;
+
+  // For each constraint
+  /* Each one is owned by a single thread */
+#pragma omp parallel for schedule(dynamic)
+  for (octave_idx_type w = 0; w < n_W; ++w) {
+    double*       zprod_w = zprod + w * n_dims * _k;
+    const double* rup_w   = rup   + w * n_data;
+
+    // For each active sample
+    double count = 0.0;
+    for (octave_idx_type i = 0; i < n_data; ++i) {
+      if (rup_w[i] > 0.0) {
+        add_column(zprod_w + win[i] * n_dims, scale, _data, i);
+        if (octave_idx_type(rup_w[i]) - 1 == win[i])
+          count += 1.0;
+      }
     }
 
-    // Multiply
-    product = omega.transpose() * data;
+    // Set it
+    agree[w] = count;
   }
-  else {
-    // As a dense matrix
-    Matrix data = args(0).matrix_value();
+}
 
-    // Check dimensions
-    if (data.rows() != omega.rows()) {
-      error("data and omega should have the same number of rows");
-      return octave_value_list();
-    }
 
-    // Multiply
-    product = omega.transpose() * data;
+/*****************************/
+/* CCCP quadratic programmes */
+/*****************************/
+
+// Ridge on the terms that are only linear in the objective
+/* quadprog_turlach needs a positive definite H, so xi (and the CPMMC b)
+   get a tiny quadratic term, which does not noticeably move the
+   solution */
+static const double QP_RIDGE = 1e-8;
+
+// CCCP options
+struct cccp_options {
+  // Slack cost
+  double C;
+
+  // Precision of the cutting plane loop
+  double epsilon;
+
+  // Balance constraint
+  double l;
+
+  // Relative step to quit the CCCP iterations
+  double per_quit;
+
+  // Show the progress?
+  bool verbose;
+};
+
+// Read a scalar option
+/* Returns false (after raising an error) if it is missing or not a
+   scalar */
+static bool read_option(double& _value, const Octave_map& _opts,
+                        const std::string& _name) {
+  // Find it
+  Octave_map::const_iterator it = _opts.seek(_name);
+  if (it == _opts.end() or not _opts.contents(it)(0).is_scalar_type()) {
+    error("opts.%s should be a scalar", _name.c_str());
+    return false;
   }
 
-  // z sparse matrix rows
-  std::vector<octave_idx_type> z_rows;
+  // Set it
+  _value = _opts.contents(it)(0).double_value();
+  return true;
+}
 
-  // Reserve
-  int n_samples = product.columns();
-  z_rows.reserve(n_samples);
+// Read the CCCP options
+/* Returns false (after raising an error) if any is wrong */
+static bool read_cccp_options(cccp_options& _opts, const Octave_map& _map) {
+  // Read them
+  double verbose;
+  if (not read_option(_opts.C,        _map, "C")        or
+      not read_option(_opts.epsilon,  _map, "epsilon")  or
+      not read_option(_opts.l,        _map, "l")        or
+      not read_option(_opts.per_quit, _map, "per_quit") or
+      not read_option(verbose,        _map, "verbose"))
+    return false;
+
+  // Verbose
+  _opts.verbose = verbose != 0.0;
+  return true;
+}
 
-  // Now, for each sample, find the winner and the runner's up
-  for (int i = 0; i < n_samples; ++i) {
-    // Starting winner
-    octave_idx_type win = 0;
+// Read the starting omega
+/* Returns false (after raising an error) if it is missing or its size
+   is wrong */
+static bool read_omega_0(Matrix& _omega, const Octave_map& _opts,
+                         octave_idx_type _n_dims, octave_idx_type _k) {
+  // Find it
+  Octave_map::const_iterator it = _opts.seek("omega_0");
+  if (it == _opts.end() or not _opts.contents(it)(0).is_matrix_type() or
+      _opts.contents(it)(0).rows()    != _n_dims or
+      _opts.contents(it)(0).columns() != _k) {
+    error("opts.omega_0 should be a %ld x %ld matrix",
+          long(_n_dims), long(_k));
+    return false;
+  }
 
-    // For the others
-    for (int r = 1; r < product.rows(); ++r)
-      if (product(r, i) > product(win, i))
-        win = r;
+  // Set it
+  _omega = _opts.contents(it)(0).matrix_value();
+  return true;
+}
 
-    // Add the winer
-    z_rows.push_back(win);
+// Cost function
+/* 1/2 sum omega^2 + C xi, as CPM3C_cost */
+static double cccp_cost(const Matrix& _omega, double _xi, double _C) {
+  const double* omega = _omega.data();
+  double        cost  = 0.0;
+  for (octave_idx_type i = 0; i < _omega.numel(); ++i)
+    cost += omega[i] * omega[i];
+  return 0.5 * cost + _C * _xi;
+}
+
+// Display the progress
+/* A mark per iteration, and a full line every 10 */
+static void cccp_progress(char _mark, int _iteration,
+                          octave_idx_type _n_constraints, double _obj,
+                          double _xi, double _violation) {
+  if (_iteration % 10 == 0)
+    std::fprintf(stderr, "%c %6d %4ld %8g %8g %8g\n", _mark, _iteration,
+                 long(_n_constraints), _obj, _xi, _violation);
+  else
+    std::fputc(_mark, stderr);
+}
+
+// Solve a CCCP quadratic programme
+/* Minimizes 1/2 x' H x + f' x subject to Aineq x <= bineq and
+   lb <= x <= ub, with quadprog_turlach. The first call factors H and
+   keeps the solver handle in _qp; later calls pass the handle instead,
+   so that H is not factored again and the solver starts from the
+   previous active set. For that, H must not change and the rows of
+   Aineq must keep their positions, new ones being appended. _x holds
+   the starting point on input and the solution on output. Returns false
+   (after raising an error) if the problem was not solved */
+static bool cccp_solve(ColumnVector& _x, octave_value& _qp,
+                       const Matrix& _H, const ColumnVector& _f,
+                       const Matrix& _Aineq, const ColumnVector& _bineq,
+                       const ColumnVector& _lb, const ColumnVector& _ub) {
+  // Arguments
+  octave_value_list qp_args;
+  qp_args.resize(9);
+  qp_args(0) = _qp.is_defined() ? _qp : octave_value(_H);
+  qp_args(1) = _f;
+  qp_args(2) = _Aineq;
+  qp_args(3) = _bineq;
+  qp_args(4) = Matrix();
+  qp_args(5) = Matrix();
+  qp_args(6) = _lb;
+  qp_args(7) = _ub;
+  qp_args(8) = _x;
+
+  // Solve
+  octave_value_list result = feval("quadprog_turlach", qp_args, 4);
+  if (error_state)
+    return false;
+
+  // Solved?
+  Octave_map  info   = result(2).map_value();
+  std::string status = info.contents("status")(0).string_value();
+  if (status != "optimal") {
+    error("the CCCP quadratic programme is %s", status.c_str());
+    return false;
   }
 
-  // Prepare output
-  octave_value_list output;
-  output.resize(nargout);
+  // Keep the solution and the handle
+  _x  = result(0).column_vector_value();
+  _qp = result(3);
+  return true;
+}
 
-  // Create a sparse matrix for z
-  SparseMatrix z = SparseMatrix(product.rows(), n_samples, n_samples);
-  std::fill(z.data(), z.data() + n_samples, 1.0);
-  std::copy(z_rows.begin(), z_rows.end(), z.ridx());
-  std::copy(ttcl::ut::range(0), ttcl::ut::range(n_samples + 1), z.cidx());
 
-  // Assign
-  output(0) = z;
+/*******************/
+/* CPM3C main loop */
+/*******************/
+
+// CPM3C working set
+/* Stored compactly, as the 1-based runner-up of each sample (0 if
+   inactive), with the cached data * constraint' / n products, reshaped
+   to n_dims * k, and the fraction of active samples */
+struct cpm3c_working_set {
+  Matrix    rup;
+  Matrix    prod;
+  RowVector mean_active;
+};
+
+// Add the most violated constraint of a scan to the working set
+template <typename DMatrix>
+static void cpm3c_add_constraint(cpm3c_working_set& _W, const DMatrix& _data,
+                                 const cpm3c_scan& _scan,
+                                 octave_idx_type _k) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type w      = _W.rup.columns();
+
+  // Room
+  _W.rup        .resize(n_data, w + 1, 0.0);
+  _W.prod       .resize(n_dims * _k, w + 1, 0.0);
+  _W.mean_active.resize(w + 1, 0.0);
+
+  // Raw arrays
+  double* rup   = _W.rup .fortran_vec() + w * n_data;
+  double* prod  = _W.prod.fortran_vec() + w * n_dims * _k;
+  double  scale = 1.0 / n_data;
+
+  // For each active sample
+  octave_idx_type n_active = 0;
+  for (octave_idx_type i = 0; i < n_data; ++i) {
+    if (_scan.rup[i] != -1) {
+      rup[i] = _scan.rup[i] + 1;
+      add_column(prod + _scan.rup[i] * n_dims, scale, _data, i);
+      ++n_active;
+    }
+  }
 
-  // Return the output
-  return output;
+  // Fraction of active samples
+  _W.mean_active(w) = n_active * scale;
 }
 
+// CPM3C inner CCCP procedure
+/* X arrangement: [ omega(:) ; xi ]. _win holds the winners at the
+   starting omega. Returns false (after raising an error) if a
+   quadratic programme was not solved */
+template <typename DMatrix>
+static bool cpm3c_cccp(Matrix& _omega, double& _xi, double& _obj, int& _its,
+                       octave_value& _qp, const DMatrix& _data,
+                       const cpm3c_working_set& _W, const cccp_options& _opts,
+                       const ColumnVector& _sum_data,
+                       std::vector<octave_idx_type> _win, int _iterations,
+                       double _violation) {
+  // Sizes
+  octave_idx_type n_dims        = _data.rows();
+  octave_idx_type n_data        = _data.columns();
+  octave_idx_type k             = _omega.columns();
+  octave_idx_type n_weights     = n_dims * k;
+  octave_idx_type n_vars        = n_weights + 1;
+  octave_idx_type n_sizes       = 2 * (k * (k - 1) / 2);
+  octave_idx_type n_constraints = _W.rup.columns();
+
+  // Objective function
+  /* 1/2 \sum_{p=1}^k \sum_{j=1}^m \omega_{pj}^2 + C \cdot \xi */
+  Matrix H(n_vars, n_vars, 0.0);
+  for (octave_idx_type j = 0; j < n_weights; ++j)
+    H(j, j) = 1.0;
+  H(n_weights, n_weights) = QP_RIDGE;
+  ColumnVector f(n_vars, 0.0);
+  f(n_weights) = _opts.C;
+
+  // Inequalities
+  Matrix       Aineq(n_sizes + n_constraints, n_vars, 0.0);
+  ColumnVector bineq(n_sizes + n_constraints, 0.0);
+
+  // -> Size inequalities
+  /* -l <= (\omega_p - \omega_q)' \sum_{i=1}^n x_i <= l, as two rows;
+     they do not change across iterations */
+  octave_idx_type cidx = 0;
+  for (octave_idx_type p = 0; p < k; ++p) {
+    for (octave_idx_type q = 0; q < p; ++q) {
+      for (octave_idx_type d = 0; d < n_dims; ++d) {
+        Aineq(cidx,     p * n_dims + d) =  _sum_data(d);
+        Aineq(cidx,     q * n_dims + d) = -_sum_data(d);
+        Aineq(cidx + 1, p * n_dims + d) = -_sum_data(d);
+        Aineq(cidx + 1, q * n_dims + d) =  _sum_data(d);
+      }
+      bineq(cidx) = bineq(cidx + 1) = _opts.l;
+      cidx += 2;
+    }
+  }
 
-/*****************************/
-/* Find the CPM3C clustering */
-/*****************************/
+  // Ranges
+  /* xi >= 0 */
+  ColumnVector lb(n_vars, -INFINITY);
+  ColumnVector ub(n_vars,  INFINITY);
+  lb(n_weights) = 0.0;
+
+  // Starting value
+  ColumnVector x(n_vars);
+  std::copy(_omega.data(), _omega.data() + n_weights, x.fortran_vec());
+  x(n_weights) = _xi;
+
+  // Starting objective function value
+  _obj = cccp_cost(_omega, _xi, _opts.C);
+
+  // Display
+  if (_opts.verbose)
+    cccp_progress('+', _iterations + 1, n_constraints, _obj, _xi,
+                  _violation);
+
+  // Loop
+  Matrix     zprod;
+  RowVector  agree;
+  cpm3c_scan scan;
+  bool       finish = false;
+  for (_its = 1; not finish; ++_its) {
+    // Remember old objective function value
+    double old_obj = _obj;
+
+    // Create the cuts
+    /* (W.prod - zprod)' omega - xi <= agree / n - mean_active, where
+       only the z part is found */
+    cpm3c_cuts(zprod, agree, _data, _win, _W.rup, k);
+    for (octave_idx_type w = 0; w < n_constraints; ++w) {
+      const double* prod_w  = _W.prod.data() + w * n_weights;
+      const double* zprod_w = zprod  .data() + w * n_weights;
+      for (octave_idx_type j = 0; j < n_weights; ++j)
+        Aineq(cidx + w, j) = prod_w[j] - zprod_w[j];
+      Aineq(cidx + w, n_weights) = -1.0;
+      bineq(cidx + w) = agree(w) / n_data - _W.mean_active(w);
+    }
 
-DEFUN_DLD(CPM3C_cluster, args, nargout,
+    // Solve
+    if (not cccp_solve(x, _qp, H, f, Aineq, bineq, lb, ub))
+      return false;
+
+    // Unpack
+    std::copy(x.data(), x.data() + n_weights, _omega.fortran_vec());
+    _xi  = x(n_weights);
+    _obj = cccp_cost(_omega, _xi, _opts.C);
+
+    // Display
+    if (_opts.verbose)
+      cccp_progress('.', _iterations + _its + 1, n_constraints, _obj, _xi,
+                    _violation);
+
+    // Finish?
+    if (old_obj - _obj >= 0 and old_obj - _obj < _opts.per_quit * old_obj) {
+      finish = true;
+    }
+    else {
+      // Update z
+      cpm3c_scan_columns(scan, _data, _omega, false, 0);
+      _win.swap(scan.win);
+    }
+  }
+
+  // Solved
+  return true;
+}
+
+// CPM3C main loop
+/* Returns false (after raising an error) if a quadratic programme was
+   not solved */
+template <typename DMatrix>
+static bool cpm3c_loop(Matrix& _omega, double& _xi, double& _obj,
+                       int& _iterations, double& _violation,
+                       cpm3c_working_set& _W, SparseMatrix& _expec,
+                       const DMatrix& _data, const cccp_options& _opts) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type k      = _omega.columns();
+
+  // Sum of the data
+  ColumnVector sum_data(n_dims, 0.0);
+  for (octave_idx_type i = 0; i < n_data; ++i)
+    add_column(sum_data.fortran_vec(), 1.0, _data, i);
+
+  // Solver handle
+  /* H is the same for every quadratic programme, so it is shared by
+     all the CCCP runs */
+  octave_value qp;
+
+  // Find the most violated constraint in the original problem
+  cpm3c_scan scan;
+  cpm3c_scan_columns(scan, _data, _omega, true, 0);
+  _violation = scan.violation;
+
+  // Add first constraint
+  cpm3c_add_constraint(_W, _data, scan, k);
+
+  // Loop
+  _iterations = 0;
+  for (;;) {
+    // Solve the non-convex optimization problem via CCCP
+    int its;
+    if (not cpm3c_cccp(_omega, _xi, _obj, its, qp, _data, _W, _opts,
+                       sum_data, scan.win, _iterations, _violation))
+      return false;
+
+    // Add the iterations
+    _iterations += its;
+
+    // Find the most violated constraint in the original problem
+    cpm3c_scan_columns(scan, _data, _omega, true, 0);
+    _violation = scan.violation;
+
+    // Finish?
+    if (_violation <= _xi * (1 + _opts.epsilon))
+      break;
+    cpm3c_add_constraint(_W, _data, scan, k);
+  }
+
+  // Display final output
+  if (_opts.verbose)
+    std::fprintf(stderr, " %6d %4ld %8g %8g %8g\n", _iterations,
+                 long(_W.rup.columns()), _obj, _xi, _violation);
+
+  // Classify
+  /* As CPM3C_cluster */
+  cpm3c_scan_columns(scan, _data, _omega, false, 0);
+  _expec = cpm3c_z_matrix(scan, k);
+
+  // Solved
+  return true;
+}
+
+DEFUN_DLD(CPM3C_loop, args, nargout,
           "-*- texinfo -*-\n\
-@deftypefn {Loadable Function} {@var{clustering} =}\
- CPM3C_cluster(@var{data}, @var{omega})\n\
+@deftypefn {Loadable Function} {[ @var{expec}, @var{model}, @var{info} ] =}\
+ CPM3C_loop(@var{data}, @var{k}, @var{opts})\n\
 \n\
-Find the CPM3C clustering\n\
+Run the CPM3C cutting plane loop, from the options filled in by\n\
+@code{CPM3C_clustering}. Each CCCP quadratic programme is solved with\n\
+@code{quadprog_turlach}, re-using its handle so that every solve after\n\
+the first one starts from the previous active set\n\
 @end deftypefn") {
   // Check the number of parameters
-  if (args.length() != 2 or nargout != 1) {
+  if (args.length() != 3 or nargout > 3) {
     print_usage();
     return octave_value_list();
   }
@@ -281,67 +896,497 @@ Find the CPM3C clustering\n\
     error("data should be a matrix");
     return octave_value_list();
   }
+  octave_idx_type n_dims = args(0).rows();
 
-  // Get omega
-  if (not args(1).is_matrix_type()) {
-    error("omega should be a matrix");
+  // Check k
+  if (not args(1).is_real_scalar() or args(1).int_value() < 2) {
+    error("k should be an integer of at least two");
     return octave_value_list();
   }
-  Matrix omega = args(1).matrix_value();
+  octave_idx_type k = args(1).int_value();
 
-  // Product
-  Matrix product;
+  // Check opts
+  if (not args(2).is_map()) {
+    error("opts should be a struct");
+    return octave_value_list();
+  }
+  Octave_map opts = args(2).map_value();
+
+  // Read the options
+  cccp_options cccp;
+  Matrix       omega;
+  double       xi;
+  if (not read_cccp_options(cccp, opts) or
+      not read_omega_0(omega, opts, n_dims, k) or
+      not read_option(xi, opts, "xi_0"))
+    return octave_value_list();
 
-  // Get data
-  if (args(0).is_sparse_type()) {
-    // As a sparse matrix
-    SparseMatrix data = args(0).sparse_matrix_value();
+  // Results
+  double            obj, violation;
+  int               iterations;
+  cpm3c_working_set W;
+  SparseMatrix      expec;
+
+  // Run
+  bool solved;
+  if (args(0).is_sparse_type())
+    solved = cpm3c_loop(omega, xi, obj, iterations, violation, W, expec,
+                        args(0).sparse_matrix_value(), cccp);
+  else
+    solved = cpm3c_loop(omega, xi, obj, iterations, violation, W, expec,
+                        args(0).matrix_value(), cccp);
+  if (not solved)
+    return octave_value_list();
 
-    // Check dimensions
-    if (data.rows() != omega.rows()) {
-      error("data and omega should have the same number of rows");
-      return octave_value_list();
+  // Model
+  Octave_map model;
+  model.assign("omega", omega);
+
+  // Working set
+  Octave_map working_set;
+  working_set.assign("rup",         W.rup);
+  working_set.assign("prod",        W.prod);
+  working_set.assign("mean_active", W.mean_active);
+
+  // Information
+  Octave_map info = opts;
+  info.assign("xi",          xi);
+  info.assign("W",           working_set);
+  info.assign("obj",         obj);
+  info.assign("iterations",  iterations);
+  info.assign("constraints", double(W.rup.columns()));
+  info.assign("violation",   violation);
+
+  // Prepare output
+  octave_value_list output;
+  output.resize(3);
+  output(0) = expec;
+  output(1) = model;
+  output(2) = info;
+
+  // Return the output
+  return output;
+}
+
+
+/*******************/
+/* CPMMC main loop */
+/*******************/
+
+// Scores of every sample
+/* omega' x_i + b */
+template <typename DMatrix>
+static void cpmmc_scores(std::vector<double>& _scores, const DMatrix& _data,
+                         const ColumnVector& _omega, double _b) {
+  // Room
+  octave_idx_type n_data = _data.columns();
+  _scores.resize(n_data);
+
+  // For each sample
+#pragma omp parallel for schedule(static)
+  for (octave_idx_type i = 0; i < n_data; ++i) {
+    double score;
+    column_scores(&score, _omega.data(), 1, _data, i);
+    _scores[i] = score + _b;
+  }
+}
+
+// Find the CPMMC most violated constraint
+/* Adds it as a new column of the 0/1 _W (n x W) and its fraction of
+   active samples to _avg_W when _add, and returns its violation, as
+   CPMMC_mvc */
+static double cpmmc_mvc(Matrix& _W, RowVector& _avg_W,
+                        const std::vector<double>& _scores, bool _add) {
+  // Sizes
+  octave_idx_type n_data = _scores.size();
+  octave_idx_type w      = _W.columns();
+
+  // Room
+  double* constraint = 0;
+  if (_add) {
+    _W    .resize(n_data, w + 1, 0.0);
+    _avg_W.resize(w + 1, 0.0);
+    constraint = _W.fortran_vec() + w * n_data;
+  }
+
+  // For each sample
+  octave_idx_type n_active  = 0;
+  double          violation = 0.0;
+  for (octave_idx_type i = 0; i < n_data; ++i) {
+    double margin = std::fabs(_scores[i]);
+    if (margin < 1) {
+      violation += 1 - margin;
+      if (constraint)
+        constraint[i] = 1.0;
+      ++n_active;
+    }
+  }
+
+  // Fraction of active samples
+  if (_add)
+    _avg_W(w) = double(n_active) / n_data;
+
+  // Normalized violation
+  return violation / n_data;
+}
+
+// Find the sign-weighted sums of the working set constraints
+/* Column w of _sx is \frac{1}{n} \sum_i c_{wi} s_i x_i, and _s(w) is
+   \frac{1}{n} \sum_i c_{wi} s_i, with s_i the sign of the score of
+   sample i */
+template <typename DMatrix>
+static void cpmmc_cuts(Matrix& _sx, RowVector& _s, const DMatrix& _data,
+                       const std::vector<double>& _scores, const Matrix& _W) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+  octave_idx_type n_W    = _W.columns();
+
+  // Resize
+  _sx.resize(n_dims, n_W, 0.0);
+  _s .resize(n_W, 0.0);
+
+  // Raw arrays
+  double*       sx    = _sx.fortran_vec();
+  double*       s     = _s .fortran_vec();
+  const double* W     = _W.data();
+  double        scale = 1.0 / n_data;
+
+  // For each constraint
+  /* Each one is owned by a single thread */
+#pragma omp parallel for schedule(dynamic)
+  for (octave_idx_type w = 0; w < n_W; ++w) {
+    double*       sx_w = sx + w * n_dims;
+    const double* W_w  = W  + w * n_data;
+
+    // Clear
+    std::fill(sx_w, sx_w + n_dims, 0.0);
+
+    // For each active sample
+    double sum = 0.0;
+    for (octave_idx_type i = 0; i < n_data; ++i) {
+      if (W_w[i] != 0.0 and _scores[i] != 0.0) {
+        double sign = _scores[i] > 0.0 ? scale : -scale;
+        add_column(sx_w, sign, _data, i);
+        sum += sign;
+      }
     }
 
-    // Multiply
-    product = omega.transpose() * data;
+    // Set it
+    s[w] = sum;
   }
-  else {
-    // As a dense matrix
-    Matrix data = args(0).matrix_value();
+}
 
-    // Check dimensions
-    if (data.rows() != omega.rows()) {
-      error("data and omega should have the same number of rows");
-      return octave_value_list();
+// CPMMC inner CCCP procedure
+/* X arrangement: [ omega ; b ; xi ]. _scores holds the scores at the
+   starting omega and b. Returns false (after raising an error) if a
+   quadratic programme was not solved */
+template <typename DMatrix>
+static bool cpmmc_cccp(ColumnVector& _omega, double& _b, double& _xi,
+                       double& _obj, int& _its, octave_value& _qp,
+                       const DMatrix& _data, const Matrix& _W,
+                       const RowVector& _avg_W, const cccp_options& _opts,
+                       const ColumnVector& _sum_data,
+                       std::vector<double> _scores, int _iterations,
+                       double _violation) {
+  // Sizes
+  octave_idx_type n_dims        = _data.rows();
+  octave_idx_type n_data        = _data.columns();
+  octave_idx_type n_vars        = n_dims + 2;
+  octave_idx_type n_constraints = _W.columns();
+
+  // Objective function
+  /* 1/2 \sum_{j=1}^m \omega_j^2 + C \cdot \xi */
+  Matrix H(n_vars, n_vars, 0.0);
+  for (octave_idx_type j = 0; j < n_dims; ++j)
+    H(j, j) = 1.0;
+  H(n_dims,     n_dims)     = QP_RIDGE;
+  H(n_dims + 1, n_dims + 1) = QP_RIDGE;
+  ColumnVector f(n_vars, 0.0);
+  f(n_dims + 1) = _opts.C;
+
+  // Inequalities
+  Matrix       Aineq(2 + n_constraints, n_vars, 0.0);
+  ColumnVector bineq(2 + n_constraints, 0.0);
+
+  // -> Balance inequalities
+  /* -l <= \sum_{j=1}^m ( \sum_{i=1}^n x_{ij} ) \cdot w_j + n \cdot b <= l,
+     as two rows; they do not change across iterations */
+  for (octave_idx_type d = 0; d < n_dims; ++d) {
+    Aineq(0, d) =  _sum_data(d);
+    Aineq(1, d) = -_sum_data(d);
+  }
+  Aineq(0, n_dims) =  n_data;
+  Aineq(1, n_dims) = -n_data;
+  bineq(0) = bineq(1) = _opts.l;
+
+  // Ranges
+  /* xi >= 0 */
+  ColumnVector lb(n_vars, -INFINITY);
+  ColumnVector ub(n_vars,  INFINITY);
+  lb(n_dims + 1) = 0.0;
+
+  // Starting value
+  ColumnVector x(n_vars);
+  std::copy(_omega.data(), _omega.data() + n_dims, x.fortran_vec());
+  x(n_dims)     = _b;
+  x(n_dims + 1) = _xi;
+
+  // Starting objective function value
+  _obj = cccp_cost(_omega, _xi, _opts.C);
+
+  // Display
+  if (_opts.verbose)
+    cccp_progress('+', _iterations + 1, n_constraints, _obj, _xi,
+                  _violation);
+
+  // Loop
+  Matrix    sx;
+  RowVector s;
+  bool      finish = false;
+  for (_its = 1; not finish; ++_its) {
+    // Remember old objective function value
+    double old_obj = _obj;
+
+    // Create the cuts
+    /* \frac{1}{n} \sum_i c_{wi} \leq
+       \omega' ( \frac{1}{n} \sum_i c_{wi} s_i x_i ) +
+       b ( \frac{1}{n} \sum_i c_{wi} s_i ) + \xi, negated */
+    cpmmc_cuts(sx, s, _data, _scores, _W);
+    for (octave_idx_type w = 0; w < n_constraints; ++w) {
+      const double* sx_w = sx.data() + w * n_dims;
+      for (octave_idx_type d = 0; d < n_dims; ++d)
+        Aineq(2 + w, d) = -sx_w[d];
+      Aineq(2 + w, n_dims)     = -s(w);
+      Aineq(2 + w, n_dims + 1) = -1.0;
+      bineq(2 + w) = -_avg_W(w);
     }
 
-    // Multiply
-    product = omega.transpose() * data;
+    // Solve
+    if (not cccp_solve(x, _qp, H, f, Aineq, bineq, lb, ub))
+      return false;
+
+    // Unpack
+    std::copy(x.data(), x.data() + n_dims, _omega.fortran_vec());
+    _b   = x(n_dims);
+    _xi  = x(n_dims + 1);
+    _obj = cccp_cost(_omega, _xi, _opts.C);
+
+    // Display
+    if (_opts.verbose)
+      cccp_progress('.', _iterations + _its + 1, n_constraints, _obj, _xi,
+                    _violation);
+
+    // Finish?
+    if (old_obj - _obj >= 0 and old_obj - _obj < _opts.per_quit * old_obj)
+      finish = true;
+    else
+      cpmmc_scores(_scores, _data, _omega, _b);
   }
 
-  // Output
-  int n_samples = product.columns();
-  RowVector clustering(n_samples);
+  // Solved
+  return true;
+}
 
-  // Now, for each sample, find the winner and the runner's up
-  for (int i = 0; i < n_samples; ++i) {
-    // Starting winner
-    octave_idx_type win = 0;
+// CPMMC inner CCCP procedure, on the dual
+/* Calls CPMMC_CCCP_dual, whose H changes across iterations. Returns
+   false if it failed */
+static bool cpmmc_cccp_dual(ColumnVector& _omega, double& _b, double& _xi,
+                            double& _obj, int& _its,
+                            const octave_value& _data, const Matrix& _W,
+                            const RowVector& _avg_W,
+                            const cccp_options& _opts,
+                            const ColumnVector& _sum_data, int _iterations,
+                            double _violation) {
+  // Arguments
+  octave_value_list dual_args;
+  dual_args.resize(13);
+  dual_args(0)  = _data;
+  dual_args(1)  = _omega;
+  dual_args(2)  = _b;
+  dual_args(3)  = _xi;
+  dual_args(4)  = _W;
+  dual_args(5)  = _opts.C;
+  dual_args(6)  = _opts.l;
+  dual_args(7)  = _opts.per_quit;
+  dual_args(8)  = _sum_data;
+  dual_args(9)  = _avg_W;
+  dual_args(10) = _iterations;
+  dual_args(11) = _violation;
+  dual_args(12) = _opts.verbose;
+
+  // Solve
+  octave_value_list result = feval("CPMMC_CCCP_dual", dual_args, 5);
+  if (error_state)
+    return false;
+
+  // Unpack
+  _omega = result(0).column_vector_value();
+  _b     = result(1).double_value();
+  _xi    = result(2).double_value();
+  _obj   = result(3).double_value();
+  _its   = result(4).int_value();
+  return true;
+}
+
+// CPMMC main loop
+/* Returns false (after raising an error) if a CCCP run failed */
+template <typename DMatrix>
+static bool cpmmc_loop(ColumnVector& _omega, double& _b, double& _xi,
+                       double& _obj, int& _iterations, double& _violation,
+                       Matrix& _W, SparseMatrix& _expec,
+                       const octave_value& _data_value, const DMatrix& _data,
+                       const cccp_options& _opts, bool _use_dual) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+
+  // Sum of the data
+  ColumnVector sum_data(n_dims, 0.0);
+  for (octave_idx_type i = 0; i < n_data; ++i)
+    add_column(sum_data.fortran_vec(), 1.0, _data, i);
+
+  // Solver handle
+  /* Shared by all the primal CCCP runs */
+  octave_value qp;
+
+  // Find the most violated constraint in the original problem, and add
+  // it as the first one
+  RowVector           avg_W;
+  std::vector<double> scores;
+  cpmmc_scores(scores, _data, _omega, _b);
+  _violation = cpmmc_mvc(_W, avg_W, scores, true);
+
+  // Loop
+  _iterations = 0;
+  for (;;) {
+    // Solve the non-convex optimization problem via CCCP
+    int  its;
+    bool solved = _use_dual ?
+      cpmmc_cccp_dual(_omega, _b, _xi, _obj, its, _data_value, _W, avg_W,
+                      _opts, sum_data, _iterations, _violation) :
+      cpmmc_cccp(_omega, _b, _xi, _obj, its, qp, _data, _W, avg_W, _opts,
+                 sum_data, scores, _iterations, _violation);
+    if (not solved)
+      return false;
+
+    // Add the iterations
+    _iterations += its;
+
+    // Find the most violated constraint in the original problem
+    cpmmc_scores(scores, _data, _omega, _b);
+    _violation = cpmmc_mvc(_W, avg_W, scores, false);
+
+    // Finish?
+    if (_violation <= _xi * (1 + _opts.epsilon))
+      break;
+    cpmmc_mvc(_W, avg_W, scores, true);
+  }
 
-    // For the others
-    for (int r = 1; r < product.rows(); ++r)
-      if (product(r, i) > product(win, i))
-        win = r;
+  // Display final output
+  if (_opts.verbose)
+    std::fprintf(stderr, " %6d %4ld %8g %8g %8g\n", _iterations,
+                 long(_W.columns()), _obj, _xi, _violation);
+
+  // Expectation
+  /* The first cluster for negative scores, the second for positive */
+  cpm3c_scan scan;
+  scan.win.resize(n_data);
+  for (octave_idx_type i = 0; i < n_data; ++i)
+    scan.win[i] = scores[i] > 0.0 ? 1 : 0;
+  _expec = cpm3c_z_matrix(scan, 2);
+
+  // Solved
+  return true;
+}
 
-    // Set the winer
-    clustering(i) = win;
+DEFUN_DLD(CPMMC_loop, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {[ @var{expec}, @var{model}, @var{info} ] =}\
+ CPMMC_loop(@var{data}, @var{opts})\n\
+\n\
+Run the CPMMC cutting plane loop, from the options filled in by\n\
+@code{CPM3C_clustering}. Unless @var{opts}.use_dual is set, each CCCP\n\
+quadratic programme is solved with @code{quadprog_turlach}, re-using its\n\
+handle so that every solve after the first one starts from the previous\n\
+active set; otherwise, @code{CPMMC_CCCP_dual} is called\n\
+@end deftypefn") {
+  // Check the number of parameters
+  if (args.length() != 2 or nargout > 3) {
+    print_usage();
+    return octave_value_list();
+  }
+
+  // Check data
+  if (not args(0).is_matrix_type()) {
+    error("data should be a matrix");
+    return octave_value_list();
   }
+  octave_idx_type n_dims = args(0).rows();
+
+  // Check opts
+  if (not args(1).is_map()) {
+    error("opts should be a struct");
+    return octave_value_list();
+  }
+  Octave_map opts = args(1).map_value();
+
+  // Read the options
+  cccp_options cccp;
+  Matrix       omega_0;
+  double       b, xi, use_dual;
+  if (not read_cccp_options(cccp, opts) or
+      not read_omega_0(omega_0, opts, n_dims, 1) or
+      not read_option(b,        opts, "b_0")  or
+      not read_option(xi,       opts, "xi_0") or
+      not read_option(use_dual, opts, "use_dual"))
+    return octave_value_list();
+  ColumnVector omega = omega_0.column(0);
+
+  // Results
+  double       obj, violation;
+  int          iterations;
+  Matrix       W;
+  SparseMatrix expec;
+
+  // Run
+  bool solved;
+  if (args(0).is_sparse_type())
+    solved = cpmmc_loop(omega, b, xi, obj, iterations, violation, W, expec,
+                        args(0), args(0).sparse_matrix_value(), cccp,
+                        use_dual != 0.0);
+  else
+    solved = cpmmc_loop(omega, b, xi, obj, iterations, violation, W, expec,
+                        args(0), args(0).matrix_value(), cccp,
+                        use_dual != 0.0);
+  if (not solved)
+    return octave_value_list();
+
+  // Model
+  Octave_map model;
+  model.assign("omega", omega);
+  model.assign("b",     b);
+
+  // Working set, as a logical matrix
+  boolMatrix working_set(W.rows(), W.columns(), false);
+  for (octave_idx_type i = 0; i < W.numel(); ++i)
+    working_set(i) = W(i) != 0.0;
+
+  // Information
+  Octave_map info = opts;
+  info.assign("xi",          xi);
+  info.assign("W",           working_set);
+  info.assign("obj",         obj);
+  info.assign("iterations",  iterations);
+  info.assign("constraints", double(W.columns()));
+  info.assign("violation",   violation);
 
   // Prepare output
   octave_value_list output;
-  output.resize(nargout);
-  output(0) = clustering;
+  output.resize(3);
+  output(0) = expec;
+  output(1) = model;
+  output(2) = info;
 
   // Return the output
   return output;
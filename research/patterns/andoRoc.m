@@ -230,9 +230,6 @@ endif
 function [ cl_prc, cl_rec, cl_nrec, cl_f1, cl_auc ] = ...
       evaluate(s_truth, pos_tr, neg_tr, expec, scores)
 
-  %% Info
-  n_data = length(s_truth);
-
   %% Find Prec/Rec
 
   %% Negative/positive cluster
@@ -260,16 +257,10 @@ function [ cl_prc, cl_rec, cl_nrec, cl_f1, cl_auc ] = ...
 
   %% Find ROC curve
 
-  %% Sort'em
-  [ sort_scores, sort_idx ] = sort(scores, "descend");
-
-  %% Find accumulated positive and negative
-  roc_pos = cumsum( s_truth(sort_idx)); roc_pos ./= length(pos_tr);
-  roc_neg = cumsum(~s_truth(sort_idx)); roc_neg ./= length(neg_tr);
-
-  %% AUC
-  cl_auc = sum(diff(roc_neg) .* ...
-               (roc_pos(1 : n_data - 1) + roc_pos(2 : n_data))) / 2;
+  %% Area under it (without keeping the curve)
+  [ cl_best, cl_auc ] = ...
+      binary_curves(scores(:)', double([ ~s_truth(:)' ; s_truth(:)' ]), ...
+                    [ length(neg_tr), length(pos_tr) ], true());
 endfunction
 
 %% Run one
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#include <octave/oct.h>
+
+#include <stdint.h>
+
+// Number of curves
+/* <total> <neg_rec> <rec> <prc> <f1> <score> */
+static const octave_idx_type N_CURVES = 6;
+
+// Radix digit bits
+static const int DIGIT_BITS = 8;
+
+// Radix buckets
+static const int N_BUCKETS = 1 << DIGIT_BITS;
+
+// Radix passes
+static const int N_PASSES = 64 / DIGIT_BITS;
+
+
+/***********/
+/* Sorting */
+/***********/
+
+// Descending sort key of a score
+/* Unsigned keys whose ascending order is the descending order of the
+   scores, with NaN first (as in sort(..., 'descend')) and -0 == +0 */
+static inline uint64_t descending_key(double _score) {
+  // Canonical NaN and zero
+  if (_score != _score)
+    _score = NAN;
+  else if (_score == 0.0)
+    _score = 0.0;
+
+  // Bits
+  uint64_t bits;
+  std::memcpy(&bits, &_score, sizeof(bits));
+
+  // Ascending order, reversed
+  uint64_t ascending = (bits & 0x8000000000000000ULL) ?
+    ~bits : (bits | 0x8000000000000000ULL);
+  return ~ascending;
+}
+
+// Sort buffers of one thread
+struct radix_buffers {
+  // Keys and indices, and their scratch copies
+  std::vector<uint64_t>        keys,    keys_tmp;
+  std::vector<octave_idx_type> indices, indices_tmp;
+
+  // Bucket counts of every pass
+  std::vector<octave_idx_type> counts;
+};
+
+// Sort a row of scores in descending order
+/* A stable LSD radix sort, so ties keep their original order; passes
+   where every key has the same digit are skipped. The permutation is
+   left in _buf.indices */
+static void radix_sort_row(radix_buffers& _buf, const double* _scores,
+                           octave_idx_type _n_data, octave_idx_type _stride) {
+  // Room
+  _buf.keys       .resize(_n_data);
+  _buf.keys_tmp   .resize(_n_data);
+  _buf.indices    .resize(_n_data);
+  _buf.indices_tmp.resize(_n_data);
+  _buf.counts     .assign(N_PASSES * N_BUCKETS, 0);
+
+  // Keys, and the counts of every pass at once
+  for (octave_idx_type i = 0; i < _n_data; ++i) {
+    uint64_t key = _buf.keys[i] = descending_key(_scores[i * _stride]);
+    _buf.indices[i] = i;
+    for (int p = 0; p < N_PASSES; ++p)
+      ++_buf.counts[p * N_BUCKETS +
+                    ((key >> (p * DIGIT_BITS)) & (N_BUCKETS - 1))];
+  }
+
+  // Each pass
+  for (int p = 0; p < N_PASSES; ++p) {
+    octave_idx_type* counts = &_buf.counts[p * N_BUCKETS];
+    int              shift  = p * DIGIT_BITS;
+
+    // Trivial?
+    if (_n_data == 0 or
+        counts[(_buf.keys[0] >> shift) & (N_BUCKETS - 1)] == _n_data)
+      continue;
+
+    // Offsets
+    octave_idx_type offset = 0;
+    for (int b = 0; b < N_BUCKETS; ++b) {
+      octave_idx_type count = counts[b];
+      counts[b] = offset;
+      offset   += count;
+    }
+
+    // Scatter
+    for (octave_idx_type i = 0; i < _n_data; ++i) {
+      octave_idx_type pos = counts[(_buf.keys[i] >> shift) & (N_BUCKETS - 1)]++;
+      _buf.keys_tmp   [pos] = _buf.keys   [i];
+      _buf.indices_tmp[pos] = _buf.indices[i];
+    }
+    _buf.keys   .swap(_buf.keys_tmp);
+    _buf.indices.swap(_buf.indices_tmp);
+  }
+}
+
+
+/**********/
+/* Curves */
+/**********/
+
+// Curves of one row
+/* A single pass over the sorted scores accumulates the negative and
+   positive truth, and finds the curves (if _curves is not null), the
+   area under the ROC curve, and the point of highest F1 */
+static double row_curves(double* _curves, double* _best,
+                         const radix_buffers& _buf, const double* _scores,
+                         octave_idx_type _stride, const double* _truth,
+                         double _inv_neg, double _inv_pos,
+                         octave_idx_type _n_data) {
+  // Accumulated truth
+  double acc_neg = 0.0, acc_pos = 0.0;
+
+  // Previous ROC point
+  double prev_neg_rec = 0.0, prev_rec = 0.0;
+
+  // Area
+  double auc = 0.0;
+
+  // Best F1
+  double best_f1 = -1.0;
+
+  // Each point
+  for (octave_idx_type p = 0; p < _n_data; ++p) {
+    octave_idx_type i = _buf.indices[p];
+
+    // Accumulate
+    acc_neg += _truth[2 * i];
+    acc_pos += _truth[2 * i + 1];
+
+    // Point
+    double total   = acc_neg + acc_pos;
+    double neg_rec = _inv_neg * acc_neg;
+    double rec     = _inv_pos * acc_pos;
+    double prc     = acc_pos / total;
+    double f1      = 2 * (prc * rec) / (prc + rec);
+    if (std::isnan(f1))
+      f1 = 0.0;
+    double score   = _scores[i * _stride];
+
+    // Area
+    auc += (neg_rec - prev_neg_rec) * (rec + prev_rec) / 2;
+    prev_neg_rec = neg_rec;
+    prev_rec     = rec;
+
+    // Curves
+    if (_curves) {
+      double* point = _curves + p * N_CURVES;
+      point[0] = total;
+      point[1] = neg_rec;
+      point[2] = rec;
+      point[3] = prc;
+      point[4] = f1;
+      point[5] = score;
+    }
+
+    // Best?
+    if (f1 > best_f1) {
+      best_f1  = f1;
+      _best[0] = total;
+      _best[1] = neg_rec;
+      _best[2] = rec;
+      _best[3] = prc;
+      _best[4] = f1;
+      _best[5] = score;
+    }
+  }
+
+  // Return the area
+  return auc;
+}
+
+// Curves of every row
+/* Rows are processed in parallel, each thread with its own buffers */
+static void binary_curves(double* _curves, double* _summary, double* _auc,
+                          const Matrix& _scores, const Matrix& _truth,
+                          double _inv_neg, double _inv_pos) {
+  // Sizes
+  octave_idx_type n_rows = _scores.rows();
+  octave_idx_type n_data = _scores.columns();
+
+  // Data
+  const double* scores = _scores.data();
+  const double* truth  = _truth .data();
+
+#pragma omp parallel
+  {
+    // Thread buffers
+    radix_buffers buf;
+    double        best[N_CURVES];
+
+#pragma omp for schedule(dynamic)
+    for (octave_idx_type r = 0; r < n_rows; ++r) {
+      // Sort
+      radix_sort_row(buf, scores + r, n_data, n_rows);
+
+      // Curves
+      std::fill(best, best + N_CURVES, NAN);
+      _auc[r] = row_curves(_curves ? _curves + r * n_data * N_CURVES : 0,
+                           best, buf, scores + r, n_rows, truth,
+                           _inv_neg, _inv_pos, n_data);
+
+      // Summary
+      if (_summary)
+        for (octave_idx_type c = 0; c < N_CURVES; ++c)
+          _summary[r + c * n_rows] = best[c];
+    }
+  }
+}
+
+
+/*******************/
+/* Octave-C++ Glue */
+/*******************/
+
+// Octave callback
+DEFUN_DLD(binary_curves, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{curves}, @var{auc} ] =}\
+ binary_curves(@var{scores}, @var{truth}, @var{sizes} [, @var{summary}])\n\
+\n\
+Find the binary evaluation curves of every row of @var{scores} (m x n),\n\
+given the 2 x n negative/positive @var{truth} and its class @var{sizes}.\n\
+\n\
+For each row, @var{curves} holds a 6 x n matrix with the\n\
+<total> <neg_rec> <rec> <prc> <f1> <score> of the points sorted by\n\
+descending score, as @code{binary_evaluation_curves} (6 x n x m when\n\
+m > 1), and @var{auc} the m areas under the ROC curves.\n\
+\n\
+If @var{summary} is true, @var{curves} is instead the m x 6 matrix of\n\
+the points of highest F1 of each row, and the full curves are not kept\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() < 3 or args.length() > 4 or nargout > 2)
+      throw (const char*)0;
+
+    // Check scores
+    if (not args(0).is_real_matrix() or args(0).is_sparse_type())
+      throw "scores should be a full matrix";
+    Matrix scores = args(0).matrix_value();
+    octave_idx_type n_rows = scores.rows();
+    octave_idx_type n_data = scores.columns();
+
+    // Check truth
+    if (not args(1).is_matrix_type() or args(1).rows() != 2 or
+        args(1).columns() != n_data)
+      throw "truth should be a 2 x n matrix with one column per score";
+    Matrix truth = args(1).matrix_value();
+
+    // Check sizes
+    if (not args(2).is_matrix_type() or args(2).numel() != 2)
+      throw "sizes should have two elements";
+    Matrix sizes = args(2).matrix_value();
+
+    // Summary?
+    bool summary = false;
+    if (args.length() > 3) {
+      if (not args(3).is_scalar_type())
+        throw "summary should be a boolean";
+      summary = args(3).bool_value();
+    }
+
+    // Output
+    octave_value curves_value;
+    ColumnVector auc(n_rows);
+    double*      curves  = 0;
+    double*      best    = 0;
+    if (summary) {
+      Matrix points(n_rows, N_CURVES);
+      best         = points.fortran_vec();
+      curves_value = points;
+    }
+    else if (n_rows == 1) {
+      Matrix points(N_CURVES, n_data);
+      curves         = points.fortran_vec();
+      curves_value   = points;
+    }
+    else {
+      NDArray points(dim_vector(N_CURVES, n_data, n_rows));
+      curves         = points.fortran_vec();
+      curves_value   = points;
+    }
+
+    // Find them
+    binary_curves(curves, best, auc.fortran_vec(), scores, truth,
+                  1.0 / sizes(0), 1.0 / sizes(1));
+
+    // Prepare output
+    result.resize(2);
+    result(0) = curves_value;
+    result(1) = auc;
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
@@ -174,8 +174,9 @@ cl_i     = cell(repeats);
 marg_i   = cell(repeats);
 sqrt_h_i = zeros(1, repeats);
 
-%% Accumulated NMI
-acc_nmi = 0;
+%% Hard labels of each element (while every clustering is hard)
+labels   = zeros(n_data, repeats);
+all_hard = true();
 
 %% For each element in the ensemble
 for i = 1 : repeats
@@ -194,17 +195,11 @@ for i = 1 : repeats
   ind_marg   = sum(ind_cl, 2) ./ n_data;
   ind_sqrt_h = sqrt(entropy(ind_marg));
 
-  %% Full!
-  %% ind_marg = full(ind_marg);
-
-  %% Compare to previous
-  for j = 1 : (i - 1)
-    %% Find nmi
-    n = nmi(cl_i{j}, marg_i{j}, sqrt_h_i(j), ind_cl, ind_marg, ind_sqrt_h);
-
-    %% Accumulate it
-    acc_nmi   += n;
-  endfor
+  %% Hard?
+  [ best_soft, best_cl ] = max(ind_cl, [], 1);
+  all_hard     = all_hard && all(full(best_soft) == 1) && ...
+                 all(full(sum(ind_cl, 1)) == 1);
+  labels(:, i) = best_cl';
 
   %% Store it
   cl_i{i}     = ind_cl;
@@ -212,6 +207,23 @@ for i = 1 : repeats
   sqrt_h_i(i) = ind_sqrt_h;
 endfor
 
+%% Accumulated NMI
+if all_hard
+  %% Every pair at once
+  sim     = clustering_similarity_matrix(labels);
+  acc_nmi = sum(sim(find(triu(ones(repeats), 1))));
+
+else
+  %% Soft clusterings use the average contingency tables
+  acc_nmi = 0;
+  for i = 1 : repeats
+    for j = 1 : (i - 1)
+      acc_nmi += nmi(cl_i{j}, marg_i{j}, sqrt_h_i(j), ...
+                     cl_i{i}, marg_i{i}, sqrt_h_i(i));
+    endfor
+  endfor
+endif
+
 %% Average
 n_pairs  = repeats * (repeats - 1) / 2;
 acc_nmi /= n_pairs;
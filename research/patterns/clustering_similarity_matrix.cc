@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <vector>
+
+#include <octave/oct.h>
+
+#include <stdint.h>
+
+// Tile size
+/* Number of clusterings on each side of a tile of pairs */
+static const octave_idx_type TILE_SIZE = 32;
+
+// Smallest table kept dense
+/* Tables with at most this many cells, or with at most as many cells
+   as points, are dense; larger ones are hashed */
+static const octave_idx_type MIN_DENSE_CELLS = 65536;
+
+
+/***************/
+/* Clusterings */
+/***************/
+
+// Densely relabelled clusterings
+struct dense_clusterings {
+  // Number of points and clusterings
+  octave_idx_type n_data;
+  octave_idx_type n_clusterings;
+
+  // Labels, in 0..k-1 (n_data x n_clusterings, column-major)
+  std::vector<octave_idx_type> labels;
+
+  // Number of clusters of each clustering
+  std::vector<octave_idx_type> k;
+
+  // Cluster sizes of each clustering (from offsets[c])
+  std::vector<double>          sizes;
+  std::vector<octave_idx_type> offsets;
+
+  // Entropy of each clustering
+  std::vector<double> entropies;
+};
+
+// Relabel the clusterings, and cache their marginals and entropies
+static void relabel(dense_clusterings& _cls, const Matrix& _labels) {
+  // Sizes
+  octave_idx_type n_data = _cls.n_data = _labels.rows();
+  octave_idx_type n_cls  = _cls.n_clusterings = _labels.columns();
+
+  // Room
+  _cls.labels   .resize(std::max(n_data * n_cls, octave_idx_type(1)));
+  _cls.k        .resize(n_cls);
+  _cls.offsets  .resize(n_cls + 1);
+  _cls.entropies.resize(n_cls);
+  _cls.offsets[0] = 0;
+
+  // Each clustering
+  std::vector<double> distinct(n_data);
+  for (octave_idx_type c = 0; c < n_cls; ++c) {
+    // Distinct labels
+    const double* column = _labels.data() + c * n_data;
+    distinct.assign(column, column + n_data);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()),
+                   distinct.end());
+    _cls.k[c] = distinct.size();
+
+    // Relabel
+    octave_idx_type* labels = &_cls.labels[c * n_data];
+    for (octave_idx_type i = 0; i < n_data; ++i)
+      labels[i] = std::lower_bound(distinct.begin(), distinct.end(),
+                                   column[i]) - distinct.begin();
+
+    // Sizes
+    _cls.offsets[c + 1] = _cls.offsets[c] + _cls.k[c];
+    _cls.sizes.resize(_cls.offsets[c + 1], 0.0);
+    double* sizes = &_cls.sizes[_cls.offsets[c]];
+    for (octave_idx_type i = 0; i < n_data; ++i)
+      sizes[labels[i]] += 1.0;
+
+    // Entropy
+    double entropy = 0.0;
+    for (octave_idx_type l = 0; l < _cls.k[c]; ++l)
+      entropy -= sizes[l] / n_data * std::log(sizes[l] / n_data);
+    _cls.entropies[c] = entropy;
+  }
+}
+
+
+/*******************/
+/* Pair Similarity */
+/*******************/
+
+// Contingency counts of one thread
+/* A dense table, and a hash of the non-empty cells keyed by
+   label_1 * k_2 + label_2, both cleared through the touched cells */
+struct contingency {
+  // Dense counts
+  std::vector<double> dense;
+
+  // Hash keys (-1 when empty) and counts
+  std::vector<int64_t> keys;
+  std::vector<double>  counts;
+
+  // Touched cells (dense or hash slots)
+  std::vector<octave_idx_type> touched;
+};
+
+// Hash slot of a key
+static inline octave_idx_type hash_slot(const std::vector<int64_t>& _keys,
+                                        int64_t _key) {
+  octave_idx_type mask = _keys.size() - 1;
+  octave_idx_type slot =
+    octave_idx_type((uint64_t(_key) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+  while (_keys[slot] != -1 and _keys[slot] != _key)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+// Normalized mutual information of two clusterings
+/* As in (Strehl & Ghosh, 2002) */
+static double pair_nmi(contingency& _table, const dense_clusterings& _cls,
+                       octave_idx_type _c1, octave_idx_type _c2) {
+  // Sizes
+  octave_idx_type n_data = _cls.n_data;
+  octave_idx_type k_2    = _cls.k[_c2];
+
+  // Labels and sizes
+  const octave_idx_type* labels_1 = &_cls.labels[_c1 * n_data];
+  const octave_idx_type* labels_2 = &_cls.labels[_c2 * n_data];
+  const double*          sizes_1  = &_cls.sizes[_cls.offsets[_c1]];
+  const double*          sizes_2  = &_cls.sizes[_cls.offsets[_c2]];
+
+  // Mutual information
+  double mi = 0.0;
+
+  // Dense or hashed?
+  double cells = double(_cls.k[_c1]) * k_2;
+  if (cells <= MIN_DENSE_CELLS or cells <= n_data) {
+    // Count
+    if (_table.dense.size() < size_t(cells))
+      _table.dense.resize(size_t(cells), 0.0);
+    for (octave_idx_type i = 0; i < n_data; ++i) {
+      octave_idx_type cell = labels_1[i] * k_2 + labels_2[i];
+      if (_table.dense[cell] == 0.0)
+        _table.touched.push_back(cell);
+      _table.dense[cell] += 1.0;
+    }
+
+    // Add and clear
+    for (size_t t = 0; t < _table.touched.size(); ++t) {
+      octave_idx_type cell = _table.touched[t];
+      double n = _table.dense[cell];
+      mi += n * std::log(n * n_data /
+                         (sizes_1[cell / k_2] * sizes_2[cell % k_2]));
+      _table.dense[cell] = 0.0;
+    }
+  }
+  else {
+    // Room for every point
+    octave_idx_type capacity = 1;
+    while (capacity < 2 * n_data)
+      capacity *= 2;
+    if (octave_idx_type(_table.keys.size()) < capacity) {
+      _table.keys  .assign(capacity, -1);
+      _table.counts.assign(capacity, 0.0);
+    }
+
+    // Count
+    for (octave_idx_type i = 0; i < n_data; ++i) {
+      int64_t key = int64_t(labels_1[i]) * k_2 + labels_2[i];
+      octave_idx_type slot = hash_slot(_table.keys, key);
+      if (_table.keys[slot] == -1) {
+        _table.keys[slot] = key;
+        _table.touched.push_back(slot);
+      }
+      _table.counts[slot] += 1.0;
+    }
+
+    // Add and clear
+    for (size_t t = 0; t < _table.touched.size(); ++t) {
+      octave_idx_type slot = _table.touched[t];
+      double n = _table.counts[slot];
+      mi += n * std::log(n * n_data /
+                         (sizes_1[_table.keys[slot] / k_2] *
+                          sizes_2[_table.keys[slot] % k_2]));
+      _table.keys  [slot] = -1;
+      _table.counts[slot] = 0.0;
+    }
+  }
+  _table.touched.clear();
+
+  // Normalize
+  return mi / n_data /
+    std::sqrt(_cls.entropies[_c1] * _cls.entropies[_c2]);
+}
+
+// Similarity of every pair
+/* Pairs are visited in tiles of TILE_SIZE x TILE_SIZE clusterings */
+static void similarity_matrix(Matrix& _sim, const dense_clusterings& _cls) {
+  // Sizes
+  octave_idx_type n_cls   = _cls.n_clusterings;
+  octave_idx_type n_tiles = (n_cls + TILE_SIZE - 1) / TILE_SIZE;
+
+  // Tiles on or above the diagonal
+  std::vector<octave_idx_type> tiles_1, tiles_2;
+  for (octave_idx_type t1 = 0; t1 < n_tiles; ++t1)
+    for (octave_idx_type t2 = t1; t2 < n_tiles; ++t2) {
+      tiles_1.push_back(t1);
+      tiles_2.push_back(t2);
+    }
+  octave_idx_type n_pairs = tiles_1.size();
+
+  // Output
+  double* sim = _sim.fortran_vec();
+
+#pragma omp parallel
+  {
+    // Thread tables
+    contingency table;
+
+#pragma omp for schedule(dynamic)
+    for (octave_idx_type p = 0; p < n_pairs; ++p) {
+      octave_idx_type end_1 = std::min((tiles_1[p] + 1) * TILE_SIZE, n_cls);
+      octave_idx_type end_2 = std::min((tiles_2[p] + 1) * TILE_SIZE, n_cls);
+      for (octave_idx_type c1 = tiles_1[p] * TILE_SIZE; c1 < end_1; ++c1)
+        for (octave_idx_type c2 = std::max(tiles_2[p] * TILE_SIZE, c1 + 1);
+             c2 < end_2; ++c2) {
+          double value = pair_nmi(table, _cls, c1, c2);
+          sim[c1 + c2 * n_cls] = value;
+          sim[c2 + c1 * n_cls] = value;
+        }
+    }
+  }
+
+  // Diagonal
+  for (octave_idx_type c = 0; c < n_cls; ++c)
+    sim[c + c * n_cls] = _cls.entropies[c] > 0.0 ? 1.0 : NAN;
+}
+
+
+/*******************/
+/* Octave-C++ Glue */
+/*******************/
+
+// Octave callback
+DEFUN_DLD(clustering_similarity_matrix, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{sim} ] =} clustering_similarity_matrix(@var{labels})\n\
+\n\
+Find the normalized mutual information between every pair of the\n\
+clusterings in the columns of the @var{labels} matrix (n x m).\n\
+\n\
+Labels may be any values; each clustering is relabelled densely first.\n\
+The diagonal is 1, or NaN for clusterings with a single cluster.\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() != 1 or nargout > 1)
+      throw (const char*)0;
+
+    // Check labels
+    if (not args(0).is_matrix_type() or args(0).is_sparse_type())
+      throw "labels should be a full matrix";
+
+    // Relabel
+    dense_clusterings cls;
+    relabel(cls, args(0).matrix_value());
+
+    // Find the similarities
+    Matrix sim(cls.n_clusterings, cls.n_clusterings, 0.0);
+    similarity_matrix(sim, cls);
+
+    // Prepare output
+    result.resize(1);
+    result(0) = sim;
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
@@ -0,0 +1,17 @@
+%% -*- mode: octave; -*-
+
+%% Get the state of all random generators, to be given back to
+%% set_all_seeds
+
+%% Author: Edgar Gonzalez
+
+%% Get all seeds
+function [ state ] = get_all_seeds()
+  %% Both generators of each one
+  %% (Only read, so nothing is drawn from any of them)
+  state             = struct();
+  state.rand_seed   = rand ("seed");
+  state.randn_seed  = randn("seed");
+  state.rand_state  = rand ("state");
+  state.randn_state = randn("state");
+endfunction
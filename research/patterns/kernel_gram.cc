@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <octave/oct.h>
+
+// Block size
+/* Number of source and target columns in each tile of the Gram matrix */
+static const octave_idx_type BLOCK_SIZE = 64;
+
+
+/***********/
+/* Kernels */
+/***********/
+
+// Squared euclidean distance
+struct sqdist_kernel {
+  // Radial
+  static const bool radial = true;
+
+  // Apply
+  double operator()(double _sq_dist) const {
+    return _sq_dist;
+  }
+};
+
+// RBF kernel
+/* exp(-gamma * | x - y |^2) */
+struct rbf_kernel {
+  // Radial
+  static const bool radial = true;
+
+  // Gamma
+  double gamma;
+
+  // Apply
+  double operator()(double _sq_dist) const {
+    return std::exp(-gamma * _sq_dist);
+  }
+};
+
+// Polynomial kernel
+/* (x \cdot y + heterogeneous)^degree */
+struct polynomial_kernel {
+  // Not radial
+  static const bool radial = false;
+
+  // Degree
+  double degree;
+
+  // Is the degree a small non-negative integer?
+  int int_degree;
+
+  // Heterogeneous term
+  double heterogeneous;
+
+  // Apply
+  double operator()(double _dot) const {
+    // Base
+    double base = _dot + heterogeneous;
+
+    // Non-integer degree
+    if (int_degree < 0)
+      return std::pow(base, degree);
+
+    // Exponentiation by squaring
+    double result = 1.0;
+    for (int e = int_degree; e; e >>= 1) {
+      if (e & 1)
+        result *= base;
+      base *= base;
+    }
+    return result;
+  }
+};
+
+
+/***********/
+/* Columns */
+/***********/
+
+// Dense columns
+class dense_columns {
+private:
+  // Data
+  const double* data_;
+
+  // Number of dimensions
+  octave_idx_type n_dims_;
+
+public:
+  // Constructor
+  dense_columns(const Matrix& _data) :
+    data_(_data.data()), n_dims_(_data.rows()) {
+  }
+
+  // Squared norm of a column
+  double norm(octave_idx_type _i) const {
+    const double* x_i = data_ + _i * n_dims_;
+    double sum = 0.0;
+    for (octave_idx_type d = 0; d < n_dims_; ++d)
+      sum += x_i[d] * x_i[d];
+    return sum;
+  }
+
+  // Load a column as a dense vector
+  /* Columns are already dense, so the scratch is not used */
+  const double* load(octave_idx_type _j, double* /* _scratch */) const {
+    return data_ + _j * n_dims_;
+  }
+
+  // Unload a column
+  void unload(octave_idx_type /* _j */, double* /* _scratch */) const {
+  }
+
+  // Dot product of a column with a loaded one
+  double dot(octave_idx_type _i, const double* _y) const {
+    const double* x_i = data_ + _i * n_dims_;
+    double sum = 0.0;
+#pragma omp simd reduction(+:sum)
+    for (octave_idx_type d = 0; d < n_dims_; ++d)
+      sum += x_i[d] * _y[d];
+    return sum;
+  }
+};
+
+// Sparse columns
+class sparse_columns {
+private:
+  // Arrays
+  const octave_idx_type* cidx_;
+  const octave_idx_type* ridx_;
+  const double*          nnz_;
+
+public:
+  // Constructor
+  sparse_columns(const SparseMatrix& _data) :
+    cidx_(_data.cidx()), ridx_(_data.ridx()), nnz_(_data.data()) {
+  }
+
+  // Squared norm of a column
+  double norm(octave_idx_type _i) const {
+    double sum = 0.0;
+    for (octave_idx_type p = cidx_[_i]; p < cidx_[_i + 1]; ++p)
+      sum += nnz_[p] * nnz_[p];
+    return sum;
+  }
+
+  // Load a column as a dense vector
+  /* Scattered into the (all zero) scratch */
+  const double* load(octave_idx_type _j, double* _scratch) const {
+    for (octave_idx_type p = cidx_[_j]; p < cidx_[_j + 1]; ++p)
+      _scratch[ridx_[p]] = nnz_[p];
+    return _scratch;
+  }
+
+  // Unload a column
+  /* Leave the scratch all zero again */
+  void unload(octave_idx_type _j, double* _scratch) const {
+    for (octave_idx_type p = cidx_[_j]; p < cidx_[_j + 1]; ++p)
+      _scratch[ridx_[p]] = 0.0;
+  }
+
+  // Dot product of a column with a loaded one
+  double dot(octave_idx_type _i, const double* _y) const {
+    double sum = 0.0;
+    for (octave_idx_type p = cidx_[_i]; p < cidx_[_i + 1]; ++p)
+      sum += nnz_[p] * _y[ridx_[p]];
+    return sum;
+  }
+};
+
+// Squared norms of every column
+template <typename Columns>
+static void column_norms(std::vector<double>& _norms, const Columns& _cols,
+                         octave_idx_type _n_data) {
+  _norms.resize(_n_data);
+#pragma omp parallel for schedule(static)
+  for (octave_idx_type j = 0; j < _n_data; ++j)
+    _norms[j] = _cols.norm(j);
+}
+
+
+/**********/
+/* Engine */
+/**********/
+
+// Fill the Gram matrix
+/* Works by tiles of BLOCK_SIZE x BLOCK_SIZE, applying the kernel to each
+   dot product (or squared distance) as soon as it is found, so the result
+   is the only n_src x n_tgt allocation. When symmetric, only the tiles on
+   or above the diagonal are found, and mirrored as they are written
+*/
+template <typename Kernel, typename SColumns, typename TColumns>
+static void kernel_gram(Matrix& _gram, const Kernel& _kernel,
+                        const SColumns& _src, octave_idx_type _n_src,
+                        const TColumns& _tgt, octave_idx_type _n_tgt,
+                        octave_idx_type _n_dims, bool _symmetric) {
+  // Resize the result
+  _gram.resize(_n_src, _n_tgt, 0.0);
+  if (_n_src == 0 or _n_tgt == 0)
+    return;
+
+  // Squared norms
+  std::vector<double> src_norms, tgt_norms;
+  if (Kernel::radial) {
+    column_norms(src_norms, _src, _n_src);
+    if (_symmetric)
+      tgt_norms = src_norms;
+    else
+      column_norms(tgt_norms, _tgt, _n_tgt);
+  }
+
+  // Number of blocks
+  octave_idx_type n_src_blocks = (_n_src + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  octave_idx_type n_tgt_blocks = (_n_tgt + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  // Raw arrays
+  /* Octave containers are not touched inside the parallel region */
+  double*       gram   = _gram.fortran_vec();
+  const double* s_norm = Kernel::radial ? &src_norms.front() : 0;
+  const double* t_norm = Kernel::radial ? &tgt_norms.front() : 0;
+
+#pragma omp parallel
+  {
+    // Thread-private scratch
+    std::vector<double> scratch(std::max(_n_dims, octave_idx_type(1)), 0.0);
+
+    // For each tile
+#pragma omp for collapse(2) schedule(dynamic)
+    for (octave_idx_type tb = 0; tb < n_tgt_blocks; ++tb) {
+      for (octave_idx_type sb = 0; sb < n_src_blocks; ++sb) {
+        // Below the diagonal?
+        if (_symmetric and sb > tb)
+          continue;
+
+        // Limits
+        octave_idx_type s_first = sb * BLOCK_SIZE;
+        octave_idx_type s_last  = std::min(s_first + BLOCK_SIZE, _n_src);
+        octave_idx_type t_first = tb * BLOCK_SIZE;
+        octave_idx_type t_last  = std::min(t_first + BLOCK_SIZE, _n_tgt);
+
+        // For each target column
+        for (octave_idx_type j = t_first; j < t_last; ++j) {
+          // Load it
+          const double* y_j = _tgt.load(j, &scratch.front());
+
+          // Within a diagonal tile, stop at the diagonal
+          octave_idx_type i_last =
+            (_symmetric and sb == tb) ? j + 1 : s_last;
+
+          // For each source column
+          for (octave_idx_type i = s_first; i < i_last; ++i) {
+            // Dot product
+            double value = _src.dot(i, y_j);
+
+            // Squared distance
+            if (Kernel::radial) {
+              if (_symmetric and i == j)
+                value = 0.0;
+              else
+                value = std::max(0.0, s_norm[i] + t_norm[j] - 2.0 * value);
+            }
+
+            // Apply the kernel
+            value = _kernel(value);
+
+            // Set it (twice, if symmetric)
+            gram[i + j * _n_src] = value;
+            if (_symmetric)
+              gram[j + i * _n_src] = value;
+          }
+
+          // Unload it
+          _tgt.unload(j, &scratch.front());
+        }
+      }
+    }
+  }
+}
+
+// Dispatch on the source and target types
+template <typename Kernel>
+static void kernel_gram(Matrix& _gram, const Kernel& _kernel,
+                        const octave_value& _source,
+                        const octave_value& _target, bool _symmetric) {
+  // Sizes
+  octave_idx_type n_dims = _source.rows();
+  octave_idx_type n_src  = _source.columns();
+  octave_idx_type n_tgt  = _target.columns();
+
+  // Sparse source?
+  if (_source.is_sparse_type()) {
+    SparseMatrix source = _source.sparse_matrix_value();
+    sparse_columns src(source);
+
+    // Sparse target?
+    if (_target.is_sparse_type()) {
+      SparseMatrix target = _target.sparse_matrix_value();
+      kernel_gram(_gram, _kernel, src, n_src, sparse_columns(target), n_tgt,
+                  n_dims, _symmetric);
+    }
+    else {
+      Matrix target = _target.matrix_value();
+      kernel_gram(_gram, _kernel, src, n_src, dense_columns(target), n_tgt,
+                  n_dims, _symmetric);
+    }
+  }
+  else {
+    Matrix source = _source.matrix_value();
+    dense_columns src(source);
+
+    // Sparse target?
+    if (_target.is_sparse_type()) {
+      SparseMatrix target = _target.sparse_matrix_value();
+      kernel_gram(_gram, _kernel, src, n_src, sparse_columns(target), n_tgt,
+                  n_dims, _symmetric);
+    }
+    else {
+      Matrix target = _target.matrix_value();
+      kernel_gram(_gram, _kernel, src, n_src, dense_columns(target), n_tgt,
+                  n_dims, _symmetric);
+    }
+  }
+}
+
+
+/*******************/
+/* Octave callback */
+/*******************/
+
+// Octave callback
+DEFUN_DLD(kernel_gram, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {@var{K} =} kernel_gram(@var{kind}, @var{params}, @var{source})\n\
+@deftypefnx {Loadable Function}\
+ {@var{K} =} kernel_gram(@var{kind}, @var{params}, @var{source},\
+ @var{target})\n\
+\n\
+Find the Gram matrix between the columns of @var{source} (and\n\
+@var{target}, or @var{source} itself if not given), applying the kernel\n\
+to each entry as it is computed.\n\
+\n\
+@var{kind} is one of @code{\"sqdist\"} (squared euclidean distance,\n\
+@var{params} ignored), @code{\"rbf\"} (@var{params} is gamma) or\n\
+@code{\"polynomial\"} (@var{params} is @code{[ degree, heterogeneous ]}).\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() < 3 or args.length() > 4 or nargout > 1)
+      throw (const char*)0;
+
+    // Check kind
+    if (not args(0).is_string())
+      throw "kind should be a string";
+
+    // Get kind
+    std::string kind = args(0).string_value();
+
+    // Check source
+    if (not args(2).is_matrix_type())
+      throw "source should be a matrix";
+
+    // Symmetric?
+    bool symmetric = args.length() == 3;
+
+    // Check target
+    if (not symmetric) {
+      if (not args(3).is_matrix_type())
+        throw "target should be a matrix";
+      if (args(3).rows() != args(2).rows())
+        throw "source and target should have the same number of rows";
+    }
+
+    // Source and target
+    const octave_value& source = args(2);
+    const octave_value& target = symmetric ? args(2) : args(3);
+
+    // Gram matrix
+    Matrix gram;
+
+    // Which kind?
+    if (kind == "sqdist") {
+      // Squared euclidean distance
+      kernel_gram(gram, sqdist_kernel(), source, target, symmetric);
+    }
+    else if (kind == "rbf") {
+      // Check params
+      if (not args(1).is_real_scalar())
+        throw "params should be the gamma of the RBF kernel";
+
+      // RBF
+      rbf_kernel kernel;
+      kernel.gamma = args(1).double_value();
+      kernel_gram(gram, kernel, source, target, symmetric);
+    }
+    else if (kind == "polynomial") {
+      // Check params
+      if (not args(1).is_matrix_type() or args(1).numel() != 2)
+        throw "params should be the degree and heterogeneous term of the "
+              "polynomial kernel";
+
+      // Get params
+      Matrix params = args(1).matrix_value();
+
+      // Polynomial
+      polynomial_kernel kernel;
+      kernel.degree        = params(0);
+      kernel.heterogeneous = params(1);
+      kernel.int_degree    =
+        (kernel.degree >= 0 and kernel.degree <= 64 and
+         kernel.degree == std::floor(kernel.degree)) ?
+        int(kernel.degree) : -1;
+      kernel_gram(gram, kernel, source, target, symmetric);
+    }
+    else {
+      throw "kind should be \"sqdist\", \"rbf\" or \"polynomial\"";
+    }
+
+    // Prepare output
+    result.resize(1);
+    result(0) = gram;
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
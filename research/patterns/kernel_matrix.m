@@ -10,11 +10,9 @@ function [ K, self_data ] = kernel_matrix(data, radial, kernel)
   if radial
     %% Radial kernel
     %% | x - y |^2 = x \cdot x + y \cdot y - 2 \cdot x \cdot y
-    K         = full(data' * data);
-    self_data = diag(K, 0);
-    n_data    = size(data, 2);
-    K         = kernel(self_data * ones(1, n_data) + ...
-                       ones(n_data, 1) * self_data' - 2 * K);
+    %% (found natively, filling only one n_data x n_data matrix)
+    self_data = full(sum(data .^ 2, 1))';
+    K         = kernel(kernel_gram("sqdist", [], data));
   else
     %% Non-radial kernel
     K         = kernel(full(data' * data));
@@ -0,0 +1,811 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <list>
+#include <vector>
+
+#include <octave/oct.h>
+#include <octave/ov-fcn.h>
+#include <octave/parse.h>
+
+
+/****************/
+/* Kernel cache */
+/****************/
+
+// Default cache size (MB)
+static const double DEFAULT_CACHE_SIZE = 100.0;
+
+// Default tolerance
+static const double DEFAULT_TOLERANCE = 1e-3;
+
+// Default maximum number of iterations, per sample
+/* Each iteration updates the whole gradient, so the default budget is
+   linear in the number of samples (and the total work quadratic), with
+   a floor for small problems */
+static const octave_idx_type DEFAULT_ITERATIONS_PER_SAMPLE = 100;
+static const octave_idx_type MIN_DEFAULT_ITERATIONS        = 10000;
+
+// Minimum curvature
+/* Used instead of non-positive second derivatives, as libsvm does */
+static const double TAU = 1e-12;
+
+// Dot products of a dense column with every column
+static void column_products(double* _prods, const Matrix& _data,
+                            octave_idx_type _i) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+
+  // Raw arrays
+  const double* data = _data.data();
+  const double* x_i  = data + _i * n_dims;
+
+  // For each column
+#pragma omp parallel for schedule(static)
+  for (octave_idx_type j = 0; j < n_data; ++j) {
+    const double* x_j = data + j * n_dims;
+    double dot = 0.0;
+    for (octave_idx_type d = 0; d < n_dims; ++d)
+      dot += x_i[d] * x_j[d];
+    _prods[j] = dot;
+  }
+}
+
+// Dot products of a sparse column with every column
+static void column_products(double* _prods, const SparseMatrix& _data,
+                            octave_idx_type _i) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+
+  // Raw arrays
+  const octave_idx_type* cidx = _data.cidx();
+  const octave_idx_type* ridx = _data.ridx();
+  const double*          nnz  = _data.data();
+
+  // Scatter column i
+  std::vector<double> x_i(n_dims, 0.0);
+  for (octave_idx_type p = cidx[_i]; p < cidx[_i + 1]; ++p)
+    x_i[ridx[p]] = nnz[p];
+
+  // For each column
+#pragma omp parallel for schedule(dynamic, 256)
+  for (octave_idx_type j = 0; j < n_data; ++j) {
+    double dot = 0.0;
+    for (octave_idx_type p = cidx[j]; p < cidx[j + 1]; ++p)
+      dot += x_i[ridx[p]] * nnz[p];
+    _prods[j] = dot;
+  }
+}
+
+// Squared norms of every dense column
+static void column_norms(std::vector<double>& _norms, const Matrix& _data) {
+  // Sizes
+  octave_idx_type n_dims = _data.rows();
+  octave_idx_type n_data = _data.columns();
+
+  // Sum the squares
+  const double* data = _data.data();
+  _norms.assign(n_data, 0.0);
+  for (octave_idx_type j = 0; j < n_data; ++j)
+    for (octave_idx_type d = 0; d < n_dims; ++d)
+      _norms[j] += data[d + j * n_dims] * data[d + j * n_dims];
+}
+
+// Squared norms of every sparse column
+static void column_norms(std::vector<double>& _norms,
+                         const SparseMatrix& _data) {
+  // Raw arrays
+  const octave_idx_type* cidx = _data.cidx();
+  const double*          nnz  = _data.data();
+
+  // Sum the squares
+  _norms.assign(_data.columns(), 0.0);
+  for (octave_idx_type j = 0; j < _data.columns(); ++j)
+    for (octave_idx_type p = cidx[j]; p < cidx[j + 1]; ++p)
+      _norms[j] += nnz[p] * nnz[p];
+}
+
+// Kernel columns
+/* Evaluates K(:, i) on demand, finding the raw dot products (or squared
+   distances, for radial kernels) natively and applying the kernel function
+   handle to the whole column at once. The most recently used columns are
+   kept within a memory budget
+*/
+template <typename DMatrix>
+class kernel_columns {
+private:
+  // Data
+  const DMatrix& data_;
+
+  // Is it radial?
+  bool radial_;
+
+  // Kernel function
+  octave_function* kernel_;
+
+  // Number of samples
+  octave_idx_type n_data_;
+
+  // Squared norms
+  std::vector<double> norms_;
+
+  // Diagonal
+  std::vector<double> diag_;
+
+  // Maximum number of cached columns
+  size_t max_columns_;
+
+  // Cached columns, most recent first
+  std::list<octave_idx_type> lru_;
+
+  // Position of each column in the LRU list
+  std::vector<std::list<octave_idx_type>::iterator> where_;
+
+  // Column contents (empty if not cached)
+  std::vector<std::vector<double> > columns_;
+
+  // Apply the kernel function in place
+  void apply(double* _values) const {
+    // Argument
+    ColumnVector arg(n_data_);
+    std::copy(_values, _values + n_data_, arg.fortran_vec());
+
+    // Call
+    octave_value_list k_args;
+    k_args.resize(1);
+    k_args(0) = arg;
+    octave_value_list res = feval(kernel_, k_args, 1);
+    if (res.length() < 1 or res(0).numel() != n_data_)
+      throw "kernel should return a value per element";
+
+    // Copy
+    Matrix values = res(0).matrix_value();
+    std::copy(values.data(), values.data() + n_data_, _values);
+  }
+
+public:
+  // Constructor
+  kernel_columns(const DMatrix& _data, bool _radial,
+                 octave_function* _kernel, double _cache_size) :
+    data_(_data), radial_(_radial), kernel_(_kernel),
+    n_data_(_data.columns()), where_(_data.columns()),
+    columns_(_data.columns()) {
+    // Budget
+    max_columns_ = std::max(size_t(2),
+                            size_t(_cache_size * 1048576.0 /
+                                   (sizeof(double) * n_data_)));
+
+    // Not cached
+    std::fill(where_.begin(), where_.end(), lru_.end());
+
+    // Norms
+    column_norms(norms_, data_);
+
+    // Diagonal
+    /* K(x, x) is the kernel of 0 for radial kernels */
+    if (radial_)
+      diag_.assign(n_data_, 0.0);
+    else
+      diag_ = norms_;
+    apply(&diag_.front());
+  }
+
+  // Diagonal
+  double diagonal(octave_idx_type _i) const {
+    return diag_[_i];
+  }
+
+  // Column
+  /* Valid until two more columns have been requested */
+  const double* column(octave_idx_type _i) {
+    // Cached?
+    if (where_[_i] != lru_.end()) {
+      lru_.splice(lru_.begin(), lru_, where_[_i]);
+      return &columns_[_i].front();
+    }
+
+    // Evict
+    if (lru_.size() >= max_columns_) {
+      octave_idx_type last = lru_.back();
+      std::vector<double>().swap(columns_[last]);
+      where_[last] = lru_.end();
+      lru_.pop_back();
+    }
+
+    // Find it
+    std::vector<double>& col = columns_[_i];
+    col.resize(n_data_);
+    column_products(&col.front(), data_, _i);
+    if (radial_) {
+      double norm_i = norms_[_i];
+      for (octave_idx_type j = 0; j < n_data_; ++j)
+        col[j] = norm_i + norms_[j] - 2.0 * col[j];
+    }
+    apply(&col.front());
+
+    // Keep it
+    lru_.push_front(_i);
+    where_[_i] = lru_.begin();
+
+    // Return it
+    return &col.front();
+  }
+};
+
+
+/**************/
+/* Binary SMO */
+/**************/
+
+// Binary SMO
+/* Solves min 1/2 a' Q a - sum(a) s.t. y' a = 0, 0 <= a <= C, with
+   Q_ij = y_i y_j K_ij, by sequential minimal optimization with the
+   second order working set selection of libsvm (no shrinking). C must
+   be finite. Returns whether it converged
+*/
+template <typename DMatrix>
+static bool kernel_svm_smo(std::vector<double>& _alpha, double& _b,
+                           double& _obj, octave_idx_type& _iter,
+                           kernel_columns<DMatrix>& _kernel,
+                           const std::vector<double>& _y, double _C,
+                           double _tolerance, octave_idx_type _max_iter) {
+  // Size
+  octave_idx_type n_data = _y.size();
+
+  // Start at alpha = 0, where the gradient is -1
+  _alpha.assign(n_data, 0.0);
+  std::vector<double> grad(n_data, -1.0);
+
+  // Iterate
+  bool converged = false;
+  for (_iter = 0; _iter < _max_iter; ++_iter) {
+    // First variable: max { -y_t G_t : t in I_up }
+    octave_idx_type i     = -1;
+    double          g_max = -INFINITY;
+    for (octave_idx_type t = 0; t < n_data; ++t) {
+      double yg = -_y[t] * grad[t];
+      bool up   = _y[t] > 0 ? _alpha[t] < _C : _alpha[t] > 0.0;
+      if (up and yg >= g_max) {
+        g_max = yg;
+        i     = t;
+      }
+    }
+
+    // Column of the first variable
+    const double* k_i = i == -1 ? 0 : _kernel.column(i);
+    double        d_i = i == -1 ? 0 : _kernel.diagonal(i);
+
+    // Second variable: most decrease of the objective within I_low
+    octave_idx_type j        = -1;
+    double          g_max2   = -INFINITY;
+    double          obj_best = INFINITY;
+    for (octave_idx_type t = 0; t < n_data; ++t) {
+      bool low = _y[t] > 0 ? _alpha[t] > 0.0 : _alpha[t] < _C;
+      if (not low)
+        continue;
+
+      double yg = _y[t] * grad[t];
+      if (yg >= g_max2)
+        g_max2 = yg;
+
+      double grad_diff = g_max + yg;
+      if (grad_diff > 0.0) {
+        double quad = d_i + _kernel.diagonal(t) - 2.0 * k_i[t];
+        double obj  = -(grad_diff * grad_diff) / (quad > 0.0 ? quad : TAU);
+        if (obj <= obj_best) {
+          j        = t;
+          obj_best = obj;
+        }
+      }
+    }
+
+    // Optimal?
+    if (g_max + g_max2 < _tolerance or j == -1) {
+      converged = true;
+      break;
+    }
+
+    // Column of the second variable
+    const double* k_j = _kernel.column(j);
+
+    // Old values
+    double old_ai = _alpha[i];
+    double old_aj = _alpha[j];
+
+    // Update the pair, clipping it to the box
+    double quad = d_i + _kernel.diagonal(j) - 2.0 * k_i[j];
+    if (quad <= 0.0)
+      quad = TAU;
+
+    if (_y[i] != _y[j]) {
+      double delta = (-grad[i] - grad[j]) / quad;
+      double diff  = _alpha[i] - _alpha[j];
+      _alpha[i] += delta;
+      _alpha[j] += delta;
+
+      if (diff > 0.0) {
+        if (_alpha[j] < 0.0) {
+          _alpha[j] = 0.0;
+          _alpha[i] = diff;
+        }
+      }
+      else {
+        if (_alpha[i] < 0.0) {
+          _alpha[i] = 0.0;
+          _alpha[j] = -diff;
+        }
+      }
+
+      if (diff > 0.0) {
+        if (_alpha[i] > _C) {
+          _alpha[i] = _C;
+          _alpha[j] = _C - diff;
+        }
+      }
+      else {
+        if (_alpha[j] > _C) {
+          _alpha[j] = _C;
+          _alpha[i] = _C + diff;
+        }
+      }
+    }
+    else {
+      double delta = (grad[i] - grad[j]) / quad;
+      double sum   = _alpha[i] + _alpha[j];
+      _alpha[i] -= delta;
+      _alpha[j] += delta;
+
+      if (sum > _C) {
+        if (_alpha[i] > _C) {
+          _alpha[i] = _C;
+          _alpha[j] = sum - _C;
+        }
+        if (_alpha[j] > _C) {
+          _alpha[j] = _C;
+          _alpha[i] = sum - _C;
+        }
+      }
+      else {
+        if (_alpha[j] < 0.0) {
+          _alpha[j] = 0.0;
+          _alpha[i] = sum;
+        }
+        if (_alpha[i] < 0.0) {
+          _alpha[i] = 0.0;
+          _alpha[j] = sum;
+        }
+      }
+    }
+
+    // Update the gradient
+    /* G_t += Q_ti delta_i + Q_tj delta_j */
+    double d_ai = (_alpha[i] - old_ai) * _y[i];
+    double d_aj = (_alpha[j] - old_aj) * _y[j];
+    for (octave_idx_type t = 0; t < n_data; ++t)
+      grad[t] += _y[t] * (k_i[t] * d_ai + k_j[t] * d_aj);
+  }
+
+  // Offset
+  /* Average y_t G_t over the free variables, or the middle of the
+     feasible range if there are none */
+  double          ub = INFINITY, lb = -INFINITY, sum_free = 0.0;
+  octave_idx_type n_free = 0;
+  for (octave_idx_type t = 0; t < n_data; ++t) {
+    double yg = _y[t] * grad[t];
+    if (_alpha[t] >= _C) {
+      if (_y[t] < 0) ub = std::min(ub, yg);
+      else           lb = std::max(lb, yg);
+    }
+    else if (_alpha[t] <= 0.0) {
+      if (_y[t] > 0) ub = std::min(ub, yg);
+      else           lb = std::max(lb, yg);
+    }
+    else {
+      ++n_free;
+      sum_free += yg;
+    }
+  }
+  _b = -(n_free > 0 ? sum_free / n_free : (ub + lb) / 2.0);
+
+  // Objective
+  /* 1/2 a' Q a - sum(a) = 1/2 a' (G - 1) */
+  _obj = 0.0;
+  for (octave_idx_type t = 0; t < n_data; ++t)
+    _obj += 0.5 * _alpha[t] * (grad[t] - 1.0);
+
+  // Done
+  return converged;
+}
+
+
+/**********************************/
+/* Crammer-Singer multiclass SVMs */
+/**********************************/
+
+// Solve the subproblem of a sample
+/* min 1/2 A sum_m t_m^2 + sum_m B_m t_m s.t. sum_m t_m = 0,
+   t_m <= C_m, with C_y = 1 and C_m = 0 otherwise (from LIBLINEAR)
+*/
+static void cs_subproblem(double* _tau, const double* _B, double _A,
+                          octave_idx_type _y, octave_idx_type _k) {
+  // Sorted shifted gradients
+  std::vector<double> D(_B, _B + _k);
+  D[_y] += _A;
+  std::sort(D.begin(), D.end(), std::greater<double>());
+
+  // Threshold
+  double          beta = D[0] - _A;
+  octave_idx_type r;
+  for (r = 1; r < _k and beta < r * D[r]; ++r)
+    beta += D[r];
+  beta /= r;
+
+  // Solution
+  for (octave_idx_type m = 0; m < _k; ++m)
+    _tau[m] = std::min(m == _y ? 1.0 : 0.0, (beta - _B[m]) / _A);
+}
+
+// Crammer-Singer decomposition
+/* Solves min 1/2 sum_ij K_ij tau_i' tau_j + beta sum_i sum_{m != y_i} tau_im
+   s.t. sum_m tau_im = 0, tau_im <= delta(y_i, m), updating on each step
+   the sample with the largest KKT violation. Returns whether it converged
+*/
+template <typename DMatrix>
+static bool kernel_svm_cs(Matrix& _tau, double& _obj, octave_idx_type& _iter,
+                          kernel_columns<DMatrix>& _kernel,
+                          const std::vector<octave_idx_type>& _y,
+                          octave_idx_type _k, double _beta,
+                          double _tolerance, octave_idx_type _max_iter) {
+  // Size
+  octave_idx_type n_data = _y.size();
+
+  // Start at tau = 0, where the gradient is the linear term
+  _tau.resize(_k, n_data, 0.0);
+  std::fill(_tau.fortran_vec(), _tau.fortran_vec() + _k * n_data, 0.0);
+  std::vector<double> grad(_k * n_data, _beta);
+  for (octave_idx_type i = 0; i < n_data; ++i)
+    grad[_y[i] + i * _k] = 0.0;
+
+  // Raw array
+  double* tau = _tau.fortran_vec();
+
+  // Buffers
+  std::vector<double> B(_k), t_new(_k), delta(_k);
+
+  // Iterate
+  bool converged = false;
+  for (_iter = 0; _iter < _max_iter; ++_iter) {
+    // Most violating sample
+    octave_idx_type i     = -1;
+    double          v_max = _tolerance;
+    for (octave_idx_type s = 0; s < n_data; ++s) {
+      const double* g_s = &grad[s * _k];
+      const double* t_s = tau + s * _k;
+      double g_hi = -INFINITY, g_lo = INFINITY;
+      for (octave_idx_type m = 0; m < _k; ++m) {
+        g_hi = std::max(g_hi, g_s[m]);
+        if (t_s[m] < (m == _y[s] ? 1.0 : 0.0))
+          g_lo = std::min(g_lo, g_s[m]);
+      }
+      if (g_hi - g_lo > v_max) {
+        v_max = g_hi - g_lo;
+        i     = s;
+      }
+    }
+
+    // Optimal?
+    if (i == -1) {
+      converged = true;
+      break;
+    }
+
+    // Solve the subproblem
+    double* t_i = tau + i * _k;
+    double  A   = std::max(_kernel.diagonal(i), TAU);
+    for (octave_idx_type m = 0; m < _k; ++m)
+      B[m] = grad[m + i * _k] - A * t_i[m];
+    cs_subproblem(&t_new.front(), &B.front(), A, _y[i], _k);
+
+    // Change
+    for (octave_idx_type m = 0; m < _k; ++m) {
+      delta[m] = t_new[m] - t_i[m];
+      t_i[m]   = t_new[m];
+    }
+
+    // Update the gradient
+    const double* k_i = _kernel.column(i);
+    for (octave_idx_type s = 0; s < n_data; ++s) {
+      double* g_s = &grad[s * _k];
+      for (octave_idx_type m = 0; m < _k; ++m)
+        g_s[m] += delta[m] * k_i[s];
+    }
+  }
+
+  // Objective
+  /* 1/2 tau' H tau + e' tau = 1/2 tau' (G + e) */
+  _obj = 0.0;
+  for (octave_idx_type s = 0; s < n_data; ++s)
+    for (octave_idx_type m = 0; m < _k; ++m)
+      _obj += 0.5 * tau[m + s * _k] *
+        (grad[m + s * _k] + (m == _y[s] ? 0.0 : _beta));
+
+  // Done
+  return converged;
+}
+
+
+/*************/
+/* Arguments */
+/*************/
+
+// Solver options
+struct smo_options {
+  // Cache size (MB)
+  double cache_size;
+
+  // Tolerance
+  double tolerance;
+
+  // Maximum number of iterations
+  octave_idx_type max_iter;
+};
+
+// Parse the common arguments
+/* data, radial, kernel, and then cache_size, tolerance and max_iter
+   starting at _first_opt */
+static void smo_args(const octave_value_list& _args, int _first_opt,
+                     bool& _radial, octave_function*& _kernel,
+                     smo_options& _opts) {
+  // Check data
+  if (not _args(0).is_matrix_type())
+    throw "data should be a matrix";
+  octave_idx_type n_data = _args(0).columns();
+
+  // Get radial
+  if (not _args(2).is_bool_scalar() and not _args(2).is_real_scalar())
+    throw "radial should be a logical scalar";
+  _radial = _args(2).bool_value();
+
+  // Get kernel
+  if (not _args(3).is_function_handle())
+    throw "kernel should be a function handle";
+  _kernel = _args(3).function_value();
+
+  // Options
+  _opts.cache_size = DEFAULT_CACHE_SIZE;
+  _opts.tolerance  = DEFAULT_TOLERANCE;
+  _opts.max_iter   = std::max(MIN_DEFAULT_ITERATIONS,
+                              DEFAULT_ITERATIONS_PER_SAMPLE * n_data);
+
+  if (_args.length() > _first_opt and not _args(_first_opt).is_empty()) {
+    _opts.cache_size = _args(_first_opt).scalar_value();
+    if (_opts.cache_size <= 0.0)
+      throw "cache_size should be positive";
+  }
+  if (_args.length() > _first_opt + 1 and
+      not _args(_first_opt + 1).is_empty()) {
+    _opts.tolerance = _args(_first_opt + 1).scalar_value();
+    if (_opts.tolerance <= 0.0)
+      throw "tolerance should be positive";
+  }
+  if (_args.length() > _first_opt + 2 and
+      not _args(_first_opt + 2).is_empty()) {
+    _opts.max_iter = octave_idx_type(_args(_first_opt + 2).scalar_value());
+    if (_opts.max_iter <= 0)
+      throw "max_iterations should be positive";
+  }
+}
+
+
+/*****************************/
+/* Binary kernel SVM via SMO */
+/*****************************/
+
+DEFUN_DLD(kernel_svm_smo, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{alpha}, @var{b}, @var{obj}, @var{iterations} ] =}\
+ kernel_svm_smo(@var{data}, @var{classes}, @var{radial}, @var{kernel}, @var{C},\
+ [@var{cache_size}, @var{tolerance}, @var{max_iterations}])\n\
+\n\
+Solve the dual of a binary kernel SVM with finite box constraint @var{C} by\n\
+sequential minimal optimization, given the +1/-1 @var{classes} of the\n\
+columns of @var{data} (hard margin problems should be solved with @code{qp}).\n\
+@var{kernel} is applied to the dot products (or the squared distances, if\n\
+@var{radial}) of a whole column at once, and up to @var{cache_size} MB of\n\
+kernel columns are cached. By default, at most\n\
+max(10000, 100 n_data) iterations are run\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() < 5 or args.length() > 8 or nargout > 4)
+      throw (const char*)0;
+
+    // Common arguments
+    bool             radial;
+    octave_function* kernel;
+    smo_options      opts;
+    smo_args(args, 5, radial, kernel, opts);
+
+    // Get classes
+    octave_idx_type n_data = args(0).columns();
+    if (not args(1).is_matrix_type() or args(1).rows() != 1 or
+        args(1).columns() != n_data)
+      throw "classes should be a row vector with one element per sample";
+    RowVector classes = args(1).row_vector_value();
+    std::vector<double> y(n_data);
+    for (octave_idx_type i = 0; i < n_data; ++i) {
+      if (classes(i) != 1.0 and classes(i) != -1.0)
+        throw "classes should be +1 or -1";
+      y[i] = classes(i);
+    }
+
+    // Get C
+    /* With an infinite C, the offset of a problem without free
+       variables is undefined, and a non-separable one never stops */
+    if (not args(4).is_real_scalar() or not (args(4).scalar_value() > 0.0) or
+        not std::isfinite(args(4).scalar_value()))
+      throw "C should be a positive finite scalar";
+    double C = args(4).scalar_value();
+
+    // Solve
+    std::vector<double> alpha;
+    double              b, obj;
+    octave_idx_type     iter;
+    bool                converged;
+    if (args(0).is_sparse_type()) {
+      SparseMatrix data = args(0).sparse_matrix_value();
+      kernel_columns<SparseMatrix> k_cols(data, radial, kernel,
+                                          opts.cache_size);
+      converged = kernel_svm_smo(alpha, b, obj, iter, k_cols, y, C,
+                                 opts.tolerance, opts.max_iter);
+    }
+    else {
+      Matrix data = args(0).matrix_value();
+      kernel_columns<Matrix> k_cols(data, radial, kernel, opts.cache_size);
+      converged = kernel_svm_smo(alpha, b, obj, iter, k_cols, y, C,
+                                 opts.tolerance, opts.max_iter);
+    }
+
+    // Warn
+    if (not converged)
+      warning("kernel_svm_smo: reached the maximum number of iterations");
+
+    // Alpha
+    RowVector alpha_out(n_data);
+    std::copy(alpha.begin(), alpha.end(), alpha_out.fortran_vec());
+
+    // Prepare output
+    result.resize(4);
+    result(0) = alpha_out;
+    result(1) = b;
+    result(2) = obj;
+    result(3) = double(iter);
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
+
+
+/******************************************/
+/* Multiclass kernel SVM (Crammer-Singer) */
+/******************************************/
+
+DEFUN_DLD(kernel_svm_cs, args, nargout,
+          "-*- texinfo -*-\n\
+@deftypefn {Loadable Function}\
+ {[ @var{tau}, @var{obj}, @var{iterations}, @var{converged} ] =}\
+ kernel_svm_cs(@var{data}, @var{classes}, @var{radial}, @var{kernel}, @var{C},\
+ [@var{cache_size}, @var{tolerance}, @var{max_iterations}])\n\
+\n\
+Solve the dual of a Crammer-Singer multiclass kernel SVM by decomposition,\n\
+given the k x n_data indicator matrix @var{classes}. @var{kernel},\n\
+@var{radial}, @var{cache_size} and @var{max_iterations} are as in\n\
+@code{kernel_svm_smo}\n\
+@end deftypefn") {
+  // Result
+  octave_value_list result;
+
+  try {
+    // Check the number of parameters
+    if (args.length() < 5 or args.length() > 8 or nargout > 4)
+      throw (const char*)0;
+
+    // Common arguments
+    bool             radial;
+    octave_function* kernel;
+    smo_options      opts;
+    smo_args(args, 5, radial, kernel, opts);
+
+    // Get classes
+    octave_idx_type n_data = args(0).columns();
+    if (not args(1).is_matrix_type() or args(1).columns() != n_data)
+      throw "classes should be a k x n_data indicator matrix";
+    SparseMatrix classes = args(1).sparse_matrix_value();
+    octave_idx_type k = classes.rows();
+
+    // Class of each sample
+    std::vector<octave_idx_type> y(n_data, -1);
+    for (octave_idx_type i = 0; i < n_data; ++i)
+      for (octave_idx_type p = classes.cidx(i); p < classes.cidx(i + 1); ++p)
+        if (classes.data(p) != 0.0) {
+          if (y[i] != -1)
+            throw "classes should have a single class per sample";
+          y[i] = classes.ridx(p);
+        }
+    for (octave_idx_type i = 0; i < n_data; ++i)
+      if (y[i] == -1)
+        throw "classes should have a single class per sample";
+
+    // Get C
+    if (not args(4).is_real_scalar() or args(4).scalar_value() <= 0.0)
+      throw "C should be a positive scalar";
+    double beta = 1.0 / args(4).scalar_value();
+
+    // Solve
+    Matrix          tau;
+    double          obj;
+    octave_idx_type iter;
+    bool            converged;
+    if (args(0).is_sparse_type()) {
+      SparseMatrix data = args(0).sparse_matrix_value();
+      kernel_columns<SparseMatrix> k_cols(data, radial, kernel,
+                                          opts.cache_size);
+      converged = kernel_svm_cs(tau, obj, iter, k_cols, y, k, beta,
+                                opts.tolerance, opts.max_iter);
+    }
+    else {
+      Matrix data = args(0).matrix_value();
+      kernel_columns<Matrix> k_cols(data, radial, kernel, opts.cache_size);
+      converged = kernel_svm_cs(tau, obj, iter, k_cols, y, k, beta,
+                                opts.tolerance, opts.max_iter);
+    }
+
+    // Warn
+    if (not converged)
+      warning("kernel_svm_cs: reached the maximum number of iterations");
+
+    // Prepare output
+    result.resize(4);
+    result(0) = tau;
+    result(1) = obj;
+    result(2) = double(iter);
+    result(3) = converged;
+  }
+  // Was there an error?
+  catch (const char* _error) {
+    // Display the error or the usage
+    if (_error)
+      error(_error);
+    else
+      print_usage();
+  }
+  // Was there an exception
+  catch (std::exception& _excep) {
+    // Display the error
+    error(_excep.what());
+  }
+
+  // Return the result
+  return result;
+}
@@ -62,6 +62,16 @@ function [ model, info, problem ] = multiclass_kernel_svm(data, classes, opts)
     opts.C = 1;
   endif
 
+  %% solver: "qp" or "smo" (native, kernel columns on demand)
+  if ~isfield(opts, "solver")
+    opts.solver = "qp";
+  endif
+
+  %% cache_size: kernel column cache of the smo solver (MB)
+  if ~isfield(opts, "cache_size")
+    opts.cache_size = 100;
+  endif
+
   %% beta is the inverse of C
   beta = 1 / opts.C;
 
@@ -74,40 +84,64 @@ function [ model, info, problem ] = multiclass_kernel_svm(data, classes, opts)
   %% Flatten the classes
   flat_classes = reshape(classes, n_vars, 1);
 
-  %% Kernel matrix
-  [ K, self_data ] = kernel_matrix(data, opts.radial, opts.kernel);
-
-  %% Objective function: Maximize
-  %% \frac{1}{2} \cdot -\sum_{i=1}^{n_data} \sum_{j=1}^{n_data}
-  %%   (\sum_{m=1}^{k} \tau_{im} \cdot \tau_{jm}) \cdot \K(x_i, x_j)
-  %% + \beta \cdot \sum_{i=1}^{n_data} \tau_{iy_i}
-  %% Or minimize the negated...
-  H = matrix_eyeblockize(K, n_classes);
-  f = -beta * full(flat_classes);
-
-  %% <- There used to be a bug here
-  %% H = matrix_blockize(K, n_classes, n_classes);
-
-  %% Subject to
-  %% \forall i, r \tau_{ir} \leq \delta(y_i, r)
-  lb = -inf * ones(n_vars, 1);
-  ub = full(flat_classes);
+  %% The smo solver only needs the matrices if the problem is returned
+  if strcmp(opts.solver, "qp") || nargout() > 2
+    %% Kernel matrix
+    K = kernel_matrix(data, opts.radial, opts.kernel);
+
+    %% Objective function: Maximize
+    %% \frac{1}{2} \cdot -\sum_{i=1}^{n_data} \sum_{j=1}^{n_data}
+    %%   (\sum_{m=1}^{k} \tau_{im} \cdot \tau_{jm}) \cdot \K(x_i, x_j)
+    %% + \beta \cdot \sum_{i=1}^{n_data} \tau_{iy_i}
+    %% Or minimize the negated...
+    H = matrix_eyeblockize(K, n_classes);
+    f = -beta * full(flat_classes);
+
+    %% <- There used to be a bug here
+    %% H = matrix_blockize(K, n_classes, n_classes);
+
+    %% Subject to
+    %% \forall i, r \tau_{ir} \leq \delta(y_i, r)
+    lb = -inf * ones(n_vars, 1);
+    ub = full(flat_classes);
+
+    %% \forall i \sum_{r=1}^{n_classes} \tau_{ir} = 0
+    Aeq = matrix_blockize(diag(ones(1, n_data)), 1, n_classes);
+    beq = zeros(n_data, 1);
+
+    %% No inequalities
+    Ain = zeros(0, n_classes * n_data);
+  endif
 
-  %% \forall i \sum_{r=1}^{n_classes} \tau_{ir} = 0
-  Aeq = matrix_blockize(diag(ones(1, n_data)), 1, n_classes);
-  beq = zeros(n_data, 1);
+  %% Optimize
+  if strcmp(opts.solver, "smo")
+    %% By decomposition, with the same solution
+    [ tau, fval, iterations, converged ] = ...
+        kernel_svm_cs(data, classes, opts.radial, opts.kernel, opts.C, ...
+                      opts.cache_size);
+    raw_tau = reshape(tau, n_vars, 1);
+
+    %% Information, as the one of quadprog_cgal
+    in_info            = struct();
+    in_info.iterations = iterations;
+    if converged
+      in_info.status   = "optimal";
+    else
+      in_info.status   = "max_iterations";
+    endif
 
-  %% No inequalities
-  Ain = zeros(0, n_classes * n_data);
+  elseif strcmp(opts.solver, "qp")
+    %% Should be: qp([], H, f, Aeq, beq, lb, ub, [], Ain, [])
+    %% but it just doesn't work... Buggy octave...
+    [ raw_tau, fval, in_info ] = ...
+        quadprog_cgal(H, f, Aeq, beq, [], [], lb, ub);
 
-  %% Optimize
-  %% Should be: qp([], H, f, Aeq, beq, lb, ub, [], Ain, [])
-  %% but it just doesn't work... Buggy octave...
-  [ raw_tau, fval, in_info ] = ...
-      quadprog_cgal(H, f, Aeq, beq, [], [], lb, ub);
+    %% Restructure tau
+    tau = reshape(raw_tau, n_classes, n_data);
 
-  %% Restructure tau
-  tau = reshape(raw_tau, n_classes, n_data);
+  else
+    usage("opts.solver must be \"qp\" or \"smo\"");
+  endif
 
   %% Keep those samples that have some tau different from zero
   SVs = find(any(tau));
@@ -125,7 +159,7 @@ function [ model, info, problem ] = multiclass_kernel_svm(data, classes, opts)
   %% A radial kernel?
   if model.radial
     %% Add self product and number of SVs
-    model.SV_self = self_data(SVs); % n_SV * 1
+    model.SV_self = full(sum(data(:, SVs) .^ 2, 1))'; % n_SV * 1
     model.n_SV    = size(model.SV, 1);
   endif
 
@@ -139,16 +173,18 @@ function [ model, info, problem ] = multiclass_kernel_svm(data, classes, opts)
   info.status     = in_info.status();
 
   %% Problem
-  problem      = struct();
-  problem.H    = H;
-  problem.f    = f;
-  problem.lb   = lb;
-  problem.ub   = ub;
-  problem.Aeq  = Aeq;
-  problem.beq  = beq;
-  problem.Ain  = Ain;
-  problem.bin  = 0;
-  problem.x    = raw_tau;
-  problem.fval = fval;
-  problem.info = in_info;
+  if nargout() > 2
+    problem      = struct();
+    problem.H    = H;
+    problem.f    = f;
+    problem.lb   = lb;
+    problem.ub   = ub;
+    problem.Aeq  = Aeq;
+    problem.beq  = beq;
+    problem.Ain  = Ain;
+    problem.bin  = 0;
+    problem.x    = raw_tau;
+    problem.fval = fval;
+    problem.info = in_info;
+  endif
 endfunction
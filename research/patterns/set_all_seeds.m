@@ -1,12 +1,25 @@
 %% -*- mode: octave; -*-
 
 %% Set a single seed to all random generators
+%% (Or give them back the state found by get_all_seeds)
 
 %% Author: Edgar Gonzàlez i Pellicer
 
 %% Set all seeds
 function set_all_seeds(seed)
-  %% Set each one
-  rand ("seed", seed);
-  randn("seed", seed);
+  %% A saved state?
+  if isstruct(seed)
+    %% Both generators of each one
+    %% (The seeded ones last, so that they are left in use, as a
+    %% numeric seed leaves them)
+    rand ("state", seed.rand_state);
+    randn("state", seed.randn_state);
+    rand ("seed",  seed.rand_seed);
+    randn("seed",  seed.randn_seed);
+
+  else
+    %% Set each one
+    rand ("seed", seed);
+    randn("seed", seed);
+  endif
 endfunction
@@ -0,0 +1,77 @@
+%% -*- mode: octave; -*-
+
+%% binary_curves against the previous Octave implementation test
+%% (the curves of binary_evaluation_curves, and the trapezoidal ROC
+%% area andoRoc found from them)
+
+%% Path
+addpath ..
+
+%% Previous curves
+function curves = old_curves(scores, truth, sizes)
+  [ sorted_scores, sorted_indices ] = sort(scores, 'descend');
+  accum  = full(cumsum(truth(:, sorted_indices), 2));
+  total  = sum(accum, 1);
+  roc    = diag(1 ./ sizes) * accum;
+  prc    = accum(2,:) ./ total;
+  f1            = 2 * (prc .* roc(2,:)) ./ (prc .+ roc(2,:));
+  f1(isnan(f1)) = 0.0;
+  curves = [ total ; roc ; prc ; f1 ; sorted_scores ];
+endfunction
+
+%% Previous area
+function auc = old_auc(curves)
+  n_data = columns(curves);
+  auc    = sum(diff(curves(2,:)) .* ...
+               (curves(3, 1 : n_data - 1) + curves(3, 2 : n_data))) / 2;
+endfunction
+
+%% Check a set of score rows against a truth
+function check(scores, s_truth)
+  tol    = 1e-12;
+  n_rows = rows(scores);
+  truth  = double([ ~s_truth ; s_truth ]);
+  sizes  = [ sum(~s_truth), sum(s_truth) ];
+
+  %% Full curves, and the point of highest F1
+  [ curves,  auc  ] = binary_curves(scores, truth, sizes);
+  [ summary, auc2 ] = binary_curves(scores, truth, sizes, true());
+  assert(auc2, auc);
+  assert(size(summary), [ n_rows, 6 ]);
+
+  for r = 1 : n_rows
+    old = old_curves(scores(r,:), truth, sizes);
+    assert(curves(:,:,r), old, tol);
+    assert(auc(r), old_auc(old), tol);
+
+    [ best_f1, best ] = max(old(5,:));
+    assert(summary(r,:), old(:, best)', tol);
+  endfor
+endfunction
+
+%% Random scores and truth
+rand("seed", 19);
+n_data  = 300;
+s_truth = rand(1, n_data) < 0.3;
+scores  = rand(4, n_data);
+check(scores, s_truth);
+
+%% Many ties, and some NaN scores
+ties          = round(4 * scores) / 4;
+ties(2, 1:10) = NaN;
+check(ties, s_truth);
+
+%% A single row gives a 6 x n matrix
+[ curves, auc ] = binary_curves(ties(1,:), double([ ~s_truth ; s_truth ]), ...
+                                [ sum(~s_truth), sum(s_truth) ]);
+assert(size(curves), [ 6, n_data ]);
+
+%% Every score the same
+check(zeros(2, n_data), s_truth);
+
+%% All positive and all negative truth
+check(ties, true(1, n_data));
+check(ties, false(1, n_data));
+
+%% Display
+printf("binary_curves: OK\n");
@@ -0,0 +1,118 @@
+%% -*- mode: octave; -*-
+
+%% clustering_similarity_matrix against the clusteringSimilarity.m loop test
+%% Every entry is the NMI that the interpreted loop finds from the
+%% cluster indicator matrices, single-cluster clusterings giving NaN
+
+%% Octopus
+pkg load octopus
+
+%% Path
+addpath ..
+
+%% Tolerance
+tol = 1e-10;
+
+%% Entropy, as in clusteringSimilarity.m
+function [ e ] = entropy(marg)
+  %% Find it
+  e = full(-sum(marg .* log(marg)));
+endfunction
+
+%% Normalized mutual information, as in clusteringSimilarity.m
+function [ value ] = nmi(cl_1, marg_1, sqrt_h_1, cl_2, marg_2, sqrt_h_2)
+  %% Size
+  [ k_1, n_data ] = size(cl_1);
+  [ k_2, n_data ] = size(cl_2);
+
+  %% Average contingency table
+  act = (cl_1 * cl_2') / n_data;
+
+  %% Mutual information
+  mi = sum(sum(act .* log(act ./ ((marg_1 * ones(1, k_2)) .* ...
+                                  (ones(k_1, 1) * marg_2')))));
+
+  %% Normalize
+  value = full(mi) / sqrt_h_1 / sqrt_h_2;
+endfunction
+
+%% Every pair through the loop, from the sparse indicator matrices
+function [ sim ] = loop_similarity(labels)
+  %% Sizes
+  [ n_data, repeats ] = size(labels);
+
+  %% Indicators, marginals and entropies
+  cl_i     = cell(repeats);
+  marg_i   = cell(repeats);
+  sqrt_h_i = zeros(1, repeats);
+  for i = 1 : repeats
+    [ values, first, dense ] = unique(labels(:, i));
+    cl_i{i}     = sparse(dense(:)', 1 : n_data, ones(1, n_data), ...
+                         length(values), n_data);
+    marg_i{i}   = sum(cl_i{i}, 2) ./ n_data;
+    sqrt_h_i(i) = sqrt(entropy(marg_i{i}));
+  endfor
+
+  %% Pairs
+  sim = zeros(repeats);
+  for i = 1 : repeats
+    sim(i, i) = nmi(cl_i{i}, marg_i{i}, sqrt_h_i(i), ...
+                    cl_i{i}, marg_i{i}, sqrt_h_i(i));
+    for j = 1 : (i - 1)
+      sim(j, i) = nmi(cl_i{j}, marg_i{j}, sqrt_h_i(j), ...
+                      cl_i{i}, marg_i{i}, sqrt_h_i(i));
+      sim(i, j) = sim(j, i);
+    endfor
+  endfor
+endfunction
+
+%% 40 clusterings of 600 points, more than one tile of pairs
+%% Some have many clusters, so their pairs use the hashed tables
+rand("seed", 48);
+n_data = 600;
+sizes  = [ 2, 3, 5, 8, 13, 40, 250, 300 ](1 + mod(0 : 39, 8));
+labels = floor(rand(n_data, 40) * diag(sizes));
+
+%% Arbitrary label values
+labels(:, 3) = 1000 * labels(:, 3) - 7;
+labels(:, 4) = -labels(:, 4) / 4;
+
+%% Two clusterings with a single cluster
+labels(:, 10) = 5;
+labels(:, 25) = -1;
+
+%% The same matrix
+sim = clustering_similarity_matrix(labels);
+ref = loop_similarity(labels);
+assert(sim, sim');
+assert(sim, ref, tol);
+
+%% Its diagonal is 1, or NaN for the single-cluster clusterings
+single_cl = [ 10, 25 ];
+assert(isnan(diag(sim)), ismember((1 : 40)', single_cl));
+assert(diag(sim)(setdiff(1 : 40, single_cl)), ones(38, 1), tol);
+assert(all(all(isnan(sim(single_cl, :)))));
+assert(all(all(isnan(sim(:, single_cl)))));
+
+%% The accumulated NMI of clusteringSimilarity.m, without them
+hard    = labels(:, setdiff(1 : 40, single_cl));
+sim     = clustering_similarity_matrix(hard);
+ref     = loop_similarity(hard);
+acc_nmi = sum(sim(find(triu(ones(38), 1))));
+acc_ref = 0;
+for i = 1 : 38
+  for j = 1 : (i - 1)
+    acc_ref += ref(j, i);
+  endfor
+endfor
+assert(acc_nmi, acc_ref, tol * 38 * 37 / 2);
+
+%% Identical and relabelled clusterings are fully similar
+assert(clustering_similarity_matrix([ hard(:, 5), 3 * hard(:, 5) + 1 ]), ...
+       ones(2), tol);
+
+%% Sparse labels are rejected
+fail("clustering_similarity_matrix(sparse(labels))");
+
+%% Display
+printf("clustering_similarity_matrix: OK\n");
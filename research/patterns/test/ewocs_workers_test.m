@@ -0,0 +1,47 @@
+%% -*- mode: octave; -*-
+
+%% EWOCS with one and several workers test
+%% Every member is seeded from the ensemble seed and its index, so the
+%% scores do not depend on the number of workers
+
+%% Octopus
+pkg load octopus
+
+%% Path
+addpath ..
+
+%% Two blobs and some noise
+rand("seed", 13);
+data = [ 0.1 * rand(2, 40), 0.1 * rand(2, 40) + 0.6, rand(2, 20) ];
+
+%% Clusterer
+clusterer = Voronoi(SqEuclideanDistance(), struct("soft_alpha", 1.0));
+
+%% The same ensemble, run here and on three workers
+opts               = struct();
+opts.ensemble_size = 10;
+opts.min_clusters  = 2;
+opts.max_clusters  = 8;
+opts.seed          = 1234;
+
+opts.workers = 1;
+scores_1     = score(EWOCS(clusterer, opts), data);
+
+opts.workers = 3;
+scores_3     = score(EWOCS(clusterer, opts), data);
+
+assert(scores_3, scores_1);
+
+%% The caller's generators are given back, running here and on workers
+for workers = [ 1, 3 ]
+  opts.workers = workers;
+  set_all_seeds(77);
+  expected = [ rand(1, 3), randn(1, 3) ];
+
+  set_all_seeds(77);
+  score(EWOCS(clusterer, opts), data);
+  assert([ rand(1, 3), randn(1, 3) ], expected);
+endfor
+
+%% Display
+printf("EWOCS workers: OK\n");
@@ -0,0 +1,70 @@
+%% -*- mode: octave; -*-
+
+%% kernel_gram against the interpreted formulas test
+
+%% Octopus
+pkg load octopus
+
+%% Path
+addpath ..
+
+%% Tolerance
+tol = 1e-10;
+
+%% Squared euclidean distances, as the removed helpers found them
+function D = old_sqdist(source, target)
+  s_norm = full(sum(source .^ 2, 1))';
+  t_norm = full(sum(target .^ 2, 1));
+  D      = full(s_norm * ones(1, columns(target)) + ...
+                ones(columns(source), 1) * t_norm - 2 * source' * target);
+endfunction
+
+%% Sizes that are not multiples of the 64 x 64 tiles
+rand("seed", 37);
+n_dims   = 7;
+source   = rand(n_dims, 131) - 0.5;
+target   = rand(n_dims, 70)  - 0.5;
+s_sparse = sparse(source .* (rand(size(source)) < 0.3));
+t_sparse = sparse(target .* (rand(size(target)) < 0.3));
+
+%% Every combination of dense and sparse source and target
+for s = { source, s_sparse }
+  for t = { target, t_sparse }
+    S = s{1}; T = t{1};
+
+    %% Squared distance, RBF and polynomial
+    assert(kernel_gram("sqdist", [], S, T), old_sqdist(S, T), tol);
+    assert(kernel_gram("rbf", 0.7, S, T), exp(-0.7 * old_sqdist(S, T)), tol);
+    assert(kernel_gram("polynomial", [ 3, 1 ], S, T), ...
+           full(S' * T + 1) .^ 3, tol);
+    assert(kernel_gram("polynomial", [ 2, 0 ], S, T), ...
+           full(S' * T) .^ 2, tol);
+
+    %% The kernel objects
+    assert(apply(RBFKernel(0.7), S, T), exp(-0.7 * old_sqdist(S, T)), tol);
+    assert(apply(PolynomialKernel(3, 1), S, T), full(S' * T + 1) .^ 3, tol);
+  endfor
+
+  %% The symmetric self case
+  S = s{1};
+  D = kernel_gram("sqdist", [], S);
+  assert(D, old_sqdist(S, S), tol);
+  assert(D, D');
+  assert(diag(D), zeros(columns(S), 1));
+  assert(kernel_gram("rbf", 0.7, S), exp(-0.7 * old_sqdist(S, S)), tol);
+  assert(kernel_gram("polynomial", [ 3, 1 ], S), full(S' * S + 1) .^ 3, tol);
+  assert(apply(RBFKernel(0.7), S), exp(-0.7 * old_sqdist(S, S)), tol);
+
+  %% kernel_matrix, with the radial and the plain kernel
+  kernel = @(x) exp(-x);
+  [ K, self_data ] = kernel_matrix(S, true, kernel);
+  assert(K, kernel(old_sqdist(S, S)), tol);
+  assert(self_data, full(sum(S .^ 2, 1))', tol);
+  assert(kernel_matrix(S, false, kernel), kernel(full(S' * S)), tol);
+endfor
+
+%% Mismatched dimensions are rejected
+fail("kernel_gram(\"sqdist\", [], source, target(1 : 3, :))");
+
+%% Display
+printf("kernel_gram: OK\n");
@@ -0,0 +1,58 @@
+%% -*- mode: octave; -*-
+
+%% SMO against QP kernel SVM test
+
+%% Octopus
+pkg load octopus
+
+%% Path
+addpath ..
+
+%% Three overlapping classes
+rand("seed", 11);
+n_data  = 60;
+classes = 1 + mod(0 : n_data - 1, 3);
+data    = rand(2, n_data) + 0.5 * [ classes ; classes ];
+
+%% Kernel
+kernel = @(x) exp(-x);
+
+%% Tolerances (the smo solver stops at a 1e-3 KKT violation)
+obj_tol = 1e-3;
+x_tol   = 5e-2;
+
+%% Multiclass, with both solvers
+opts        = struct();
+opts.radial = true();
+opts.kernel = kernel;
+opts.C      = 1;
+opts.solver = "qp";
+[ model_qp,  info_qp,  problem_qp  ] = ...
+    multiclass_kernel_svm(data, classes, opts);
+opts.solver = "smo";
+[ model_smo, info_smo, problem_smo ] = ...
+    multiclass_kernel_svm(data, classes, opts);
+
+%% They agree
+assert(info_smo.status, "optimal");
+assert(info_smo.obj, info_qp.obj, obj_tol * abs(info_qp.obj));
+assert(problem_smo.x, problem_qp.x, x_tol);
+assert(problem_smo.H, problem_qp.H);
+assert(fieldnames(problem_smo), fieldnames(problem_qp));
+
+%% Binary, soft margin, against qp
+y = 2 * (classes == 1) - 1;
+C = 1;
+K = kernel_matrix(data, true, kernel);
+[ alpha_qp, fval_qp ] = ...
+    qp([], (y' * y) .* K, -ones(n_data, 1), y, 0, ...
+       zeros(n_data, 1), C * ones(n_data, 1));
+[ alpha_smo, b_smo, fval_smo ] = kernel_svm_smo(data, y, true, kernel, C);
+assert(fval_smo, fval_qp, obj_tol * abs(fval_qp));
+assert(alpha_smo', alpha_qp, x_tol);
+
+%% Hard margin is left to qp
+fail("kernel_svm_smo(data, y, true, kernel, Inf)");
+
+%% Display
+printf("kernel_svm_smo against qp: OK\n");